@@ -0,0 +1,31 @@
+AC_ARG_ENABLE([zlib],
+              [AS_HELP_STRING([--enable-zlib=@<:@auto/yes/no@:>@],
+                              [Use zlib to compress GridFS chunks.])],
+              [],
+              [enable_zlib=auto])
+
+zlib_mode=no
+
+AS_IF([test "$enable_zlib" != "no"],[
+  PKG_CHECK_MODULES(ZLIB, [zlib], [zlib_mode=zlib], [
+    AC_CHECK_LIB([z],[compress2],[have_zlib_lib=yes],[have_zlib_lib=no])
+    AC_CHECK_HEADER([zlib.h],[have_zlib_headers=yes],[have_zlib_headers=no])
+
+    if test "$have_zlib_lib" = "yes" -a "$have_zlib_headers" = "yes" ; then
+      zlib_mode=zlib
+      ZLIB_LIBS=-lz
+    elif test "$enable_zlib" = "yes" ; then
+      AC_MSG_ERROR([You must install the zlib library and development headers to enable zlib support.])
+    fi
+  ])
+])
+
+AC_SUBST(ZLIB_CFLAGS)
+AC_SUBST(ZLIB_LIBS)
+
+dnl Let mongoc-config.h.in know about zlib status.
+if test "$zlib_mode" != "no" ; then
+  AC_SUBST(MONGOC_ENABLE_COMPRESSION_ZLIB, 1)
+else
+  AC_SUBST(MONGOC_ENABLE_COMPRESSION_ZLIB, 0)
+fi
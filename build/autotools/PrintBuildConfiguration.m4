@@ -49,6 +49,7 @@ Build configuration:
   Shared memory performance counters               : ${enable_shm_counters}
   SASL                                             : ${sasl_mode}
   SSL                                              : ${enable_ssl}
+  Zlib                                             : ${zlib_mode}
   Libbson                                          : ${with_libbson}${enable_experimental_text}
 
 Documentation:
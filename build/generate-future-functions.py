@@ -53,6 +53,7 @@ typedef_list = [
     typedef("char_ptr", "char *"),
     typedef("char_ptr_ptr", "char **"),
     typedef("int", None),
+    typedef("int32_t", None),
     typedef("int64_t", None),
     typedef("size_t", None),
     typedef("ssize_t", None),
@@ -71,6 +72,10 @@ typedef_list = [
 
     # libmongoc.
     typedef("mongoc_bulk_operation_ptr", "mongoc_bulk_operation_t *"),
+    typedef("mongoc_bulk_writer_ptr", "mongoc_bulk_writer_t *"),
+    typedef("mongoc_change_stream_ptr", "mongoc_change_stream_t *"),
+    typedef("mongoc_client_async_ptr", "mongoc_client_async_t *"),
+    typedef("mongoc_client_pool_ptr", "mongoc_client_pool_t *"),
     typedef("mongoc_client_ptr", "mongoc_client_t *"),
     typedef("mongoc_collection_ptr", "mongoc_collection_t *"),
     typedef("mongoc_cursor_ptr", "mongoc_cursor_t *"),
@@ -88,6 +93,7 @@ typedef_list = [
     typedef("const_mongoc_find_and_modify_opts_ptr", "const mongoc_find_and_modify_opts_t *"),
     typedef("const_mongoc_read_prefs_ptr", "const mongoc_read_prefs_t *"),
     typedef("const_mongoc_write_concern_ptr", "const mongoc_write_concern_t *"),
+    typedef("const_uint32_t_ptr", "const uint32_t *"),
 ]
 
 type_list = [T.name for T in typedef_list]
@@ -107,6 +113,27 @@ future_functions = [
                      param("bson_ptr", "reply"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("bool",
+                    "mongoc_bulk_writer_flush",
+                    [param("mongoc_bulk_writer_ptr", "writer"),
+                     param("bson_error_ptr", "error")]),
+
+    future_function("bool",
+                    "mongoc_client_async_run",
+                    [param("mongoc_client_async_ptr", "async"),
+                     param("int32_t", "timeout_msec")]),
+
+    future_function("bool",
+                    "mongoc_client_command_scatter",
+                    [param("mongoc_client_ptr", "client"),
+                     param("const_char_ptr", "db_name"),
+                     param("const_bson_ptr", "command"),
+                     param("const_mongoc_read_prefs_ptr", "read_prefs"),
+                     param("const_uint32_t_ptr", "server_ids"),
+                     param("size_t", "n_server_ids"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("bool",
                     "mongoc_client_command_simple",
                     [param("mongoc_client_ptr", "client"),
@@ -116,6 +143,15 @@ future_functions = [
                      param("bson_ptr", "reply"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("bool",
+                    "mongoc_client_pool_command_simple",
+                    [param("mongoc_client_pool_ptr", "pool"),
+                     param("const_char_ptr", "db_name"),
+                     param("const_bson_ptr", "command"),
+                     param("const_mongoc_read_prefs_ptr", "read_prefs"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("void",
                     "mongoc_client_kill_cursor",
                     [param("mongoc_client_ptr", "client"),
@@ -204,6 +240,15 @@ future_functions = [
                     [param("mongoc_cursor_ptr", "cursor"),
                      param("const_bson_ptr_ptr", "doc")]),
 
+    future_function("void",
+                    "mongoc_change_stream_destroy",
+                    [param("mongoc_change_stream_ptr", "stream")]),
+
+    future_function("bool",
+                    "mongoc_change_stream_next",
+                    [param("mongoc_change_stream_ptr", "stream"),
+                     param("const_bson_ptr_ptr", "doc")]),
+
     future_function("char_ptr_ptr",
                     "mongoc_client_get_database_names",
                     [param("mongoc_client_ptr", "client"),
@@ -0,0 +1,75 @@
+#include <bson.h>
+#include <mongoc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static void
+print_bson (const bson_t *b)
+{
+   char *str;
+
+   str = bson_as_json (b, NULL);
+   fprintf (stdout, "%s\n", str);
+   bson_free (str);
+}
+
+
+int
+main (int   argc,
+      char *argv[])
+{
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_change_stream_t *stream;
+   const bson_t *doc;
+   bson_error_t error;
+   bson_t *pipeline;
+   bson_t *opts;
+
+   if (argc != 4) {
+      fprintf (stderr, "usage: %s MONGO_URI DB COLLECTION\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_init ();
+
+   client = mongoc_client_new (argv[1]);
+   if (!client) {
+      fprintf (stderr, "Invalid URI: \"%s\"\n", argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   collection = mongoc_client_get_collection (client, argv[2], argv[3]);
+
+   /* only inserts, with large batches and up to a second of waiting */
+   pipeline = BCON_NEW ("pipeline", "[",
+                           "{", "$match", "{",
+                              "operationType", BCON_UTF8 ("insert"),
+                           "}", "}",
+                        "]");
+   opts = BCON_NEW ("batchSize", BCON_INT32 (1000),
+                    "maxAwaitTimeMS", BCON_INT32 (1000));
+
+   stream = mongoc_collection_watch (collection, pipeline, opts);
+
+   /* the stream resumes by itself after a network error or a failover;
+    * mongoc_change_stream_next returns false when it has nothing new */
+   while (!mongoc_change_stream_error (stream, &error)) {
+      if (mongoc_change_stream_next (stream, &doc)) {
+         print_bson (doc);
+      }
+   }
+
+   fprintf (stderr, "%s\n", error.message);
+
+   mongoc_change_stream_destroy (stream);
+   bson_destroy (opts);
+   bson_destroy (pipeline);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+
+   mongoc_cleanup ();
+
+   return EXIT_FAILURE;
+}
@@ -49,10 +49,9 @@ mongoc_dump_collection (mongoc_client_t *client,
 {
    mongoc_collection_t *col;
    mongoc_cursor_t *cursor;
-   const bson_t *doc;
+   mongoc_stream_t *stream;
    bson_error_t error;
    bson_t query = BSON_INITIALIZER;
-   FILE *stream;
    char *path;
    int ret = EXIT_SUCCESS;
 
@@ -67,7 +66,8 @@ mongoc_dump_collection (mongoc_client_t *client,
    }
 #endif
 
-   stream = fopen (path, "w");
+   stream = mongoc_stream_file_new_for_path (
+      path, O_WRONLY | O_CREAT | O_TRUNC, 0640);
    if (!stream) {
       fprintf (stderr, "Failed to open \"%s\", aborting.\n", path);
       exit (EXIT_FAILURE);
@@ -77,23 +77,14 @@ mongoc_dump_collection (mongoc_client_t *client,
    cursor = mongoc_collection_find (col, MONGOC_QUERY_NONE, 0, 0, 0,
                                     &query, NULL, NULL);
 
-   while (mongoc_cursor_next (cursor, &doc)) {
-      if (BSON_UNLIKELY (doc->len != fwrite (bson_get_data (doc), 1, doc->len, stream))) {
-         fprintf (stderr, "Failed to write %u bytes to %s\n",
-                  doc->len, path);
-         ret = EXIT_FAILURE;
-         goto cleanup;
-      }
-   }
-
-   if (mongoc_cursor_error (cursor, &error)) {
-      fprintf (stderr, "ERROR: %s\n", error.message);
+   /* writes each batch from the reply buffer with a single writev */
+   if (!mongoc_cursor_dump_to_stream (cursor, stream, &error)) {
+      fprintf (stderr, "Failed to dump %s: %s\n", path, error.message);
       ret = EXIT_FAILURE;
    }
 
-cleanup:
    bson_free (path);
-   fclose (stream);
+   mongoc_stream_destroy (stream);
    mongoc_cursor_destroy (cursor);
    mongoc_collection_destroy (col);
 
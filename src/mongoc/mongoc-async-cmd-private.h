@@ -66,6 +66,8 @@ typedef struct _mongoc_async_cmd
    bson_t                   reply;
    bool                     reply_needs_cleanup;
    char                     ns[MONGOC_NAMESPACE_MAX];
+   mongoc_async_pipeline_t *pipeline;
+   uint32_t                 seq;
 
    struct _mongoc_async_cmd *next;
    struct _mongoc_async_cmd *prev;
@@ -82,6 +84,13 @@ mongoc_async_cmd_new (mongoc_async_t           *async,
                       void                     *cb_data,
                       int32_t                   timeout_msec);
 
+void
+mongoc_async_cmd_set_pipeline (mongoc_async_cmd_t      *acmd,
+                               mongoc_async_pipeline_t *pipeline);
+
+int
+mongoc_async_cmd_events (const mongoc_async_cmd_t *acmd);
+
 void
 mongoc_async_cmd_destroy (mongoc_async_cmd_t *acmd);
 
@@ -206,11 +206,85 @@ mongoc_async_cmd_new (mongoc_async_t           *async,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_cmd_set_pipeline --
+ *
+ *       Queue @acmd behind the commands already added to @pipeline, which
+ *       all use the same stream. Call right after mongoc_async_cmd_new.
+ *       @pipeline must outlive the command.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_async_cmd_set_pipeline (mongoc_async_cmd_t      *acmd,
+                               mongoc_async_pipeline_t *pipeline)
+{
+   BSON_ASSERT (acmd);
+   BSON_ASSERT (pipeline);
+
+   acmd->pipeline = pipeline;
+   acmd->seq = pipeline->n_cmds++;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_cmd_events --
+ *
+ *       The poll events @acmd waits for: none while it waits its turn to
+ *       send or to read on a pipelined stream.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int
+mongoc_async_cmd_events (const mongoc_async_cmd_t *acmd)
+{
+   const mongoc_async_pipeline_t *pipeline = acmd->pipeline;
+
+   if (!pipeline) {
+      return acmd->events;
+   }
+
+   switch (acmd->state) {
+   case MONGOC_ASYNC_CMD_SEND:
+      if (acmd->seq != pipeline->n_sent ||
+          (pipeline->serial && pipeline->n_received != pipeline->n_sent)) {
+         return 0;
+      }
+      break;
+   case MONGOC_ASYNC_CMD_RECV_LEN:
+   case MONGOC_ASYNC_CMD_RECV_RPC:
+      if (acmd->seq != pipeline->n_received) {
+         return 0;
+      }
+      break;
+   case MONGOC_ASYNC_CMD_SETUP:
+   case MONGOC_ASYNC_CMD_ERROR_STATE:
+   case MONGOC_ASYNC_CMD_CANCELED_STATE:
+   default:
+      break;
+   }
+
+   return acmd->events;
+}
+
+
 void
 mongoc_async_cmd_destroy (mongoc_async_cmd_t *acmd)
 {
    BSON_ASSERT (acmd);
 
+   /* a command that ends before its reply is read leaves the stream out
+    * of step with the commands behind it */
+   if (acmd->pipeline && acmd->seq >= acmd->pipeline->n_received) {
+      acmd->pipeline->failed = true;
+   }
+
    DL_DELETE (acmd->async->cmds, acmd);
    acmd->async->ncmds--;
 
@@ -282,6 +356,20 @@ _mongoc_async_cmd_phase_send (mongoc_async_cmd_t *acmd)
       }
    }
 
+   while (acmd->niovec && !acmd->iovec->iov_len) {
+      acmd->iovec++;
+      acmd->niovec--;
+   }
+
+   if (acmd->niovec) {
+      /* partial write, wait for the stream to be writable again */
+      return MONGOC_ASYNC_CMD_IN_PROGRESS;
+   }
+
+   if (acmd->pipeline) {
+      acmd->pipeline->n_sent++;
+   }
+
    acmd->state = MONGOC_ASYNC_CMD_RECV_LEN;
    acmd->bytes_to_read = 4;
    acmd->events = POLLIN;
@@ -390,6 +478,10 @@ _mongoc_async_cmd_phase_recv_rpc (mongoc_async_cmd_t *acmd)
 
       acmd->reply_needs_cleanup = true;
 
+      if (acmd->pipeline) {
+         acmd->pipeline->n_received++;
+      }
+
       return MONGOC_ASYNC_CMD_SUCCESS;
    }
 
@@ -22,12 +22,26 @@
 #endif
 
 #include <bson.h>
+#include "mongoc-socket.h"
 #include "mongoc-stream.h"
 
 BSON_BEGIN_DECLS
 
 struct _mongoc_async_cmd;
 
+/* commands that share a stream: each is sent, and its reply read, in the
+ * order the commands were added. if one fails the stream is out of step
+ * and the rest fail too */
+typedef struct _mongoc_async_pipeline
+{
+   uint32_t                  n_cmds;
+   uint32_t                  n_sent;
+   uint32_t                  n_received;
+   /* send a command only once the previous reply has been read */
+   bool                      serial;
+   bool                      failed;
+} mongoc_async_pipeline_t;
+
 typedef struct _mongoc_async
 {
    struct _mongoc_async_cmd *cmds;
@@ -67,6 +81,20 @@ bool
 mongoc_async_run (mongoc_async_t *async,
                   int32_t         timeout_msec);
 
+size_t
+mongoc_async_get_sockets (mongoc_async_t       *async,
+                          mongoc_socket_poll_t *sds,
+                          size_t                n_sds,
+                          size_t                n_used);
+
+int64_t
+mongoc_async_get_expire_at (mongoc_async_t *async);
+
+bool
+mongoc_async_step (mongoc_async_t             *async,
+                   const mongoc_socket_poll_t *sds,
+                   size_t                      n_sds);
+
 struct _mongoc_async_cmd *
 mongoc_async_cmd (mongoc_async_t          *async,
                   mongoc_stream_t         *stream,
@@ -19,6 +19,9 @@
 
 #include "mongoc-async-private.h"
 #include "mongoc-async-cmd-private.h"
+#include "mongoc-error.h"
+#include "mongoc-stream-private.h"
+#include "mongoc-stream-socket.h"
 #include "utlist.h"
 
 #undef MONGOC_LOG_DOMAIN
@@ -60,13 +63,50 @@ mongoc_async_destroy (mongoc_async_t *async)
    bson_free (async);
 }
 
+/* time out commands past their deadline, and fail the commands left on a
+ * pipelined stream after one of its commands failed */
+static void
+_mongoc_async_expire (mongoc_async_t *async,
+                      int64_t         now)
+{
+   mongoc_async_cmd_t *acmd, *tmp;
+
+   DL_FOREACH_SAFE (async->cmds, acmd, tmp)
+   {
+      /* async commands are sorted by expire_at */
+      if (now > acmd->expire_at) {
+         acmd->cb (MONGOC_ASYNC_CMD_TIMEOUT, NULL, (now - acmd->start_time), acmd->data,
+                   &acmd->error);
+         mongoc_async_cmd_destroy (acmd);
+      } else {
+         break;
+      }
+   }
+
+   /* a command failed on a pipelined stream, the stream's other
+    * commands can't succeed */
+   DL_FOREACH_SAFE (async->cmds, acmd, tmp)
+   {
+      if (acmd->pipeline && acmd->pipeline->failed) {
+         bson_set_error (&acmd->error, MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "Connection failed with command pending.");
+         acmd->cb (MONGOC_ASYNC_CMD_ERROR, NULL, (now - acmd->start_time),
+                   acmd->data, &acmd->error);
+         mongoc_async_cmd_destroy (acmd);
+      }
+   }
+}
+
 bool
 mongoc_async_run (mongoc_async_t *async,
                   int32_t         timeout_msec)
 {
-   mongoc_async_cmd_t *acmd, *tmp;
+   mongoc_async_cmd_t *acmd;
+   mongoc_async_cmd_t **acmds = NULL;
    mongoc_stream_poll_t *poller = NULL;
    int i;
+   int npoll;
    ssize_t nactive = 0;
    int64_t now;
    int64_t expire_at = 0;
@@ -90,17 +130,7 @@ mongoc_async_run (mongoc_async_t *async,
          break;
       }
 
-      DL_FOREACH_SAFE (async->cmds, acmd, tmp)
-      {
-         /* async commands are sorted by expire_at */
-         if (now > acmd->expire_at) {
-            acmd->cb (MONGOC_ASYNC_CMD_TIMEOUT, NULL, (now - acmd->start_time), acmd->data,
-                      &acmd->error);
-            mongoc_async_cmd_destroy (acmd);
-         } else {
-            break;
-         }
-      }
+      _mongoc_async_expire (async, now);
 
       if (!async->ncmds) {
          break;
@@ -108,31 +138,36 @@ mongoc_async_run (mongoc_async_t *async,
 
       if (poll_size < async->ncmds) {
          poller = (mongoc_stream_poll_t *)bson_realloc (poller, sizeof (*poller) * async->ncmds);
+         acmds = (mongoc_async_cmd_t **)bson_realloc (acmds, sizeof (*acmds) * async->ncmds);
          poll_size = async->ncmds;
       }
 
+      /* callbacks may add commands, so remember which command each poller
+       * entry belongs to */
       i = 0;
       DL_FOREACH (async->cmds, acmd)
       {
          poller[i].stream = acmd->stream;
-         poller[i].events = acmd->events;
+         poller[i].events = mongoc_async_cmd_events (acmd);
          poller[i].revents = 0;
+         acmds[i] = acmd;
          i++;
       }
 
+      npoll = i;
+
       if (timeout_msec >= 0) {
          timeout_msec = BSON_MIN (timeout_msec, (async->cmds->expire_at - now) / 1000);
       } else {
          timeout_msec = (async->cmds->expire_at - now) / 1000;
       }
 
-      nactive = mongoc_stream_poll (poller, async->ncmds, timeout_msec);
+      nactive = mongoc_stream_poll (poller, npoll, timeout_msec);
 
-      if (nactive) {
-         i = 0;
+      if (nactive > 0) {
+         for (i = 0; i < npoll && nactive; i++) {
+            acmd = acmds[i];
 
-         DL_FOREACH_SAFE (async->cmds, acmd, tmp)
-         {
             if (poller[i].revents & (POLLERR | POLLHUP)) {
                acmd->state = MONGOC_ASYNC_CMD_ERROR_STATE;
             }
@@ -142,20 +177,179 @@ mongoc_async_run (mongoc_async_t *async,
 
                mongoc_async_cmd_run (acmd);
                nactive--;
-
-               if (!nactive) {
-                  break;
-               }
             }
-
-            i++;
          }
       }
    }
 
    if (poll_size) {
       bson_free (poller);
+      bson_free (acmds);
    }
 
    return async->ncmds;
 }
+
+
+/* the socket below a command's stream, or NULL if it has none */
+static mongoc_socket_t *
+_mongoc_async_cmd_get_socket (mongoc_async_cmd_t *acmd)
+{
+   mongoc_stream_t *root;
+
+   root = mongoc_stream_get_root_stream (acmd->stream);
+
+   if (!root || root->type != MONGOC_STREAM_SOCKET) {
+      return NULL;
+   }
+
+   return mongoc_stream_socket_get_socket ((mongoc_stream_socket_t *)root);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_get_sockets --
+ *
+ *       Add the sockets that @async's commands wait on, and the events
+ *       they wait for, to the @n_used entries already in @sds. Events
+ *       are merged into an existing entry for the same socket.
+ *
+ * Returns:
+ *       The number of entries in use. If this exceeds @n_sds, some
+ *       sockets were not stored and the count is an upper bound.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+mongoc_async_get_sockets (mongoc_async_t       *async,
+                          mongoc_socket_poll_t *sds,
+                          size_t                n_sds,
+                          size_t                n_used)
+{
+   mongoc_async_cmd_t *acmd;
+   mongoc_socket_t *sock;
+   int events;
+   size_t i;
+
+   DL_FOREACH (async->cmds, acmd)
+   {
+      sock = _mongoc_async_cmd_get_socket (acmd);
+      events = mongoc_async_cmd_events (acmd);
+
+      if (!sock || !events) {
+         continue;
+      }
+
+      for (i = 0; i < BSON_MIN (n_used, n_sds); i++) {
+         if (sds[i].socket == sock) {
+            sds[i].events |= events;
+            break;
+         }
+      }
+
+      if (i < BSON_MIN (n_used, n_sds)) {
+         continue;
+      }
+
+      if (n_used < n_sds) {
+         sds[n_used].socket = sock;
+         sds[n_used].events = events;
+         sds[n_used].revents = 0;
+      }
+
+      n_used++;
+   }
+
+   return n_used;
+}
+
+
+/* the earliest deadline of @async's commands, or -1 if it has none */
+int64_t
+mongoc_async_get_expire_at (mongoc_async_t *async)
+{
+   mongoc_async_cmd_t *acmd;
+   int64_t expire_at = -1;
+
+   DL_FOREACH (async->cmds, acmd)
+   {
+      if (expire_at < 0 || acmd->expire_at < expire_at) {
+         expire_at = acmd->expire_at;
+      }
+   }
+
+   return expire_at;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_async_step --
+ *
+ *       Advance the commands waiting on sockets in @sds whose revents
+ *       are set, and time out expired commands, without blocking. The
+ *       non-blocking counterpart of mongoc_async_run, for callers that
+ *       poll the sockets from mongoc_async_get_sockets themselves.
+ *
+ * Returns:
+ *       true if commands are still pending.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_async_step (mongoc_async_t             *async,
+                   const mongoc_socket_poll_t *sds,
+                   size_t                      n_sds)
+{
+   mongoc_async_cmd_t *acmd;
+   mongoc_async_cmd_t **ready;
+   mongoc_socket_t *sock;
+   size_t n_ready = 0;
+   size_t i;
+   int events;
+
+   _mongoc_async_expire (async, bson_get_monotonic_time ());
+
+   if (!async->ncmds || !n_sds) {
+      return async->ncmds;
+   }
+
+   /* callbacks may add commands, so choose the commands to run first */
+   ready = (mongoc_async_cmd_t **)bson_malloc (sizeof (*ready) * async->ncmds);
+
+   DL_FOREACH (async->cmds, acmd)
+   {
+      sock = _mongoc_async_cmd_get_socket (acmd);
+      events = mongoc_async_cmd_events (acmd);
+
+      for (i = 0; sock && i < n_sds; i++) {
+         if (sds[i].socket != sock || !sds[i].revents) {
+            continue;
+         }
+
+         if (sds[i].revents & (POLLERR | POLLHUP)) {
+            acmd->state = MONGOC_ASYNC_CMD_ERROR_STATE;
+         }
+
+         if (acmd->state == MONGOC_ASYNC_CMD_ERROR_STATE
+             || (sds[i].revents & events)) {
+            ready[n_ready++] = acmd;
+         }
+
+         break;
+      }
+   }
+
+   for (i = 0; i < n_ready; i++) {
+      mongoc_async_cmd_run (ready[i]);
+   }
+
+   bson_free (ready);
+
+   return async->ncmds;
+}
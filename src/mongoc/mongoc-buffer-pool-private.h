@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MONGOC_BUFFER_POOL_PRIVATE_H
+#define MONGOC_BUFFER_POOL_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-buffer-private.h"
+#include "mongoc-thread-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/* size classes are powers of two from 1KB up to 64MB, which covers the
+ * largest reply the server may send (48MB) */
+#define MONGOC_BUFFER_POOL_MIN_SHIFT 10
+#define MONGOC_BUFFER_POOL_MAX_SHIFT 26
+#define MONGOC_BUFFER_POOL_N_CLASSES \
+   (MONGOC_BUFFER_POOL_MAX_SHIFT - MONGOC_BUFFER_POOL_MIN_SHIFT + 1)
+
+
+typedef struct _mongoc_buffer_pool_t mongoc_buffer_pool_t;
+
+
+struct _mongoc_buffer_pool_t
+{
+   mongoc_mutex_t  mutex;
+   void           *free_lists [MONGOC_BUFFER_POOL_N_CLASSES];
+   size_t          max_bytes;
+   size_t          retained_bytes;
+   uint64_t        hits;
+   uint64_t        misses;
+};
+
+
+mongoc_buffer_pool_t *_mongoc_buffer_pool_new           (size_t                max_bytes);
+void                  _mongoc_buffer_pool_destroy       (mongoc_buffer_pool_t *pool);
+void                  _mongoc_buffer_pool_set_max_bytes (mongoc_buffer_pool_t *pool,
+                                                         size_t                max_bytes);
+void                 *_mongoc_buffer_pool_realloc       (void                 *mem,
+                                                         size_t                num_bytes,
+                                                         void                 *ctx);
+void                  _mongoc_buffer_init_from_pool     (mongoc_buffer_t      *buffer,
+                                                         mongoc_buffer_pool_t *pool);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_BUFFER_POOL_PRIVATE_H */
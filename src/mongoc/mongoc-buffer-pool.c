@@ -0,0 +1,276 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson.h>
+
+#include "mongoc-buffer-pool-private.h"
+#include "mongoc-counters-private.h"
+#include "mongoc-trace.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "buffer-pool"
+
+
+/*
+ * Every block handed out by the pool is preceded by this header, so that
+ * _mongoc_buffer_pool_realloc can find a block's capacity when it is grown
+ * or released. The header doubles as the free list link.
+ */
+typedef union _mongoc_buffer_pool_hdr_t
+{
+   struct {
+      union _mongoc_buffer_pool_hdr_t *next;
+      size_t                           capacity;
+   } b;
+   uint8_t align [16];
+} mongoc_buffer_pool_hdr_t;
+
+
+#define HDR_FOR(_mem) (((mongoc_buffer_pool_hdr_t *)(_mem)) - 1)
+#define MEM_FOR(_hdr) ((void *)(((mongoc_buffer_pool_hdr_t *)(_hdr)) + 1))
+
+
+/* index of the smallest class holding @size bytes, or -1 if too large */
+static int
+_mongoc_buffer_pool_class_for_size (size_t size)
+{
+   int shift = MONGOC_BUFFER_POOL_MIN_SHIFT;
+
+   while (shift <= MONGOC_BUFFER_POOL_MAX_SHIFT) {
+      if (size <= ((size_t) 1 << shift)) {
+         return shift - MONGOC_BUFFER_POOL_MIN_SHIFT;
+      }
+
+      shift++;
+   }
+
+   return -1;
+}
+
+
+/* index of the class a block of @capacity belongs to, or -1 if none */
+static int
+_mongoc_buffer_pool_class_for_capacity (size_t capacity)
+{
+   int idx = _mongoc_buffer_pool_class_for_size (capacity);
+
+   if (idx < 0 ||
+       capacity != ((size_t) 1 << (idx + MONGOC_BUFFER_POOL_MIN_SHIFT))) {
+      return -1;
+   }
+
+   return idx;
+}
+
+
+mongoc_buffer_pool_t *
+_mongoc_buffer_pool_new (size_t max_bytes)
+{
+   mongoc_buffer_pool_t *pool;
+
+   pool = (mongoc_buffer_pool_t *) bson_malloc0 (sizeof *pool);
+   mongoc_mutex_init (&pool->mutex);
+   pool->max_bytes = max_bytes;
+
+   return pool;
+}
+
+
+/* frees retained blocks, largest first, until under @max_bytes.
+ * the pool's mutex must be held. */
+static void
+_mongoc_buffer_pool_trim (mongoc_buffer_pool_t *pool,
+                          size_t                max_bytes)
+{
+   mongoc_buffer_pool_hdr_t *hdr;
+   int i;
+
+   for (i = MONGOC_BUFFER_POOL_N_CLASSES - 1;
+        i >= 0 && pool->retained_bytes > max_bytes;
+        i--) {
+      while (pool->free_lists [i] && pool->retained_bytes > max_bytes) {
+         hdr = (mongoc_buffer_pool_hdr_t *) pool->free_lists [i];
+         pool->free_lists [i] = hdr->b.next;
+         pool->retained_bytes -= hdr->b.capacity;
+         mongoc_counter_buffer_pool_retained_add (-(int64_t) hdr->b.capacity);
+         bson_free (hdr);
+      }
+   }
+}
+
+
+void
+_mongoc_buffer_pool_destroy (mongoc_buffer_pool_t *pool)
+{
+   if (!pool) {
+      return;
+   }
+
+   _mongoc_buffer_pool_trim (pool, 0);
+   mongoc_mutex_destroy (&pool->mutex);
+   bson_free (pool);
+}
+
+
+void
+_mongoc_buffer_pool_set_max_bytes (mongoc_buffer_pool_t *pool,
+                                   size_t                max_bytes)
+{
+   BSON_ASSERT (pool);
+
+   mongoc_mutex_lock (&pool->mutex);
+   pool->max_bytes = max_bytes;
+   _mongoc_buffer_pool_trim (pool, max_bytes);
+   mongoc_mutex_unlock (&pool->mutex);
+}
+
+
+static void *
+_mongoc_buffer_pool_acquire (mongoc_buffer_pool_t *pool,
+                             size_t                size)
+{
+   mongoc_buffer_pool_hdr_t *hdr = NULL;
+   size_t capacity;
+   int idx;
+
+   idx = _mongoc_buffer_pool_class_for_size (size);
+
+   if (idx >= 0) {
+      mongoc_mutex_lock (&pool->mutex);
+      hdr = (mongoc_buffer_pool_hdr_t *) pool->free_lists [idx];
+      if (hdr) {
+         pool->free_lists [idx] = hdr->b.next;
+         pool->retained_bytes -= hdr->b.capacity;
+         pool->hits++;
+      } else {
+         pool->misses++;
+      }
+      mongoc_mutex_unlock (&pool->mutex);
+   }
+
+   if (hdr) {
+      mongoc_counter_buffer_pool_hits_inc ();
+      mongoc_counter_buffer_pool_retained_add (-(int64_t) hdr->b.capacity);
+      return MEM_FOR (hdr);
+   }
+
+   mongoc_counter_buffer_pool_misses_inc ();
+
+   capacity = idx >= 0
+      ? (size_t) 1 << (idx + MONGOC_BUFFER_POOL_MIN_SHIFT)
+      : size;
+
+   hdr = (mongoc_buffer_pool_hdr_t *) bson_malloc (sizeof *hdr + capacity);
+   hdr->b.next = NULL;
+   hdr->b.capacity = capacity;
+
+   return MEM_FOR (hdr);
+}
+
+
+static void
+_mongoc_buffer_pool_release (mongoc_buffer_pool_t *pool,
+                             void                 *mem)
+{
+   mongoc_buffer_pool_hdr_t *hdr = HDR_FOR (mem);
+   bool retained = false;
+   int idx;
+
+   idx = _mongoc_buffer_pool_class_for_capacity (hdr->b.capacity);
+
+   if (idx >= 0) {
+      mongoc_mutex_lock (&pool->mutex);
+      if (pool->retained_bytes + hdr->b.capacity <= pool->max_bytes) {
+         hdr->b.next = (mongoc_buffer_pool_hdr_t *) pool->free_lists [idx];
+         pool->free_lists [idx] = hdr;
+         pool->retained_bytes += hdr->b.capacity;
+         retained = true;
+      }
+      mongoc_mutex_unlock (&pool->mutex);
+   }
+
+   if (retained) {
+      mongoc_counter_buffer_pool_retained_add ((int64_t) hdr->b.capacity);
+   } else {
+      bson_free (hdr);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_buffer_pool_realloc --
+ *
+ *       A bson_realloc_func that draws blocks from the mongoc_buffer_pool_t
+ *       passed as @ctx and returns them to it when they are freed or
+ *       outgrown. Growing within a block's size class is free.
+ *
+ * Returns:
+ *       A block of at least @num_bytes, or NULL if @num_bytes is zero.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void *
+_mongoc_buffer_pool_realloc (void   *mem,
+                             size_t  num_bytes,
+                             void   *ctx)
+{
+   mongoc_buffer_pool_t *pool = (mongoc_buffer_pool_t *) ctx;
+   size_t capacity;
+   void *ret;
+
+   BSON_ASSERT (pool);
+
+   if (!mem) {
+      return num_bytes ? _mongoc_buffer_pool_acquire (pool, num_bytes) : NULL;
+   }
+
+   if (!num_bytes) {
+      _mongoc_buffer_pool_release (pool, mem);
+      return NULL;
+   }
+
+   capacity = HDR_FOR (mem)->b.capacity;
+   if (num_bytes <= capacity) {
+      return mem;
+   }
+
+   ret = _mongoc_buffer_pool_acquire (pool, num_bytes);
+   memcpy (ret, mem, capacity);
+   _mongoc_buffer_pool_release (pool, mem);
+
+   return ret;
+}
+
+
+/*
+ * Initialize @buffer so its storage comes from @pool, or from the default
+ * allocator if @pool is NULL.
+ */
+void
+_mongoc_buffer_init_from_pool (mongoc_buffer_t      *buffer,
+                               mongoc_buffer_pool_t *pool)
+{
+   if (pool) {
+      _mongoc_buffer_init (buffer, NULL, 0, _mongoc_buffer_pool_realloc, pool);
+   } else {
+      _mongoc_buffer_init (buffer, NULL, 0, NULL, NULL);
+   }
+}
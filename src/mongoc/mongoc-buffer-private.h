@@ -40,6 +40,9 @@ struct _mongoc_buffer_t
    size_t              len;
    bson_realloc_func   realloc_func;
    void               *realloc_data;
+   /* in ring mode the stored bytes start at @off and may wrap around to the
+    * start of @data; see _mongoc_buffer_init_ring */
+   bool                ring;
 };
 
 
@@ -78,6 +81,28 @@ void
 _mongoc_buffer_clear (mongoc_buffer_t *buffer,
                       bool      zero);
 
+void
+_mongoc_buffer_init_ring (mongoc_buffer_t   *buffer,
+                          size_t             buflen,
+                          bson_realloc_func  realloc_func,
+                          void              *realloc_data);
+
+ssize_t
+_mongoc_buffer_ring_fill (mongoc_buffer_t *buffer,
+                          mongoc_stream_t *stream,
+                          size_t           min_bytes,
+                          int32_t          timeout_msec,
+                          bson_error_t    *error);
+
+void
+_mongoc_buffer_ring_consume (mongoc_buffer_t *buffer,
+                             size_t           size);
+
+size_t
+_mongoc_buffer_ring_read (mongoc_buffer_t *buffer,
+                          mongoc_iovec_t  *iov,
+                          size_t           iovcnt);
+
 
 BSON_END_DECLS
 
@@ -66,7 +66,7 @@ _mongoc_buffer_init (mongoc_buffer_t   *buffer,
    }
 
    if (!buf) {
-      buf = (uint8_t *)realloc_func (NULL, buflen, NULL);
+      buf = (uint8_t *)realloc_func (NULL, buflen, realloc_data);
    }
 
    memset (buffer, 0, sizeof *buffer);
@@ -163,7 +163,8 @@ _mongoc_buffer_append_from_stream (mongoc_buffer_t *buffer,
       buffer->off = 0;
       if (!SPACE_FOR (buffer, size)) {
          buffer->datalen = bson_next_power_of_two (size + buffer->len + buffer->off);
-         buffer->data = (uint8_t *)buffer->realloc_func (buffer->data, buffer->datalen, NULL);
+         buffer->data = (uint8_t *)buffer->realloc_func (buffer->data, buffer->datalen,
+                                                         buffer->realloc_data);
       }
    }
 
@@ -306,7 +307,8 @@ _mongoc_buffer_try_append_from_stream (mongoc_buffer_t *buffer,
       buffer->off = 0;
       if (!SPACE_FOR (buffer, size)) {
          buffer->datalen = bson_next_power_of_two (size + buffer->len + buffer->off);
-         buffer->data = (uint8_t *)buffer->realloc_func (buffer->data, buffer->datalen, NULL);
+         buffer->data = (uint8_t *)buffer->realloc_func (buffer->data, buffer->datalen,
+                                                         buffer->realloc_data);
       }
    }
 
@@ -324,3 +326,266 @@ _mongoc_buffer_try_append_from_stream (mongoc_buffer_t *buffer,
 }
 
 
+
+
+/**
+ * _mongoc_buffer_init_ring:
+ * @buffer: A mongoc_buffer_t to initialize.
+ * @buflen: The initial capacity of @buffer, or 0 for the default.
+ * @realloc_func: A function to allocate and free the storage, or NULL.
+ * @realloc_data: User data for @realloc_func.
+ *
+ * Initializes @buffer as a ring buffer. Bytes are appended at the tail with
+ * _mongoc_buffer_ring_fill and removed from the head with
+ * _mongoc_buffer_ring_consume or _mongoc_buffer_ring_read. Unlike
+ * _mongoc_buffer_fill, leftover bytes are never moved to make space; the
+ * stored region simply wraps around the end of the allocation.
+ */
+void
+_mongoc_buffer_init_ring (mongoc_buffer_t   *buffer,
+                          size_t             buflen,
+                          bson_realloc_func  realloc_func,
+                          void              *realloc_data)
+{
+   _mongoc_buffer_init (buffer, NULL, buflen, realloc_func, realloc_data);
+   buffer->ring = true;
+}
+
+
+/* the stored bytes as at most two spans, returns the number of spans */
+static int
+_mongoc_buffer_ring_used (const mongoc_buffer_t *buffer,
+                          mongoc_iovec_t         iov[2])
+{
+   size_t first;
+
+   if (!buffer->len) {
+      return 0;
+   }
+
+   first = BSON_MIN (buffer->len, buffer->datalen - (size_t) buffer->off);
+
+   iov[0].iov_base = (void *) &buffer->data[buffer->off];
+   iov[0].iov_len = first;
+
+   if (first == buffer->len) {
+      return 1;
+   }
+
+   iov[1].iov_base = (void *) buffer->data;
+   iov[1].iov_len = buffer->len - first;
+
+   return 2;
+}
+
+
+/* the free space as at most two spans, returns the number of spans */
+static int
+_mongoc_buffer_ring_free (const mongoc_buffer_t *buffer,
+                          mongoc_iovec_t         iov[2])
+{
+   size_t tail;
+
+   if (buffer->len == buffer->datalen) {
+      return 0;
+   }
+
+   tail = ((size_t) buffer->off + buffer->len) % buffer->datalen;
+
+   if (tail < (size_t) buffer->off) {
+      iov[0].iov_base = (void *) &buffer->data[tail];
+      iov[0].iov_len = (size_t) buffer->off - tail;
+      return 1;
+   }
+
+   iov[0].iov_base = (void *) &buffer->data[tail];
+   iov[0].iov_len = buffer->datalen - tail;
+
+   if (!buffer->off) {
+      return 1;
+   }
+
+   iov[1].iov_base = (void *) buffer->data;
+   iov[1].iov_len = (size_t) buffer->off;
+
+   return 2;
+}
+
+
+/* resize the allocation to @datalen in place, moving the bytes before the
+ * wrap point to the new end so the ring stays intact */
+static void
+_mongoc_buffer_ring_grow (mongoc_buffer_t *buffer,
+                          size_t           datalen)
+{
+   size_t old_datalen = buffer->datalen;
+   size_t first;
+
+   BSON_ASSERT (datalen >= old_datalen);
+
+   buffer->data = (uint8_t *) buffer->realloc_func (buffer->data, datalen,
+                                                    buffer->realloc_data);
+   buffer->datalen = datalen;
+
+   if ((size_t) buffer->off + buffer->len > old_datalen) {
+      first = old_datalen - (size_t) buffer->off;
+      memmove (&buffer->data[datalen - first], &buffer->data[buffer->off],
+               first);
+      buffer->off = (off_t) (datalen - first);
+   }
+}
+
+
+/**
+ * _mongoc_buffer_ring_fill:
+ * @buffer: A mongoc_buffer_t initialized with _mongoc_buffer_init_ring.
+ * @stream: A stream to read from.
+ * @min_bytes: The minumum number of bytes @buffer should hold.
+ * @timeout_msec: The number of milliseconds to wait or -1 for the default.
+ * @error: A location for a bson_error_t or NULL.
+ *
+ * Reads from @stream straight into the free space of @buffer, on both sides
+ * of the wrap point, until it holds at least @min_bytes. Stored bytes are
+ * only moved if @min_bytes exceeds the capacity of @buffer, which is then
+ * grown in place.
+ *
+ * Returns: The number of buffered bytes, or -1 on failure.
+ */
+ssize_t
+_mongoc_buffer_ring_fill (mongoc_buffer_t *buffer,
+                          mongoc_stream_t *stream,
+                          size_t           min_bytes,
+                          int32_t          timeout_msec,
+                          bson_error_t    *error)
+{
+   mongoc_iovec_t iov[2];
+   ssize_t ret;
+   size_t needed;
+   int n;
+
+   ENTRY;
+
+   BSON_ASSERT (buffer);
+   BSON_ASSERT (buffer->ring);
+   BSON_ASSERT (stream);
+
+   if (min_bytes <= buffer->len) {
+      RETURN (buffer->len);
+   }
+
+   needed = min_bytes - buffer->len;
+
+   if (min_bytes > buffer->datalen) {
+      _mongoc_buffer_ring_grow (buffer, bson_next_power_of_two (min_bytes));
+   } else if (!buffer->len) {
+      /* nothing to preserve, read into one contiguous span */
+      buffer->off = 0;
+   }
+
+   n = _mongoc_buffer_ring_free (buffer, iov);
+   BSON_ASSERT (n);
+
+   ret = mongoc_stream_readv (stream, iov, (size_t) n, needed, timeout_msec);
+
+   if (ret == -1) {
+      bson_set_error (error,
+                      MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_SOCKET,
+                      "Failed to buffer %u bytes within %d milliseconds.",
+                      (unsigned)needed, (int)timeout_msec);
+      RETURN (-1);
+   }
+
+   buffer->len += ret;
+
+   if (buffer->len < min_bytes) {
+      bson_set_error (error,
+                      MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_SOCKET,
+                      "Could only buffer %u of %u bytes in %d milliseconds.",
+                      (unsigned)buffer->len,
+                      (unsigned)min_bytes,
+                      (int)timeout_msec);
+      RETURN (-1);
+   }
+
+   RETURN (buffer->len);
+}
+
+
+/**
+ * _mongoc_buffer_ring_consume:
+ * @buffer: A mongoc_buffer_t initialized with _mongoc_buffer_init_ring.
+ * @size: The number of bytes to discard, no more than are buffered.
+ *
+ * Discards @size bytes from the head of @buffer.
+ */
+void
+_mongoc_buffer_ring_consume (mongoc_buffer_t *buffer,
+                             size_t           size)
+{
+   BSON_ASSERT (buffer);
+   BSON_ASSERT (buffer->ring);
+   BSON_ASSERT (size <= buffer->len);
+
+   buffer->len -= size;
+
+   if (buffer->len) {
+      buffer->off = (off_t) (((size_t) buffer->off + size) % buffer->datalen);
+   } else {
+      buffer->off = 0;
+   }
+}
+
+
+/**
+ * _mongoc_buffer_ring_read:
+ * @buffer: A mongoc_buffer_t initialized with _mongoc_buffer_init_ring.
+ * @iov: An array of iovecs to fill.
+ * @iovcnt: The number of elements in @iov.
+ *
+ * Copies buffered bytes into @iov and consumes them.
+ *
+ * Returns: The number of bytes copied.
+ */
+size_t
+_mongoc_buffer_ring_read (mongoc_buffer_t *buffer,
+                          mongoc_iovec_t  *iov,
+                          size_t           iovcnt)
+{
+   mongoc_iovec_t used[2];
+   size_t total = 0;
+   size_t iov_off = 0;
+   size_t n;
+   size_t i = 0;
+   int j;
+   int nused;
+
+   BSON_ASSERT (buffer);
+   BSON_ASSERT (buffer->ring);
+
+   nused = _mongoc_buffer_ring_used (buffer, used);
+
+   for (j = 0; j < nused && i < iovcnt; j++) {
+      size_t used_off = 0;
+
+      while (used_off < used[j].iov_len && i < iovcnt) {
+         n = BSON_MIN (used[j].iov_len - used_off, iov[i].iov_len - iov_off);
+         memcpy ((char *) iov[i].iov_base + iov_off,
+                 (char *) used[j].iov_base + used_off,
+                 n);
+         used_off += n;
+         iov_off += n;
+         total += n;
+
+         if (iov_off == iov[i].iov_len) {
+            i++;
+            iov_off = 0;
+         }
+      }
+   }
+
+   _mongoc_buffer_ring_consume (buffer, total);
+
+   return total;
+}
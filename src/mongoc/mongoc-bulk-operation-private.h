@@ -23,6 +23,7 @@
 
 #include "mongoc-array-private.h"
 #include "mongoc-client.h"
+#include "mongoc-client-pool.h"
 #include "mongoc-write-command-private.h"
 
 
@@ -40,6 +41,8 @@ struct _mongoc_bulk_operation_t
    mongoc_write_result_t          result;
    bool                           executed;
    int64_t                        operation_id;
+   mongoc_client_pool_t          *pool;
+   uint32_t                       max_connections;
 };
 
 
@@ -48,6 +51,7 @@ mongoc_bulk_operation_t *_mongoc_bulk_operation_new (mongoc_client_t
                                                      const char                    *collection,
                                                      mongoc_bulk_write_flags_t      flags,
                                                      const mongoc_write_concern_t  *write_concern);
+mongoc_write_command_t  *_mongoc_bulk_operation_insert_command (mongoc_bulk_operation_t *bulk);
 
 
 BSON_END_DECLS
@@ -17,8 +17,10 @@
 
 #include "mongoc-bulk-operation.h"
 #include "mongoc-bulk-operation-private.h"
+#include "mongoc-client-pool-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-error.h"
+#include "mongoc-thread-private.h"
 #include "mongoc-trace.h"
 #include "mongoc-write-concern-private.h"
 
@@ -205,17 +207,25 @@ mongoc_bulk_operation_delete_one (mongoc_bulk_operation_t *bulk,
 }
 
 
-void
-mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
-                              const bson_t            *document)
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_operation_insert_command --
+ *
+ *       The insert command the next inserted document goes into: the
+ *       last command if it is an insert with room for another document,
+ *       otherwise a new, empty one.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_write_command_t *
+_mongoc_bulk_operation_insert_command (mongoc_bulk_operation_t *bulk)
 {
    mongoc_write_command_t command = { 0 };
    mongoc_write_command_t *last;
 
-   ENTRY;
-
    BSON_ASSERT (bulk);
-   BSON_ASSERT (document);
 
    if (bulk->commands.len) {
       last = &_mongoc_array_index (&bulk->commands,
@@ -223,17 +233,33 @@ mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
                                    bulk->commands.len - 1);
 
       if (SHOULD_APPEND (last, MONGOC_WRITE_COMMAND_INSERT)) {
-         _mongoc_write_command_insert_append (last, document);
-         EXIT;
+         return last;
       }
    }
 
    _mongoc_write_command_init_insert (
-      &command, document, bulk->flags, bulk->operation_id,
+      &command, NULL, bulk->flags, bulk->operation_id,
       !mongoc_write_concern_is_acknowledged (bulk->write_concern));
 
    _mongoc_array_append_val (&bulk->commands, command);
 
+   return &_mongoc_array_index (&bulk->commands, mongoc_write_command_t,
+                                bulk->commands.len - 1);
+}
+
+
+void
+mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
+                              const bson_t            *document)
+{
+   ENTRY;
+
+   BSON_ASSERT (bulk);
+   BSON_ASSERT (document);
+
+   _mongoc_write_command_insert_append (
+      _mongoc_bulk_operation_insert_command (bulk), document);
+
    EXIT;
 }
 
@@ -370,6 +396,275 @@ mongoc_bulk_operation_update_one (mongoc_bulk_operation_t *bulk,
 }
 
 
+/*
+ * An unordered bulk operation on a pooled client can run its batches
+ * concurrently, one batch per connection. Each batch records its outcome in
+ * its own result, offset by its position in the bulk operation, and the
+ * results are merged in order once every batch has run.
+ */
+typedef struct
+{
+   mongoc_write_command_t command;
+   uint32_t               offset;
+   mongoc_write_result_t  result;
+} mongoc_bulk_batch_t;
+
+
+typedef struct
+{
+   mongoc_bulk_operation_t *bulk;
+   uint32_t                 server_id;
+   mongoc_array_t           batches;
+   mongoc_mutex_t           mutex;
+   size_t                   next;
+} mongoc_bulk_parallel_t;
+
+
+static void
+_mongoc_bulk_batch_init (mongoc_bulk_batch_t          *batch,
+                         const mongoc_write_command_t *command,
+                         uint32_t                      offset)
+{
+   memcpy (&batch->command, command, sizeof *command);
+   batch->command.documents = bson_new ();
+   batch->command.n_documents = 0;
+   batch->offset = offset;
+   _mongoc_write_result_init (&batch->result);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_operation_split --
+ *
+ *       Cut each of the bulk operation's commands into batches of at most
+ *       @max_batch_size documents and roughly @max_batch_bytes bytes.
+ *       _mongoc_write_command splits again if a batch turns out to be too
+ *       large, so the byte limit need not be exact.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_bulk_operation_split (mongoc_bulk_operation_t *bulk,
+                              int32_t                  max_batch_size,
+                              int32_t                  max_batch_bytes,
+                              mongoc_array_t          *batches)
+{
+   mongoc_write_command_t *command;
+   mongoc_bulk_batch_t batch;
+   mongoc_bulk_batch_t *last;
+   bson_iter_t iter;
+   const uint8_t *data;
+   uint32_t len;
+   uint32_t offset = 0;
+   bson_t doc;
+   const char *key;
+   char str[16];
+   int i;
+
+   for (i = 0; i < bulk->commands.len; i++) {
+      command = &_mongoc_array_index (&bulk->commands,
+                                      mongoc_write_command_t, i);
+      last = NULL;
+
+      if (!bson_iter_init (&iter, command->documents)) {
+         continue;
+      }
+
+      while (bson_iter_next (&iter)) {
+         BSON_ASSERT (BSON_ITER_HOLDS_DOCUMENT (&iter));
+         bson_iter_document (&iter, &len, &data);
+
+         if (!last ||
+             last->command.n_documents >= (uint32_t) max_batch_size ||
+             (last->command.n_documents &&
+              last->command.documents->len + len > (uint32_t) max_batch_bytes)) {
+            _mongoc_bulk_batch_init (&batch, command, offset);
+            _mongoc_array_append_val (batches, batch);
+            last = &_mongoc_array_index (batches, mongoc_bulk_batch_t,
+                                         batches->len - 1);
+         }
+
+         bson_uint32_to_string (last->command.n_documents, &key,
+                                str, sizeof str);
+         bson_init_static (&doc, data, len);
+         BSON_APPEND_DOCUMENT (last->command.documents, key, &doc);
+         last->command.n_documents++;
+         offset++;
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_parallel_run --
+ *
+ *       Execute batches with @client until none are left. A fresh stream
+ *       is fetched for each batch, since a network error while executing
+ *       one batch disconnects the stream it ran on.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_bulk_parallel_run (mongoc_bulk_parallel_t *parallel,
+                           mongoc_client_t        *client)
+{
+   mongoc_bulk_operation_t *bulk = parallel->bulk;
+   mongoc_server_stream_t *server_stream;
+   mongoc_bulk_batch_t *batch;
+   size_t i;
+
+   for (;;) {
+      mongoc_mutex_lock (&parallel->mutex);
+      i = parallel->next++;
+      mongoc_mutex_unlock (&parallel->mutex);
+
+      if (i >= parallel->batches.len) {
+         break;
+      }
+
+      batch = &_mongoc_array_index (&parallel->batches,
+                                    mongoc_bulk_batch_t, i);
+
+      server_stream = mongoc_cluster_stream_for_server (&client->cluster,
+                                                        parallel->server_id,
+                                                        true /* reconnect_ok */,
+                                                        &batch->result.error);
+      if (!server_stream) {
+         batch->result.failed = true;
+         continue;
+      }
+
+      _mongoc_write_command_execute (&batch->command, client, server_stream,
+                                     bulk->database, bulk->collection,
+                                     bulk->write_concern, batch->offset,
+                                     &batch->result);
+
+      mongoc_server_stream_cleanup (server_stream);
+   }
+}
+
+
+static void *
+_mongoc_bulk_parallel_worker (void *data)
+{
+   mongoc_bulk_parallel_t *parallel = (mongoc_bulk_parallel_t *)data;
+   mongoc_client_t *client;
+
+   /* never block waiting for the pool; the calling thread works too */
+   client = mongoc_client_pool_try_pop (parallel->bulk->pool);
+   if (client) {
+      _mongoc_bulk_parallel_run (parallel, client);
+      mongoc_client_pool_push (parallel->bulk->pool, client);
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_operation_execute_parallel --
+ *
+ *       Execute an unordered bulk operation's batches concurrently on up
+ *       to bulk->max_connections clients from bulk->pool, and merge the
+ *       results into bulk->result.
+ *
+ * Returns:
+ *       false if the bulk operation is unsuited to parallel execution,
+ *       so the caller executes it serially. Otherwise true; errors are
+ *       reported in bulk->result.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_bulk_operation_execute_parallel (mongoc_bulk_operation_t *bulk,
+                                         mongoc_server_stream_t  *server_stream)
+{
+   mongoc_bulk_parallel_t parallel;
+   mongoc_thread_t *threads;
+   mongoc_bulk_batch_t *batch;
+   uint32_t n_threads;
+   uint32_t i;
+
+   ENTRY;
+
+   if (bulk->flags.ordered ||
+       !bulk->pool ||
+       bulk->max_connections < 2 ||
+       bulk->client->topology != _mongoc_client_pool_get_topology (bulk->pool) ||
+       server_stream->sd->max_wire_version < WIRE_VERSION_WRITE_CMD) {
+      RETURN (false);
+   }
+
+   _mongoc_array_init (&parallel.batches, sizeof (mongoc_bulk_batch_t));
+   _mongoc_bulk_operation_split (
+      bulk,
+      mongoc_server_stream_max_write_batch_size (server_stream),
+      mongoc_server_stream_max_bson_obj_size (server_stream),
+      &parallel.batches);
+
+   if (parallel.batches.len < 2) {
+      for (i = 0; i < parallel.batches.len; i++) {
+         batch = &_mongoc_array_index (&parallel.batches,
+                                       mongoc_bulk_batch_t, i);
+         _mongoc_write_command_destroy (&batch->command);
+         _mongoc_write_result_destroy (&batch->result);
+      }
+
+      _mongoc_array_destroy (&parallel.batches);
+      RETURN (false);
+   }
+
+   parallel.bulk = bulk;
+   parallel.server_id = server_stream->sd->id;
+   parallel.next = 0;
+   mongoc_mutex_init (&parallel.mutex);
+
+   n_threads = BSON_MIN (bulk->max_connections,
+                         (uint32_t) parallel.batches.len) - 1;
+   threads = (mongoc_thread_t *)bson_malloc (n_threads * sizeof *threads);
+
+   /* if a thread can't be started, run with those that were: the calling
+    * thread takes whatever batches they leave */
+   for (i = 0; i < n_threads; i++) {
+      if (mongoc_thread_create (&threads[i], _mongoc_bulk_parallel_worker,
+                                &parallel)) {
+         n_threads = i;
+         break;
+      }
+   }
+
+   _mongoc_bulk_parallel_run (&parallel, bulk->client);
+
+   for (i = 0; i < n_threads; i++) {
+      mongoc_thread_join (threads[i]);
+   }
+
+   for (i = 0; i < parallel.batches.len; i++) {
+      batch = &_mongoc_array_index (&parallel.batches, mongoc_bulk_batch_t, i);
+      _mongoc_write_result_merge_result (&bulk->result, &batch->result);
+      _mongoc_write_command_destroy (&batch->command);
+      _mongoc_write_result_destroy (&batch->result);
+   }
+
+   bulk->server_id = parallel.server_id;
+
+   bson_free (threads);
+   mongoc_mutex_destroy (&parallel.mutex);
+   _mongoc_array_destroy (&parallel.batches);
+
+   RETURN (true);
+}
+
+
 uint32_t
 mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk,  /* IN */
                                bson_t                  *reply, /* OUT */
@@ -444,6 +739,10 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk,  /* IN */
       RETURN (false);
    }
 
+   if (_mongoc_bulk_operation_execute_parallel (bulk, server_stream)) {
+      GOTO (cleanup);
+   }
+
    for (i = 0; i < bulk->commands.len; i++) {
       command = &_mongoc_array_index (&bulk->commands,
                                       mongoc_write_command_t, i);
@@ -537,6 +836,18 @@ mongoc_bulk_operation_set_client (mongoc_bulk_operation_t *bulk,
 }
 
 
+void
+mongoc_bulk_operation_set_client_pool (mongoc_bulk_operation_t *bulk,
+                                       void                    *pool,
+                                       uint32_t                 max_connections)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->pool = (mongoc_client_pool_t *)pool;
+   bulk->max_connections = max_connections;
+}
+
+
 uint32_t
 mongoc_bulk_operation_get_hint (const mongoc_bulk_operation_t *bulk)
 {
@@ -78,6 +78,9 @@ void                          mongoc_bulk_operation_set_collection    (mongoc_bu
                                                                        const char                    *collection);
 void                          mongoc_bulk_operation_set_client        (mongoc_bulk_operation_t       *bulk,
                                                                        void                          *client);
+void                          mongoc_bulk_operation_set_client_pool   (mongoc_bulk_operation_t       *bulk,
+                                                                       void                          *pool,
+                                                                       uint32_t                       max_connections);
 /* These names include the term "hint" for backward compatibility, should be
  * mongoc_bulk_operation_get_server_id, mongoc_bulk_operation_set_server_id. */
 void                          mongoc_bulk_operation_set_hint          (mongoc_bulk_operation_t       *bulk,
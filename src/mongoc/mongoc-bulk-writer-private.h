@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_BULK_WRITER_PRIVATE_H
+#define MONGOC_BULK_WRITER_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-bulk-operation.h"
+#include "mongoc-bulk-writer.h"
+#include "mongoc-queue-private.h"
+#include "mongoc-thread-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+#define MONGOC_BULK_WRITER_DEFAULT_MAX_PENDING 2
+
+
+typedef struct
+{
+   mongoc_bulk_operation_t *bulk;
+   int64_t                  first_document;
+   uint32_t                 n_documents;
+} mongoc_bulk_writer_batch_t;
+
+
+struct _mongoc_bulk_writer_t
+{
+   mongoc_client_pool_t    *pool;
+   char                    *database;
+   char                    *collection;
+   bool                     ordered;
+   mongoc_write_concern_t  *write_concern;
+   mongoc_bulk_writer_cb_t  cb;
+   void                    *cb_context;
+   int64_t                  flush_interval_msec;
+   uint32_t                 max_pending;
+
+   /* learned from the server when the worker starts */
+   int32_t                  max_batch_size;
+   int32_t                  max_batch_bytes;
+
+   mongoc_mutex_t           mutex;
+   mongoc_cond_t            worker_cond;   /* wakes the worker */
+   mongoc_cond_t            done_cond;     /* wakes inserters and flushers */
+   mongoc_thread_t          thread;
+   bool                     shutdown;
+
+   /* the batch inserters are filling */
+   mongoc_bulk_operation_t *current;
+   uint32_t                 current_n;
+   uint32_t                 current_bytes;
+   int64_t                  current_started;
+   int64_t                  current_first;
+
+   /* sealed batches waiting for the worker */
+   mongoc_queue_t           pending;
+   bool                     in_flight;
+   int64_t                  n_documents;
+
+   /* the first error since the last flush */
+   bool                     failed;
+   bson_error_t             error;
+};
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_BULK_WRITER_PRIVATE_H */
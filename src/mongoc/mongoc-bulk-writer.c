@@ -0,0 +1,446 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-bulk-writer.h"
+#include "mongoc-bulk-writer-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
+#include "mongoc-server-description-private.h"
+#include "mongoc-trace.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "bulk-writer"
+
+
+/*
+ * A bulk writer accepts documents continuously and writes them in batches
+ * from a background thread, with a client it pops from the pool. While the
+ * worker executes one batch, inserters fill the next. A batch is sealed and
+ * handed to the worker once it holds maxWriteBatchSize documents or
+ * maxMessageSizeBytes bytes, or once it is older than the flush interval.
+ * Inserters block while max_pending sealed batches are waiting, so memory
+ * stays bounded when the server falls behind.
+ */
+
+
+/* call with the mutex held */
+static void
+_mongoc_bulk_writer_seal (mongoc_bulk_writer_t *writer)
+{
+   mongoc_bulk_writer_batch_t *batch;
+
+   if (!writer->current) {
+      return;
+   }
+
+   batch = (mongoc_bulk_writer_batch_t *)bson_malloc (sizeof *batch);
+   batch->bulk = writer->current;
+   batch->first_document = writer->current_first;
+   batch->n_documents = writer->current_n;
+
+   _mongoc_queue_push_tail (&writer->pending, batch);
+
+   writer->current = NULL;
+   writer->current_n = 0;
+   writer->current_bytes = 0;
+
+   mongoc_cond_signal (&writer->worker_cond);
+}
+
+
+static void
+_mongoc_bulk_writer_learn_limits (mongoc_bulk_writer_t *writer,
+                                  mongoc_client_t      *client)
+{
+   mongoc_server_stream_t *server_stream;
+   bson_error_t error;
+
+   /* if no server is available keep the defaults; the first batch's
+    * execute reports the error */
+   server_stream = mongoc_cluster_stream_for_writes (&client->cluster, &error);
+   if (!server_stream) {
+      return;
+   }
+
+   mongoc_mutex_lock (&writer->mutex);
+   writer->max_batch_size =
+      mongoc_server_stream_max_write_batch_size (server_stream);
+   writer->max_batch_bytes =
+      mongoc_server_stream_max_msg_size (server_stream);
+   mongoc_mutex_unlock (&writer->mutex);
+
+   mongoc_server_stream_cleanup (server_stream);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_writer_next_batch --
+ *
+ *       Wait for a sealed batch, sealing the current batch if the flush
+ *       interval has passed since its first document was inserted.
+ *
+ * Returns:
+ *       A batch, or NULL once the writer is shut down and drained.
+ *
+ * Side effects:
+ *       Sets writer->in_flight if a batch is returned.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_bulk_writer_batch_t *
+_mongoc_bulk_writer_next_batch (mongoc_bulk_writer_t *writer)
+{
+   mongoc_bulk_writer_batch_t *batch = NULL;
+   int64_t remaining_msec;
+
+   mongoc_mutex_lock (&writer->mutex);
+
+   for (;;) {
+      if (_mongoc_queue_get_length (&writer->pending)) {
+         batch = (mongoc_bulk_writer_batch_t *)
+            _mongoc_queue_pop_head (&writer->pending);
+         writer->in_flight = true;
+         /* an inserter may be waiting for room in the queue */
+         mongoc_cond_broadcast (&writer->done_cond);
+         break;
+      }
+
+      if (writer->shutdown) {
+         break;
+      }
+
+      if (writer->current && writer->flush_interval_msec > 0) {
+         remaining_msec = writer->flush_interval_msec -
+            (bson_get_monotonic_time () - writer->current_started) / 1000;
+
+         if (remaining_msec <= 0) {
+            _mongoc_bulk_writer_seal (writer);
+         } else {
+            mongoc_cond_timedwait (&writer->worker_cond, &writer->mutex,
+                                   remaining_msec);
+         }
+      } else {
+         mongoc_cond_wait (&writer->worker_cond, &writer->mutex);
+      }
+   }
+
+   mongoc_mutex_unlock (&writer->mutex);
+
+   return batch;
+}
+
+
+static void *
+_mongoc_bulk_writer_run (void *data)
+{
+   mongoc_bulk_writer_t *writer = (mongoc_bulk_writer_t *)data;
+   mongoc_bulk_writer_batch_t *batch;
+   mongoc_bulk_writer_cb_t cb;
+   mongoc_client_t *client;
+   void *cb_context;
+   bson_error_t error;
+   bson_t reply;
+   bool ret;
+
+   client = mongoc_client_pool_pop (writer->pool);
+   _mongoc_bulk_writer_learn_limits (writer, client);
+
+   while ((batch = _mongoc_bulk_writer_next_batch (writer))) {
+      mongoc_bulk_operation_set_client (batch->bulk, client);
+      ret = mongoc_bulk_operation_execute (batch->bulk, &reply, &error);
+
+      /* copy the callback under the lock, but don't hold it while the
+       * callback runs: it may call back into the writer */
+      mongoc_mutex_lock (&writer->mutex);
+      cb = writer->cb;
+      cb_context = writer->cb_context;
+      mongoc_mutex_unlock (&writer->mutex);
+
+      if (cb) {
+         cb (batch->first_document, batch->n_documents, &reply,
+             ret ? NULL : &error, cb_context);
+      }
+
+      mongoc_mutex_lock (&writer->mutex);
+      if (!ret && !writer->failed) {
+         writer->failed = true;
+         memcpy (&writer->error, &error, sizeof error);
+      }
+      writer->in_flight = false;
+      mongoc_cond_broadcast (&writer->done_cond);
+      mongoc_mutex_unlock (&writer->mutex);
+
+      bson_destroy (&reply);
+      mongoc_bulk_operation_destroy (batch->bulk);
+      bson_free (batch);
+   }
+
+   mongoc_client_pool_push (writer->pool, client);
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_bulk_writer_new --
+ *
+ *       Create a bulk writer that inserts into @db.@collection and start
+ *       its background thread, which holds one client from @pool until
+ *       the writer is destroyed.
+ *
+ * Returns:
+ *       A newly allocated mongoc_bulk_writer_t that should be freed with
+ *       mongoc_bulk_writer_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_bulk_writer_t *
+mongoc_bulk_writer_new (mongoc_client_pool_t         *pool,
+                        const char                   *db,
+                        const char                   *collection,
+                        bool                          ordered,
+                        const mongoc_write_concern_t *write_concern)
+{
+   mongoc_bulk_writer_t *writer;
+
+   ENTRY;
+
+   BSON_ASSERT (pool);
+   BSON_ASSERT (db);
+   BSON_ASSERT (collection);
+
+   writer = (mongoc_bulk_writer_t *)bson_malloc0 (sizeof *writer);
+   writer->pool = pool;
+   writer->database = bson_strdup (db);
+   writer->collection = bson_strdup (collection);
+   writer->ordered = ordered;
+   writer->write_concern = write_concern ?
+                           mongoc_write_concern_copy (write_concern) :
+                           mongoc_write_concern_new ();
+   writer->max_pending = MONGOC_BULK_WRITER_DEFAULT_MAX_PENDING;
+   writer->max_batch_size = MONGOC_DEFAULT_WRITE_BATCH_SIZE;
+   writer->max_batch_bytes = MONGOC_DEFAULT_MAX_MSG_SIZE;
+
+   mongoc_mutex_init (&writer->mutex);
+   mongoc_cond_init (&writer->worker_cond);
+   mongoc_cond_init (&writer->done_cond);
+   _mongoc_queue_init (&writer->pending);
+
+   mongoc_thread_create (&writer->thread, _mongoc_bulk_writer_run, writer);
+
+   RETURN (writer);
+}
+
+
+void
+mongoc_bulk_writer_set_callback (mongoc_bulk_writer_t    *writer,
+                                 mongoc_bulk_writer_cb_t  cb,
+                                 void                    *context)
+{
+   BSON_ASSERT (writer);
+
+   mongoc_mutex_lock (&writer->mutex);
+   writer->cb = cb;
+   writer->cb_context = context;
+   mongoc_mutex_unlock (&writer->mutex);
+}
+
+
+void
+mongoc_bulk_writer_set_flush_interval (mongoc_bulk_writer_t *writer,
+                                       int32_t               interval_msec)
+{
+   BSON_ASSERT (writer);
+
+   mongoc_mutex_lock (&writer->mutex);
+   writer->flush_interval_msec = interval_msec;
+   mongoc_cond_signal (&writer->worker_cond);
+   mongoc_mutex_unlock (&writer->mutex);
+}
+
+
+void
+mongoc_bulk_writer_set_max_pending (mongoc_bulk_writer_t *writer,
+                                    uint32_t              max_pending)
+{
+   BSON_ASSERT (writer);
+
+   mongoc_mutex_lock (&writer->mutex);
+   writer->max_pending = BSON_MAX (max_pending, 1);
+   mongoc_cond_broadcast (&writer->done_cond);
+   mongoc_mutex_unlock (&writer->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_bulk_writer_insert --
+ *
+ *       Append a copy of @document to the current batch.
+ *
+ * Side effects:
+ *       Blocks while the maximum number of sealed batches are waiting for
+ *       the worker. Seals the current batch if it is full.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_bulk_writer_insert (mongoc_bulk_writer_t *writer,
+                           const bson_t         *document)
+{
+   ENTRY;
+
+   BSON_ASSERT (writer);
+   BSON_ASSERT (document);
+
+   mongoc_mutex_lock (&writer->mutex);
+
+   while (_mongoc_queue_get_length (&writer->pending) >= writer->max_pending) {
+      mongoc_cond_wait (&writer->done_cond, &writer->mutex);
+   }
+
+   if (writer->current &&
+       writer->current_bytes + document->len >
+       (uint32_t) writer->max_batch_bytes) {
+      _mongoc_bulk_writer_seal (writer);
+   }
+
+   if (!writer->current) {
+      writer->current = mongoc_bulk_operation_new (writer->ordered);
+      mongoc_bulk_operation_set_database (writer->current, writer->database);
+      mongoc_bulk_operation_set_collection (writer->current,
+                                            writer->collection);
+      mongoc_bulk_operation_set_write_concern (writer->current,
+                                               writer->write_concern);
+      writer->current_started = bson_get_monotonic_time ();
+      writer->current_first = writer->n_documents;
+
+      /* the worker starts the flush interval timer */
+      mongoc_cond_signal (&writer->worker_cond);
+   }
+
+   mongoc_bulk_operation_insert (writer->current, document);
+   writer->current_n++;
+   writer->current_bytes += document->len;
+   writer->n_documents++;
+
+   if (writer->current_n >= (uint32_t) writer->max_batch_size) {
+      _mongoc_bulk_writer_seal (writer);
+   }
+
+   mongoc_mutex_unlock (&writer->mutex);
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_bulk_writer_flush --
+ *
+ *       Seal the current batch and wait until every batch has been
+ *       written.
+ *
+ * Returns:
+ *       false and fills out @error with the first error since the last
+ *       flush, if any batch failed. Otherwise true.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_bulk_writer_flush (mongoc_bulk_writer_t *writer,
+                          bson_error_t         *error)
+{
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT (writer);
+
+   mongoc_mutex_lock (&writer->mutex);
+
+   _mongoc_bulk_writer_seal (writer);
+
+   while (_mongoc_queue_get_length (&writer->pending) || writer->in_flight) {
+      mongoc_cond_wait (&writer->done_cond, &writer->mutex);
+   }
+
+   ret = !writer->failed;
+   if (!ret && error) {
+      memcpy (error, &writer->error, sizeof *error);
+   }
+
+   writer->failed = false;
+   memset (&writer->error, 0, sizeof writer->error);
+
+   mongoc_mutex_unlock (&writer->mutex);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_bulk_writer_destroy --
+ *
+ *       Write any remaining documents, stop the background thread and
+ *       free the writer. Errors are reported only to the callback; call
+ *       mongoc_bulk_writer_flush() first to check for them.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_bulk_writer_destroy (mongoc_bulk_writer_t *writer)
+{
+   ENTRY;
+
+   if (!writer) {
+      EXIT;
+   }
+
+   mongoc_mutex_lock (&writer->mutex);
+   _mongoc_bulk_writer_seal (writer);
+   writer->shutdown = true;
+   mongoc_cond_signal (&writer->worker_cond);
+   mongoc_mutex_unlock (&writer->mutex);
+
+   mongoc_thread_join (writer->thread);
+
+   mongoc_cond_destroy (&writer->done_cond);
+   mongoc_cond_destroy (&writer->worker_cond);
+   mongoc_mutex_destroy (&writer->mutex);
+   mongoc_write_concern_destroy (writer->write_concern);
+   bson_free (writer->collection);
+   bson_free (writer->database);
+   bson_free (writer);
+
+   EXIT;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_BULK_WRITER_H
+#define MONGOC_BULK_WRITER_H
+
+#if !defined (MONGOC_INSIDE) && !defined (MONGOC_COMPILATION)
+# error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client-pool.h"
+#include "mongoc-write-concern.h"
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_bulk_writer_t mongoc_bulk_writer_t;
+
+/* error is NULL if the batch succeeded */
+typedef void (*mongoc_bulk_writer_cb_t) (int64_t             first_document,
+                                         uint32_t            n_documents,
+                                         const bson_t       *reply,
+                                         const bson_error_t *error,
+                                         void               *context);
+
+
+mongoc_bulk_writer_t *mongoc_bulk_writer_new                (mongoc_client_pool_t         *pool,
+                                                             const char                   *db,
+                                                             const char                   *collection,
+                                                             bool                          ordered,
+                                                             const mongoc_write_concern_t *write_concern);
+void                  mongoc_bulk_writer_set_callback       (mongoc_bulk_writer_t         *writer,
+                                                             mongoc_bulk_writer_cb_t       cb,
+                                                             void                         *context);
+void                  mongoc_bulk_writer_set_flush_interval (mongoc_bulk_writer_t         *writer,
+                                                             int32_t                       interval_msec);
+void                  mongoc_bulk_writer_set_max_pending    (mongoc_bulk_writer_t         *writer,
+                                                             uint32_t                      max_pending);
+void                  mongoc_bulk_writer_insert             (mongoc_bulk_writer_t         *writer,
+                                                             const bson_t                 *document);
+bool                  mongoc_bulk_writer_flush              (mongoc_bulk_writer_t         *writer,
+                                                             bson_error_t                 *error);
+void                  mongoc_bulk_writer_destroy            (mongoc_bulk_writer_t         *writer);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_BULK_WRITER_H */
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MONGOC_CHANGE_STREAM_PRIVATE_H
+#define MONGOC_CHANGE_STREAM_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-change-stream.h"
+#include "mongoc-collection.h"
+#include "mongoc-cursor.h"
+
+
+BSON_BEGIN_DECLS
+
+
+struct _mongoc_change_stream_t
+{
+   mongoc_collection_t *collection;
+   mongoc_cursor_t     *cursor;
+   bson_t               pipeline;
+   char                *full_document;
+   bson_t               resume_token;
+   int32_t              batch_size;
+   uint32_t             max_await_time_ms;
+   bson_error_t         error;
+};
+
+
+mongoc_change_stream_t *_mongoc_change_stream_new (mongoc_collection_t *collection,
+                                                   const bson_t        *pipeline,
+                                                   const bson_t        *opts);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_CHANGE_STREAM_PRIVATE_H */
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-change-stream-private.h"
+#include "mongoc-error.h"
+#include "mongoc-trace.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "change-stream"
+
+
+/* Change Streams Spec: errors that make the driver resume the stream once,
+ * besides network errors: CursorNotFound and the "not master" or "node is
+ * recovering" family */
+static const uint32_t gResumableCodes[] = {
+   6, 7, 43, 89, 91, 189, 9001, 10107, 11600, 11602, 13435, 13436,
+};
+
+
+static bool
+_mongoc_change_stream_resumable (const bson_error_t *error)
+{
+   size_t i;
+
+   if (error->domain == MONGOC_ERROR_STREAM) {
+      return true;
+   }
+
+   if (error->domain != MONGOC_ERROR_QUERY &&
+       error->domain != MONGOC_ERROR_SERVER) {
+      return false;
+   }
+
+   for (i = 0; i < sizeof gResumableCodes / sizeof gResumableCodes[0]; i++) {
+      if (error->code == gResumableCodes[i]) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_change_stream_make_cursor --
+ *
+ *       Open an aggregate cursor whose pipeline begins with $changeStream,
+ *       resuming after the last change we returned, if any. Server
+ *       selection runs again, so after a network error the cursor is
+ *       opened on whichever server is now suitable.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       Replaces @stream->cursor. Errors are reported by the cursor.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_change_stream_make_cursor (mongoc_change_stream_t *stream)
+{
+   bson_t command = BSON_INITIALIZER;
+   bson_t opts = BSON_INITIALIZER;
+   bson_t pipeline;
+   bson_t stage;
+   bson_t change_stream;
+   bson_iter_t iter;
+   const char *key;
+   char buf[16];
+   uint32_t i = 0;
+
+   ENTRY;
+
+   bson_append_array_begin (&command, "pipeline", 8, &pipeline);
+   bson_append_document_begin (&pipeline, "0", 1, &stage);
+   bson_append_document_begin (&stage, "$changeStream", 13, &change_stream);
+
+   if (stream->full_document) {
+      BSON_APPEND_UTF8 (&change_stream, "fullDocument", stream->full_document);
+   }
+
+   if (!bson_empty (&stream->resume_token)) {
+      BSON_APPEND_DOCUMENT (&change_stream, "resumeAfter",
+                            &stream->resume_token);
+   }
+
+   bson_append_document_end (&stage, &change_stream);
+   bson_append_document_end (&pipeline, &stage);
+
+   if (bson_iter_init (&iter, &stream->pipeline)) {
+      while (bson_iter_next (&iter)) {
+         bson_uint32_to_string (++i, &key, buf, sizeof buf);
+         bson_append_iter (&pipeline, key, -1, &iter);
+      }
+   }
+
+   bson_append_array_end (&command, &pipeline);
+
+   if (stream->batch_size) {
+      BSON_APPEND_INT32 (&opts, "batchSize", stream->batch_size);
+   }
+
+   stream->cursor = mongoc_collection_aggregate (
+      stream->collection,
+      (mongoc_query_flags_t) (MONGOC_QUERY_TAILABLE_CURSOR |
+                              MONGOC_QUERY_AWAIT_DATA),
+      &command, &opts, NULL);
+
+   /* applies to getMore; the initial aggregate's batchSize is in opts */
+   if (stream->batch_size) {
+      mongoc_cursor_set_batch_size (stream->cursor,
+                                    (uint32_t) stream->batch_size);
+   }
+
+   if (stream->max_await_time_ms) {
+      mongoc_cursor_set_max_await_time_ms (stream->cursor,
+                                           stream->max_await_time_ms);
+   }
+
+   bson_destroy (&opts);
+   bson_destroy (&command);
+
+   EXIT;
+}
+
+
+mongoc_change_stream_t *
+_mongoc_change_stream_new (mongoc_collection_t *collection,
+                           const bson_t        *pipeline,
+                           const bson_t        *opts)
+{
+   mongoc_change_stream_t *stream;
+   bson_iter_t iter;
+   bson_t doc;
+   uint32_t len;
+   const uint8_t *data;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   stream = (mongoc_change_stream_t *) bson_malloc0 (sizeof *stream);
+   stream->collection = mongoc_collection_copy (collection);
+   bson_init (&stream->resume_token);
+
+   /* like mongoc_collection_aggregate, accept [...] or {pipeline: [...]} */
+   if (pipeline &&
+       bson_iter_init_find (&iter, pipeline, "pipeline") &&
+       BSON_ITER_HOLDS_ARRAY (&iter)) {
+      bson_iter_array (&iter, &len, &data);
+      bson_init_static (&doc, data, len);
+      bson_copy_to (&doc, &stream->pipeline);
+   } else if (pipeline) {
+      bson_copy_to (pipeline, &stream->pipeline);
+   } else {
+      bson_init (&stream->pipeline);
+   }
+
+   if (opts && bson_iter_init (&iter, opts)) {
+      while (bson_iter_next (&iter)) {
+         if (BSON_ITER_IS_KEY (&iter, "fullDocument") &&
+             BSON_ITER_HOLDS_UTF8 (&iter)) {
+            bson_free (stream->full_document);
+            stream->full_document = bson_strdup (bson_iter_utf8 (&iter, NULL));
+         } else if (BSON_ITER_IS_KEY (&iter, "resumeAfter") &&
+                    BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+            bson_iter_document (&iter, &len, &data);
+            bson_init_static (&doc, data, len);
+            bson_destroy (&stream->resume_token);
+            bson_copy_to (&doc, &stream->resume_token);
+         } else if (BSON_ITER_IS_KEY (&iter, "batchSize") &&
+                    (BSON_ITER_HOLDS_INT32 (&iter) ||
+                     BSON_ITER_HOLDS_INT64 (&iter))) {
+            stream->batch_size = (int32_t) bson_iter_as_int64 (&iter);
+         } else if (BSON_ITER_IS_KEY (&iter, "maxAwaitTimeMS") &&
+                    (BSON_ITER_HOLDS_INT32 (&iter) ||
+                     BSON_ITER_HOLDS_INT64 (&iter))) {
+            stream->max_await_time_ms = (uint32_t) bson_iter_as_int64 (&iter);
+         } else {
+            bson_set_error (&stream->error,
+                            MONGOC_ERROR_COMMAND,
+                            MONGOC_ERROR_COMMAND_INVALID_ARG,
+                            "Invalid change stream option \"%s\"",
+                            bson_iter_key (&iter));
+            RETURN (stream);
+         }
+      }
+   }
+
+   _mongoc_change_stream_make_cursor (stream);
+
+   RETURN (stream);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_change_stream_next --
+ *
+ *       Get the next change. If the server has no new changes within
+ *       maxAwaitTimeMS, returns false without an error; call again to
+ *       keep waiting.
+ *
+ *       On a network error, or a server error that indicates the server
+ *       stepped down or lost our cursor, the stream is resumed once from
+ *       the last change returned, on a newly selected server.
+ *
+ * Returns:
+ *       true if @bson was set to a change document, which is valid until
+ *       the next call.
+ *
+ * Side effects:
+ *       Records the change's resume token.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_change_stream_next (mongoc_change_stream_t *stream,
+                           const bson_t          **bson)
+{
+   bson_iter_t iter;
+   bson_error_t error;
+   bson_t token;
+   uint32_t len;
+   const uint8_t *data;
+   bool resumed = false;
+
+   ENTRY;
+
+   BSON_ASSERT (stream);
+   BSON_ASSERT (bson);
+
+   *bson = NULL;
+
+   if (stream->error.domain) {
+      RETURN (false);
+   }
+
+again:
+   if (mongoc_cursor_next (stream->cursor, bson)) {
+      if (!bson_iter_init_find (&iter, *bson, "_id") ||
+          !BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+         bson_set_error (&stream->error,
+                         MONGOC_ERROR_CURSOR,
+                         MONGOC_ERROR_CHANGE_STREAM_NO_RESUME_TOKEN,
+                         "Cannot provide resume functionality when the"
+                         " resume token is missing");
+         *bson = NULL;
+         RETURN (false);
+      }
+
+      bson_iter_document (&iter, &len, &data);
+      bson_init_static (&token, data, len);
+      bson_destroy (&stream->resume_token);
+      bson_copy_to (&token, &stream->resume_token);
+
+      RETURN (true);
+   }
+
+   if (!mongoc_cursor_error (stream->cursor, &error)) {
+      /* no changes within maxAwaitTimeMS */
+      RETURN (false);
+   }
+
+   if (!resumed && _mongoc_change_stream_resumable (&error)) {
+      resumed = true;
+      mongoc_cursor_destroy (stream->cursor);
+      _mongoc_change_stream_make_cursor (stream);
+      GOTO (again);
+   }
+
+   memcpy (&stream->error, &error, sizeof error);
+
+   RETURN (false);
+}
+
+
+bool
+mongoc_change_stream_error (const mongoc_change_stream_t *stream,
+                            bson_error_t                 *error)
+{
+   BSON_ASSERT (stream);
+
+   if (stream->error.domain) {
+      if (error) {
+         memcpy (error, &stream->error, sizeof *error);
+      }
+
+      return true;
+   }
+
+   return false;
+}
+
+
+/*
+ * The "_id" of the last change returned, or the "resumeAfter" option if no
+ * change has been returned yet. Pass it as "resumeAfter" to a new change
+ * stream to continue where this one stopped.
+ */
+const bson_t *
+mongoc_change_stream_get_resume_token (const mongoc_change_stream_t *stream)
+{
+   BSON_ASSERT (stream);
+
+   if (bson_empty (&stream->resume_token)) {
+      return NULL;
+   }
+
+   return &stream->resume_token;
+}
+
+
+void
+mongoc_change_stream_destroy (mongoc_change_stream_t *stream)
+{
+   if (stream) {
+      if (stream->cursor) {
+         mongoc_cursor_destroy (stream->cursor);
+      }
+
+      mongoc_collection_destroy (stream->collection);
+      bson_destroy (&stream->pipeline);
+      bson_destroy (&stream->resume_token);
+      bson_free (stream->full_document);
+      bson_free (stream);
+   }
+}
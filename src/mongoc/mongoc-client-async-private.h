@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MONGOC_CLIENT_ASYNC_PRIVATE_H
+#define MONGOC_CLIENT_ASYNC_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-async-private.h"
+#include "mongoc-client-async.h"
+#include "mongoc-stream.h"
+
+
+BSON_BEGIN_DECLS
+
+
+#define MONGOC_CLIENT_ASYNC_DEFAULT_MAX_CONNECTIONS 2
+
+
+typedef struct _mongoc_client_async_conn_t
+{
+   uint32_t                            server_id;
+   mongoc_stream_t                    *stream;
+   /* stream is polled, read and written below any buffering layer */
+   mongoc_stream_t                    *io_stream;
+   mongoc_async_pipeline_t             pipeline;
+   uint32_t                            n_pending;
+   struct _mongoc_client_async_conn_t *next;
+} mongoc_client_async_conn_t;
+
+
+typedef struct
+{
+   mongoc_client_async_t      *async;
+   mongoc_client_async_conn_t *conn;
+   mongoc_client_async_cb_t    cb;
+   void                       *context;
+} mongoc_client_async_op_t;
+
+
+struct _mongoc_client_async_t
+{
+   mongoc_client_t            *client;
+   mongoc_async_t             *async;
+   mongoc_client_async_conn_t *conns;
+   uint32_t                    max_connections;
+   /* a topology scan begun by mongoc_client_async_scan is in progress */
+   bool                        scanning;
+};
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_CLIENT_ASYNC_PRIVATE_H */
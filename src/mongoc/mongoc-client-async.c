@@ -0,0 +1,573 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-async-cmd-private.h"
+#include "mongoc-client-async.h"
+#include "mongoc-client-async-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
+#include "mongoc-error.h"
+#include "mongoc-read-prefs-private.h"
+#include "mongoc-rpc-private.h"
+#include "mongoc-server-stream-private.h"
+#include "mongoc-stream-private.h"
+#include "mongoc-topology-private.h"
+#include "mongoc-trace.h"
+#include "utlist.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "client-async"
+
+
+/*
+ * An async client sends commands without waiting for their replies, on
+ * connections of its own to each server, and calls each command's callback
+ * from mongoc_client_async_run once the reply arrives. Commands to a server
+ * are spread over at most max_connections connections, and pipelined on
+ * each: a connection sends the next command while earlier replies are
+ * pending, and reads the replies in order. TLS connections send one
+ * command at a time, since decrypted bytes of the next reply could wait in
+ * the TLS layer where polling the socket can't see them.
+ *
+ * Connections are opened, with ismaster and authentication, the first
+ * time they are needed; this and server selection block.
+ *
+ * Applications with an event loop of their own don't call
+ * mongoc_client_async_run: they watch the sockets and deadline from
+ * mongoc_client_async_get_sockets and mongoc_client_async_get_timeout, and
+ * call mongoc_client_async_step when either fires. A single-threaded
+ * client's topology scans can be driven the same way, so that server
+ * selection finds a fresh topology and needn't block to scan.
+ */
+
+
+mongoc_client_async_t *
+mongoc_client_async_new (mongoc_client_t *client)
+{
+   mongoc_client_async_t *async;
+
+   BSON_ASSERT (client);
+
+   async = (mongoc_client_async_t *)bson_malloc0 (sizeof *async);
+   async->client = client;
+   async->async = mongoc_async_new ();
+   async->max_connections = MONGOC_CLIENT_ASYNC_DEFAULT_MAX_CONNECTIONS;
+
+   return async;
+}
+
+
+void
+mongoc_client_async_set_max_connections (mongoc_client_async_t *async,
+                                         uint32_t               max_connections)
+{
+   BSON_ASSERT (async);
+
+   async->max_connections = BSON_MAX (max_connections, 1);
+}
+
+
+static void
+_mongoc_client_async_conn_destroy (mongoc_client_async_conn_t *conn)
+{
+   mongoc_stream_destroy (conn->stream);
+   bson_free (conn);
+}
+
+
+/* close connections that failed, once no command refers to them */
+static void
+_mongoc_client_async_reap (mongoc_client_async_t *async)
+{
+   mongoc_client_async_conn_t *conn, *tmp;
+
+   LL_FOREACH_SAFE (async->conns, conn, tmp)
+   {
+      if (conn->pipeline.failed && !conn->n_pending) {
+         LL_DELETE (async->conns, conn);
+         _mongoc_client_async_conn_destroy (conn);
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_async_get_conn --
+ *
+ *       The connection to @server_id with the fewest pending commands. A
+ *       new connection is opened if there is none idle and fewer than
+ *       max_connections are open.
+ *
+ * Returns:
+ *       A connection, or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_client_async_conn_t *
+_mongoc_client_async_get_conn (mongoc_client_async_t *async,
+                               uint32_t               server_id,
+                               bson_error_t          *error)
+{
+   mongoc_client_async_conn_t *conn;
+   mongoc_client_async_conn_t *best = NULL;
+   mongoc_stream_t *stream;
+   uint32_t n = 0;
+
+   LL_FOREACH (async->conns, conn)
+   {
+      if (conn->server_id != server_id || conn->pipeline.failed) {
+         continue;
+      }
+
+      n++;
+
+      if (!best || conn->n_pending < best->n_pending) {
+         best = conn;
+      }
+   }
+
+   if (best && (!best->n_pending || n >= async->max_connections)) {
+      return best;
+   }
+
+   stream = _mongoc_cluster_connect_server (&async->client->cluster,
+                                            server_id, error);
+   if (!stream) {
+      /* make do with the connections we have */
+      return best;
+   }
+
+   conn = (mongoc_client_async_conn_t *)bson_malloc0 (sizeof *conn);
+   conn->server_id = server_id;
+   conn->stream = stream;
+
+   /* the handshake left nothing in a buffered stream's buffer, so read
+    * below it: its buffer would hide later replies from poll */
+   if (stream->type == MONGOC_STREAM_BUFFERED) {
+      conn->io_stream = mongoc_stream_get_base_stream (stream);
+   } else {
+      conn->io_stream = stream;
+   }
+
+   conn->pipeline.serial = mongoc_stream_get_tls_stream (stream) != NULL;
+
+   LL_PREPEND (async->conns, conn);
+
+   return conn;
+}
+
+
+static void
+_mongoc_client_async_cmd_cb (mongoc_async_cmd_result_t result,
+                             const bson_t             *bson,
+                             int64_t                   rtt_msec,
+                             void                     *data,
+                             bson_error_t             *error)
+{
+   mongoc_client_async_op_t *op = (mongoc_client_async_op_t *)data;
+   bson_error_t cmd_error = { 0 };
+
+   op->conn->n_pending--;
+
+   switch (result) {
+   case MONGOC_ASYNC_CMD_SUCCESS:
+      if (_mongoc_populate_cmd_error (bson,
+                                      op->async->client->error_api_version,
+                                      &cmd_error)) {
+         op->cb (bson, &cmd_error, op->context);
+      } else {
+         op->cb (bson, NULL, op->context);
+      }
+      break;
+   case MONGOC_ASYNC_CMD_TIMEOUT:
+      bson_set_error (&cmd_error, MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_SOCKET,
+                      "Timed out waiting for reply.");
+      op->conn->pipeline.failed = true;
+      op->cb (NULL, &cmd_error, op->context);
+      break;
+   case MONGOC_ASYNC_CMD_IN_PROGRESS:
+   case MONGOC_ASYNC_CMD_ERROR:
+   default:
+      if (error && error->code) {
+         memcpy (&cmd_error, error, sizeof cmd_error);
+      } else {
+         bson_set_error (&cmd_error, MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "Connection failed.");
+      }
+      op->conn->pipeline.failed = true;
+      op->cb (NULL, &cmd_error, op->context);
+      break;
+   }
+
+   bson_free (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_async_command_with_sd --
+ *
+ *       Queue @command on a connection to @sd, which becomes owned.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_client_async_command_with_sd (mongoc_client_async_t       *async,
+                                      mongoc_server_description_t *sd,
+                                      const char                  *db_name,
+                                      const bson_t                *command,
+                                      const mongoc_read_prefs_t   *read_prefs,
+                                      int32_t                      timeout_msec,
+                                      mongoc_client_async_cb_t     cb,
+                                      void                        *context,
+                                      bson_error_t                *error)
+{
+   mongoc_client_async_conn_t *conn;
+   mongoc_client_async_op_t *op;
+   mongoc_server_stream_t *server_stream;
+   mongoc_apply_read_prefs_result_t result = READ_PREFS_RESULT_INIT;
+   mongoc_async_cmd_t *acmd;
+
+   ENTRY;
+
+   conn = _mongoc_client_async_get_conn (async, sd->id, error);
+   if (!conn) {
+      mongoc_server_description_destroy (sd);
+      RETURN (false);
+   }
+
+   if (timeout_msec <= 0) {
+      timeout_msec = (int32_t) async->client->cluster.sockettimeoutms;
+   }
+
+   /* sd becomes owned by server_stream */
+   server_stream = mongoc_server_stream_new (
+      async->client->topology->description.type, sd, conn->stream);
+
+   apply_read_preferences (read_prefs, server_stream, command,
+                           MONGOC_QUERY_NONE, &result);
+
+   op = (mongoc_client_async_op_t *)bson_malloc (sizeof *op);
+   op->async = async;
+   op->conn = conn;
+   op->cb = cb;
+   op->context = context;
+
+   acmd = mongoc_async_cmd (async->async, conn->io_stream, NULL, NULL,
+                            db_name, result.query_with_read_prefs,
+                            _mongoc_client_async_cmd_cb, op, timeout_msec);
+
+   mongoc_async_cmd_set_pipeline (acmd, &conn->pipeline);
+   conn->n_pending++;
+
+   apply_read_prefs_result_cleanup (&result);
+   mongoc_server_stream_cleanup (server_stream);
+
+   RETURN (true);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_command --
+ *
+ *       Select a server with @read_prefs, default primary, and send it
+ *       @command. @cb is called from mongoc_client_async_run with the
+ *       reply, or with an error if the command fails, no reply arrives
+ *       within @timeout_msec (socketTimeoutMS if 0), or @async is
+ *       destroyed first.
+ *
+ * Returns:
+ *       false and sets @error if no server could be selected or
+ *       connected to; @cb is not called.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_async_command (mongoc_client_async_t     *async,
+                             const char                *db_name,
+                             const bson_t              *command,
+                             const mongoc_read_prefs_t *read_prefs,
+                             int32_t                    timeout_msec,
+                             mongoc_client_async_cb_t   cb,
+                             void                      *context,
+                             bson_error_t              *error)
+{
+   mongoc_read_prefs_t *local_prefs = NULL;
+   mongoc_server_description_t *sd;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (async);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+   BSON_ASSERT (cb);
+
+   if (!read_prefs) {
+      local_prefs = mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+      read_prefs = local_prefs;
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      GOTO (done);
+   }
+
+   sd = mongoc_topology_select (async->client->topology, MONGOC_SS_READ,
+                                read_prefs, error);
+   if (!sd) {
+      GOTO (done);
+   }
+
+   ret = _mongoc_client_async_command_with_sd (async, sd, db_name, command,
+                                               read_prefs, timeout_msec,
+                                               cb, context, error);
+
+done:
+   mongoc_read_prefs_destroy (local_prefs);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_run --
+ *
+ *       Send commands and read replies as the connections allow, calling
+ *       callbacks as commands complete, until none are pending or
+ *       @timeout_msec passes. Pass -1 to wait for all pending commands.
+ *       Callbacks may send more commands.
+ *
+ * Returns:
+ *       true if commands are still pending.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_async_run (mongoc_client_async_t *async,
+                         int32_t                timeout_msec)
+{
+   bool ret;
+
+   BSON_ASSERT (async);
+
+   ret = mongoc_async_run (async->async, timeout_msec);
+
+   _mongoc_client_async_reap (async);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_get_sockets --
+ *
+ *       Store in @sds the sockets that pending commands, and a scan begun
+ *       with mongoc_client_async_scan, wait on, with the events to watch
+ *       for.
+ *
+ * Returns:
+ *       The number of sockets. If more than @n_sds, call again with an
+ *       array of at least that many.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+mongoc_client_async_get_sockets (mongoc_client_async_t *async,
+                                 mongoc_socket_poll_t  *sds,
+                                 size_t                 n_sds)
+{
+   size_t n;
+
+   BSON_ASSERT (async);
+   BSON_ASSERT (sds || !n_sds);
+
+   n = mongoc_async_get_sockets (async->async, sds, n_sds, 0);
+
+   if (async->scanning) {
+      n = mongoc_async_get_sockets (async->client->topology->scanner->async,
+                                    sds, n_sds, n);
+   }
+
+   return n;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_get_timeout --
+ *
+ *       Milliseconds until the next command or server check times out,
+ *       when mongoc_client_async_step must be called even if no socket is
+ *       ready.
+ *
+ * Returns:
+ *       The timeout, 0 if it has passed, or -1 if nothing is pending.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int32_t
+mongoc_client_async_get_timeout (mongoc_client_async_t *async)
+{
+   int64_t expire_at;
+   int64_t scan_expire_at;
+   int64_t now;
+
+   BSON_ASSERT (async);
+
+   expire_at = mongoc_async_get_expire_at (async->async);
+
+   if (async->scanning) {
+      scan_expire_at = mongoc_async_get_expire_at (
+         async->client->topology->scanner->async);
+
+      if (expire_at < 0 ||
+          (scan_expire_at >= 0 && scan_expire_at < expire_at)) {
+         expire_at = scan_expire_at;
+      }
+
+      if (expire_at < 0) {
+         /* the scan checks no servers, the next step ends it */
+         return 0;
+      }
+   }
+
+   if (expire_at < 0) {
+      return -1;
+   }
+
+   now = bson_get_monotonic_time ();
+
+   if (expire_at <= now) {
+      return 0;
+   }
+
+   /* round up, so the deadline has passed when the caller's timer fires */
+   return (int32_t) BSON_MIN ((expire_at - now + 999) / 1000, INT32_MAX);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_step --
+ *
+ *       Advance the commands and server checks waiting on the sockets in
+ *       @sds whose revents are set, and time out expired ones, calling
+ *       callbacks as commands complete. Never blocks. Pass no sockets
+ *       when only the timeout has fired.
+ *
+ * Returns:
+ *       true if commands or a scan are still pending.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_async_step (mongoc_client_async_t      *async,
+                          const mongoc_socket_poll_t *sds,
+                          size_t                      n_sds)
+{
+   bool ret;
+
+   BSON_ASSERT (async);
+   BSON_ASSERT (sds || !n_sds);
+
+   ret = mongoc_async_step (async->async, sds, n_sds);
+
+   if (async->scanning) {
+      async->scanning = _mongoc_topology_scan_step (async->client->topology,
+                                                    sds, n_sds);
+   }
+
+   _mongoc_client_async_reap (async);
+
+   return ret || async->scanning;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_async_scan --
+ *
+ *       Begin checking the servers of a single-threaded client's topology,
+ *       driven by mongoc_client_async_step. Does nothing if a scan is in
+ *       progress, or for a pooled client, whose servers are checked by a
+ *       background thread.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_client_async_scan (mongoc_client_async_t *async)
+{
+   BSON_ASSERT (async);
+
+   if (!async->scanning) {
+      async->scanning = _mongoc_topology_scan_begin (async->client->topology);
+   }
+}
+
+void
+mongoc_client_async_destroy (mongoc_client_async_t *async)
+{
+   mongoc_client_async_conn_t *conn, *tmp;
+   mongoc_async_cmd_t *acmd;
+
+   if (!async) {
+      return;
+   }
+
+   /* pending commands complete with an error */
+   while (async->async->cmds) {
+      acmd = async->async->cmds;
+      bson_set_error (&acmd->error, MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_NOT_ESTABLISHED,
+                      "The async client was destroyed.");
+      acmd->cb (MONGOC_ASYNC_CMD_ERROR, NULL, 0, acmd->data, &acmd->error);
+      mongoc_async_cmd_destroy (acmd);
+   }
+
+   mongoc_async_destroy (async->async);
+
+   LL_FOREACH_SAFE (async->conns, conn, tmp)
+   {
+      _mongoc_client_async_conn_destroy (conn);
+   }
+
+   bson_free (async);
+}
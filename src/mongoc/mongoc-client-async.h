@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_CLIENT_ASYNC_H
+#define MONGOC_CLIENT_ASYNC_H
+
+#if !defined (MONGOC_INSIDE) && !defined (MONGOC_COMPILATION)
+# error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client.h"
+#include "mongoc-read-prefs.h"
+#include "mongoc-socket.h"
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_client_async_t mongoc_client_async_t;
+
+/* reply is NULL if no reply was received, error is NULL on success */
+typedef void (*mongoc_client_async_cb_t) (const bson_t       *reply,
+                                          const bson_error_t *error,
+                                          void               *context);
+
+
+mongoc_client_async_t *mongoc_client_async_new                 (mongoc_client_t            *client);
+void                   mongoc_client_async_set_max_connections (mongoc_client_async_t      *async,
+                                                                uint32_t                    max_connections);
+bool                   mongoc_client_async_command             (mongoc_client_async_t      *async,
+                                                                const char                 *db_name,
+                                                                const bson_t               *command,
+                                                                const mongoc_read_prefs_t  *read_prefs,
+                                                                int32_t                     timeout_msec,
+                                                                mongoc_client_async_cb_t    cb,
+                                                                void                       *context,
+                                                                bson_error_t               *error);
+bool                   mongoc_client_async_run                 (mongoc_client_async_t      *async,
+                                                                int32_t                     timeout_msec);
+size_t                 mongoc_client_async_get_sockets         (mongoc_client_async_t      *async,
+                                                                mongoc_socket_poll_t       *sds,
+                                                                size_t                      n_sds);
+int32_t                mongoc_client_async_get_timeout         (mongoc_client_async_t      *async);
+bool                   mongoc_client_async_step                (mongoc_client_async_t      *async,
+                                                                const mongoc_socket_poll_t *sds,
+                                                                size_t                      n_sds);
+void                   mongoc_client_async_scan                (mongoc_client_async_t      *async);
+void                   mongoc_client_async_destroy             (mongoc_client_async_t      *async);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_CLIENT_ASYNC_H */
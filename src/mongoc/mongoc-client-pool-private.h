@@ -24,10 +24,12 @@
 #include <bson.h>
 
 #include "mongoc-client-pool.h"
+#include "mongoc-topology-private.h"
 
 BSON_BEGIN_DECLS
 
 size_t 				  mongoc_client_pool_get_size(mongoc_client_pool_t *pool);
+mongoc_topology_t *_mongoc_client_pool_get_topology (mongoc_client_pool_t *pool);
 
 BSON_END_DECLS
 
@@ -17,10 +17,13 @@
 
 #include "mongoc.h"
 #include "mongoc-apm-private.h"
+#include "mongoc-buffer-pool-private.h"
 #include "mongoc-counters-private.h"
 #include "mongoc-client-pool-private.h"
 #include "mongoc-client-pool.h"
 #include "mongoc-client-private.h"
+#include "mongoc-mux-private.h"
+#include "mongoc-single-flight-private.h"
 #include "mongoc-queue-private.h"
 #include "mongoc-thread-private.h"
 #include "mongoc-topology-private.h"
@@ -47,6 +50,10 @@ struct _mongoc_client_pool_t
    mongoc_apm_callbacks_t  apm_callbacks;
    void                   *apm_context;
    int32_t                 error_api_version;
+   mongoc_buffer_pool_t   *buffer_pool;
+   mongoc_write_combiner_t *write_combiner;
+   mongoc_mux_t           *mux;
+   mongoc_single_flight_t *single_flight;
 };
 
 
@@ -107,6 +114,13 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
    topology = mongoc_topology_new(uri, false);
    pool->topology = topology;
    pool->error_api_version = MONGOC_ERROR_API_VERSION_LEGACY;
+   /* retains nothing until mongoc_client_pool_set_max_buffer_bytes */
+   pool->buffer_pool = _mongoc_buffer_pool_new (0);
+   /* combines nothing until mongoc_client_pool_set_write_combining */
+   pool->write_combiner = _mongoc_write_combiner_new ();
+   /* shares no connections until mongoc_client_pool_set_max_shared_connections */
+   pool->mux = _mongoc_mux_new ();
+   pool->single_flight = _mongoc_single_flight_new ();
 
    b = mongoc_uri_get_options(pool->uri);
 
@@ -137,11 +151,22 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
 
    BSON_ASSERT (pool);
 
+   /* kill cursors still waiting in the deferred queue */
+   client = (mongoc_client_t *)_mongoc_queue_pop_head (&pool->queue);
+   if (client) {
+      _mongoc_client_kill_cursors_flush (client, true /* force */);
+      mongoc_client_destroy (client);
+   }
+
    while ((client = (mongoc_client_t *)_mongoc_queue_pop_head(&pool->queue))) {
       mongoc_client_destroy(client);
    }
 
+   _mongoc_mux_destroy (pool->mux);
    mongoc_topology_destroy (pool->topology);
+   _mongoc_buffer_pool_destroy (pool->buffer_pool);
+   _mongoc_write_combiner_destroy (pool->write_combiner);
+   _mongoc_single_flight_destroy (pool->single_flight);
 
    mongoc_uri_destroy(pool->uri);
    mongoc_mutex_destroy(&pool->mutex);
@@ -190,6 +215,9 @@ again:
       if (pool->size < pool->max_pool_size) {
          client = _mongoc_client_new_from_uri(pool->uri, pool->topology);
          client->error_api_version = pool->error_api_version;
+         client->buffer_pool = pool->buffer_pool;
+         client->write_combiner = pool->write_combiner;
+         client->single_flight = pool->single_flight;
          _mongoc_client_set_apm_callbacks_private (client,
                                                    &pool->apm_callbacks,
                                                    pool->apm_context);
@@ -226,6 +254,9 @@ mongoc_client_pool_try_pop (mongoc_client_pool_t *pool)
    if (!(client = (mongoc_client_t *)_mongoc_queue_pop_head(&pool->queue))) {
       if (pool->size < pool->max_pool_size) {
          client = _mongoc_client_new_from_uri(pool->uri, pool->topology);
+         client->buffer_pool = pool->buffer_pool;
+         client->write_combiner = pool->write_combiner;
+         client->single_flight = pool->single_flight;
 #ifdef MONGOC_ENABLE_SSL
          if (pool->ssl_opts_set) {
             mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
@@ -248,11 +279,22 @@ void
 mongoc_client_pool_push (mongoc_client_pool_t *pool,
                          mongoc_client_t      *client)
 {
+   bson_error_t error;
+
    ENTRY;
 
    BSON_ASSERT (pool);
    BSON_ASSERT (client);
 
+   /* the next thread to pop the client may never write again */
+   if (!_mongoc_cluster_flush_unacknowledged (&client->cluster, &error)) {
+      MONGOC_WARNING ("Failed to send unacknowledged writes: %s",
+                      error.message);
+   }
+
+   /* the client is idle, let it kill deferred cursors that are due */
+   _mongoc_client_kill_cursors_flush (client, false /* force */);
+
    mongoc_mutex_lock(&pool->mutex);
    if (pool->min_pool_size && pool->size > pool->min_pool_size) {
       mongoc_client_t *old_client;
@@ -271,6 +313,15 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool,
    EXIT;
 }
 
+mongoc_topology_t *
+_mongoc_client_pool_get_topology (mongoc_client_pool_t *pool)
+{
+   BSON_ASSERT (pool);
+
+   return pool->topology;
+}
+
+
 size_t
 mongoc_client_pool_get_size (mongoc_client_pool_t *pool)
 {
@@ -311,6 +362,132 @@ mongoc_client_pool_min_size(mongoc_client_pool_t *pool,
    EXIT;
 }
 
+void
+mongoc_client_pool_set_max_buffer_bytes (mongoc_client_pool_t *pool,
+                                         size_t                max_bytes)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_buffer_pool_set_max_bytes (pool->buffer_pool, max_bytes);
+}
+
+
+void
+mongoc_client_pool_set_deferred_kill_cursors (mongoc_client_pool_t *pool,
+                                              int32_t               delay_msec,
+                                              uint32_t              max_cursors)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_kill_cursors_queue_set (&pool->topology->kill_cursors,
+                                   delay_msec, max_cursors);
+}
+
+void
+mongoc_client_pool_set_write_combining (mongoc_client_pool_t *pool,
+                                        int32_t               window_usec)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_write_combiner_set_window (pool->write_combiner, window_usec);
+}
+
+void
+mongoc_client_pool_set_max_shared_connections (mongoc_client_pool_t *pool,
+                                               uint32_t              max_connections)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_mux_set_max_connections (pool->mux, max_connections);
+}
+
+void
+mongoc_client_pool_set_read_coalescing (mongoc_client_pool_t *pool,
+                                        bool                  enabled)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_single_flight_set_enabled (pool->single_flight, enabled);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_pool_command_simple --
+ *
+ *       Run a command from any thread without popping a client. With
+ *       shared connections enabled, concurrent commands are multiplexed
+ *       over at most max_shared_connections connections per server.
+ *       Otherwise a client is popped for the command.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @reply is always initialized.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_pool_command_simple (mongoc_client_pool_t      *pool,
+                                   const char                *db_name,
+                                   const bson_t              *command,
+                                   const mongoc_read_prefs_t *read_prefs,
+                                   bson_t                    *reply,
+                                   bson_error_t              *error)
+{
+   mongoc_read_prefs_t *local_prefs = NULL;
+   mongoc_client_t *client;
+   int32_t timeout_msec;
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT (pool);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+
+   if (!_mongoc_mux_enabled (pool->mux)) {
+      client = mongoc_client_pool_pop (pool);
+      ret = mongoc_client_command_simple (client, db_name, command,
+                                          read_prefs, reply, error);
+      mongoc_client_pool_push (pool, client);
+
+      RETURN (ret);
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      if (reply) {
+         bson_init (reply);
+      }
+
+      RETURN (false);
+   }
+
+   if (!read_prefs) {
+      local_prefs = mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+      read_prefs = local_prefs;
+   }
+
+   mongoc_mutex_lock (&pool->mutex);
+   _start_scanner_if_needed (pool);
+   mongoc_mutex_unlock (&pool->mutex);
+
+   timeout_msec = mongoc_uri_get_option_as_int32 (
+      pool->uri, "sockettimeoutms", MONGOC_DEFAULT_SOCKETTIMEOUTMS);
+
+   ret = _mongoc_mux_command (pool->mux, pool, pool->topology,
+                              pool->error_api_version, timeout_msec,
+                              db_name, command, read_prefs, reply, error);
+
+   mongoc_read_prefs_destroy (local_prefs);
+
+   RETURN (ret);
+}
+
+
 bool
 mongoc_client_pool_set_apm_callbacks (mongoc_client_pool_t   *pool,
                                       mongoc_apm_callbacks_t *callbacks,
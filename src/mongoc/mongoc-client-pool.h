@@ -57,6 +57,23 @@ bool                  mongoc_client_pool_set_apm_callbacks (mongoc_client_pool_t
                                                             void                   *context);
 bool                  mongoc_client_pool_set_error_api     (mongoc_client_pool_t   *pool,
                                                             int32_t                 version);
+void                  mongoc_client_pool_set_max_buffer_bytes (mongoc_client_pool_t   *pool,
+                                                               size_t                  max_bytes);
+void                  mongoc_client_pool_set_deferred_kill_cursors (mongoc_client_pool_t   *pool,
+                                                                    int32_t                 delay_msec,
+                                                                    uint32_t                max_cursors);
+void                  mongoc_client_pool_set_write_combining (mongoc_client_pool_t   *pool,
+                                                              int32_t                 window_usec);
+void                  mongoc_client_pool_set_max_shared_connections (mongoc_client_pool_t      *pool,
+                                                                     uint32_t                   max_connections);
+void                  mongoc_client_pool_set_read_coalescing (mongoc_client_pool_t      *pool,
+                                                              bool                       enabled);
+bool                  mongoc_client_pool_command_simple    (mongoc_client_pool_t      *pool,
+                                                            const char                *db_name,
+                                                            const bson_t              *command,
+                                                            const mongoc_read_prefs_t *read_prefs,
+                                                            bson_t                    *reply,
+                                                            bson_error_t              *error);
 #ifdef MONGOC_EXPERIMENTAL_FEATURES
 bool                  mongoc_client_pool_set_appname       (mongoc_client_pool_t   *pool,
                                                             const char             *appname);
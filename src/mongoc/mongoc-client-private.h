@@ -25,18 +25,21 @@
 
 #include "mongoc-apm-private.h"
 #include "mongoc-buffer-private.h"
+#include "mongoc-buffer-pool-private.h"
 #include "mongoc-client.h"
 #include "mongoc-cluster-private.h"
 #include "mongoc-config.h"
 #include "mongoc-host-list.h"
 #include "mongoc-read-prefs.h"
 #include "mongoc-rpc-private.h"
+#include "mongoc-single-flight-private.h"
 #include "mongoc-opcode.h"
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc-ssl.h"
 #endif
 #include "mongoc-stream.h"
 #include "mongoc-topology-private.h"
+#include "mongoc-write-combiner-private.h"
 #include "mongoc-write-concern.h"
 
 
@@ -92,6 +95,15 @@ struct _mongoc_client_t
 
    int32_t                    error_api_version;
    bool                       error_api_set;
+
+   /* reply buffers come from here if the client belongs to a pool */
+   mongoc_buffer_pool_t      *buffer_pool;
+
+   /* single-document inserts are combined here if the client is pooled */
+   mongoc_write_combiner_t   *write_combiner;
+
+   /* identical concurrent reads share a round trip if the client is pooled */
+   mongoc_single_flight_t    *single_flight;
 };
 
 
@@ -136,6 +148,15 @@ _mongoc_client_kill_cursor              (mongoc_client_t *client,
                                          const char      *db,
                                          const char      *collection);
 
+void
+_mongoc_client_kill_cursors_for_server  (mongoc_client_t        *client,
+                                         mongoc_server_stream_t *server_stream,
+                                         bool                    force);
+
+void
+_mongoc_client_kill_cursors_flush       (mongoc_client_t *client,
+                                         bool             force);
+
 BSON_END_DECLS
 
 
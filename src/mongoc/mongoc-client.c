@@ -21,6 +21,7 @@
 # include <netinet/tcp.h>
 #endif
 
+#include "mongoc-async-private.h"
 #include "mongoc-cursor-array-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-collection-private.h"
@@ -33,6 +34,7 @@
 #include "mongoc-queue-private.h"
 #include "mongoc-socket.h"
 #include "mongoc-stream-buffered.h"
+#include "mongoc-stream-private.h"
 #include "mongoc-stream-socket.h"
 #include "mongoc-thread-private.h"
 #include "mongoc-trace.h"
@@ -54,7 +56,8 @@
 static void
 _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
                                mongoc_server_stream_t *server_stream,
-                               int64_t                 cursor_id,
+                               const int64_t          *cursor_ids,
+                               int32_t                 n_cursors,
                                int64_t                 operation_id,
                                const char             *db,
                                const char             *collection);
@@ -62,7 +65,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
 static void
 _mongoc_client_killcursors_command (mongoc_cluster_t       *cluster,
                                     mongoc_server_stream_t *server_stream,
-                                    int64_t                 cursor_id,
+                                    const int64_t          *cursor_ids,
+                                    int32_t                 n_cursors,
                                     const char             *db,
                                     const char             *collection);
 
@@ -543,7 +547,7 @@ _mongoc_client_recv_gle (mongoc_client_t        *client,
       *gle_doc = NULL;
    }
 
-   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+   _mongoc_buffer_init_from_pool (&buffer, client->buffer_pool);
 
    if (!mongoc_cluster_try_recv (&client->cluster, &rpc, &buffer,
                                  server_stream, error)) {
@@ -785,8 +789,17 @@ _mongoc_client_new_from_uri (const mongoc_uri_t *uri, mongoc_topology_t *topolog
 void
 mongoc_client_destroy (mongoc_client_t *client)
 {
+   bson_error_t error;
+
    if (client) {
       if (client->topology->single_threaded) {
+         if (!_mongoc_cluster_flush_unacknowledged (&client->cluster,
+                                                    &error)) {
+            MONGOC_WARNING ("Failed to send unacknowledged writes: %s",
+                            error.message);
+         }
+
+         _mongoc_client_kill_cursors_flush (client, true /* force */);
          mongoc_topology_destroy(client->topology);
       }
 
@@ -1325,20 +1338,373 @@ mongoc_client_command_simple_with_server_id (mongoc_client_t           *client,
 }
 
 
+typedef struct
+{
+   mongoc_client_t        *client;
+   uint32_t                server_id;
+   char                    host[BSON_HOST_NAME_MAX + 7];
+   mongoc_server_stream_t *server_stream;
+   bool                    has_reply;
+   bson_t                  reply;
+   bson_error_t            error;
+   /* the connection is in an unknown state and must be closed */
+   bool                    io_failed;
+} mongoc_scatter_target_t;
+
+
+static void
+_mongoc_client_scatter_cb (mongoc_async_cmd_result_t result,
+                           const bson_t             *bson,
+                           int64_t                   rtt_msec,
+                           void                     *data,
+                           bson_error_t             *error)
+{
+   mongoc_scatter_target_t *target = (mongoc_scatter_target_t *)data;
+
+   switch (result) {
+   case MONGOC_ASYNC_CMD_SUCCESS:
+      bson_copy_to (bson, &target->reply);
+      target->has_reply = true;
+      _mongoc_populate_cmd_error (bson, target->client->error_api_version,
+                                  &target->error);
+      break;
+   case MONGOC_ASYNC_CMD_TIMEOUT:
+      bson_set_error (&target->error, MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_SOCKET,
+                      "Timed out waiting for reply from %s.", target->host);
+      target->io_failed = true;
+      break;
+   case MONGOC_ASYNC_CMD_IN_PROGRESS:
+   case MONGOC_ASYNC_CMD_ERROR:
+   default:
+      if (error && error->code) {
+         memcpy (&target->error, error, sizeof target->error);
+      } else {
+         bson_set_error (&target->error, MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "Failed to send command to %s.", target->host);
+      }
+      target->io_failed = true;
+      break;
+   }
+}
+
+
+static bool
+_mongoc_client_scatter_find (mongoc_scatter_target_t *targets,
+                             size_t                   n_targets,
+                             uint32_t                 server_id)
+{
+   size_t i;
+
+   for (i = 0; i < n_targets; i++) {
+      if (targets[i].server_id == server_id) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+static void
+_mongoc_client_scatter_send (mongoc_async_t            *async,
+                             mongoc_scatter_target_t   *target,
+                             const char                *db_name,
+                             const bson_t              *command,
+                             const mongoc_read_prefs_t *read_prefs)
+{
+   mongoc_apply_read_prefs_result_t result = READ_PREFS_RESULT_INIT;
+   mongoc_stream_t *stream;
+
+   /* w:0 writes buffered for the server must reach it before the command */
+   if (!_mongoc_cluster_writev (&target->client->cluster, target->server_id,
+                                target->server_stream->stream, NULL, 0,
+                                &target->error)) {
+      target->io_failed = true;
+      return;
+   }
+
+   /* each stream carries one command, and the last reply read from it
+    * left nothing in a buffered stream's buffer, so read below it: its
+    * buffer would hide the reply from poll */
+   stream = target->server_stream->stream;
+   if (stream->type == MONGOC_STREAM_BUFFERED) {
+      stream = mongoc_stream_get_base_stream (stream);
+   }
+
+   apply_read_preferences (read_prefs, target->server_stream, command,
+                           MONGOC_QUERY_NONE, &result);
+
+   mongoc_async_cmd (async, stream, NULL, NULL, db_name,
+                     result.query_with_read_prefs,
+                     _mongoc_client_scatter_cb, target,
+                     (int32_t) target->client->cluster.sockettimeoutms);
+
+   apply_read_prefs_result_cleanup (&result);
+}
+
+static void
+_mongoc_client_scatter_append_result (mongoc_scatter_target_t *target,
+                                      uint32_t                 i,
+                                      bson_t                  *replies)
+{
+   bson_t doc;
+   bson_t child;
+   const char *key;
+   char buf[16];
+
+   bson_uint32_to_string (i, &key, buf, sizeof buf);
+   bson_append_document_begin (replies, key, -1, &doc);
+   BSON_APPEND_INT32 (&doc, "serverId", (int32_t) target->server_id);
+
+   if (target->host[0]) {
+      BSON_APPEND_UTF8 (&doc, "host", target->host);
+   }
+
+   if (target->has_reply) {
+      BSON_APPEND_DOCUMENT (&doc, "reply", &target->reply);
+   }
+
+   if (target->error.code) {
+      bson_append_document_begin (&doc, "error", 5, &child);
+      BSON_APPEND_INT32 (&child, "domain", (int32_t) target->error.domain);
+      BSON_APPEND_INT32 (&child, "code", (int32_t) target->error.code);
+      BSON_APPEND_UTF8 (&child, "message", target->error.message);
+      bson_append_document_end (&doc, &child);
+   }
+
+   bson_append_document_end (replies, &doc);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_command_scatter --
+ *
+ *       Send @command to each server in @server_ids, or if @server_ids is
+ *       NULL to every server suitable for @read_prefs, and gather their
+ *       replies. The commands are sent on the client's connections and
+ *       their replies awaited together, so the call takes as long as the
+ *       slowest server, not the sum of all of them.
+ *
+ *       @reply is initialized to {"replies": [...]}, one document per
+ *       server in order: {"serverId": N, "host": "host:port", "reply":
+ *       {...}}, plus an "error" document with "domain", "code" and
+ *       "message" if the command failed on that server.
+ *
+ * Returns:
+ *       true if the command succeeded on every server. Otherwise false
+ *       and @error is set to the first server's error.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_command_scatter (mongoc_client_t           *client,
+                               const char                *db_name,
+                               const bson_t              *command,
+                               const mongoc_read_prefs_t *read_prefs,
+                               const uint32_t            *server_ids,
+                               size_t                     n_server_ids,
+                               bson_t                    *reply,
+                               bson_error_t              *error)
+{
+   mongoc_read_prefs_t *local_prefs = NULL;
+   mongoc_scatter_target_t *targets = NULL;
+   mongoc_scatter_target_t *target;
+   mongoc_server_description_t *sd;
+   mongoc_array_t sds;
+   mongoc_async_t *async;
+   bson_t replies;
+   size_t n_targets;
+   size_t i;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+   BSON_ASSERT (server_ids || !n_server_ids);
+
+   _mongoc_array_init (&sds, sizeof (mongoc_server_description_t *));
+
+   if (reply) {
+      bson_init (reply);
+   }
+
+   if (!read_prefs) {
+      local_prefs = mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+      read_prefs = local_prefs;
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      GOTO (done);
+   }
+
+   /* the client's connections are busy streaming replies */
+   if (client->in_exhaust) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
+                      "A cursor derived from this client is in exhaust.");
+      GOTO (done);
+   }
+
+   if (server_ids) {
+      n_targets = n_server_ids;
+   } else {
+      if (!mongoc_topology_select_all (client->topology, MONGOC_SS_READ,
+                                       read_prefs, &sds, error)) {
+         GOTO (done);
+      }
+
+      n_targets = sds.len;
+   }
+
+   targets = (mongoc_scatter_target_t *)bson_malloc0 (
+      sizeof (*targets) * BSON_MAX (n_targets, 1));
+
+   async = mongoc_async_new ();
+
+   /* connect to each server first, on the client's usual connections */
+   for (i = 0; i < n_targets; i++) {
+      target = &targets[i];
+      target->client = client;
+
+      if (server_ids) {
+         target->server_id = server_ids[i];
+      } else {
+         sd = _mongoc_array_index (&sds, mongoc_server_description_t *, i);
+         target->server_id = sd->id;
+      }
+
+      /* a stream can't carry two commands at once */
+      if (_mongoc_client_scatter_find (targets, i, target->server_id)) {
+         bson_set_error (&target->error, MONGOC_ERROR_COMMAND,
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                         "Server id %u is listed more than once.",
+                         target->server_id);
+         continue;
+      }
+
+      target->server_stream = mongoc_cluster_stream_for_server (
+         &client->cluster, target->server_id, true /* reconnect ok */,
+         &target->error);
+
+      if (!target->server_stream) {
+         continue;
+      }
+
+      bson_strncpy (target->host,
+                    target->server_stream->sd->host.host_and_port,
+                    sizeof target->host);
+
+      _mongoc_client_scatter_send (async, target, db_name, command,
+                                   read_prefs);
+   }
+
+   /* then await all the replies together */
+   mongoc_async_run (async, -1);
+   mongoc_async_destroy (async);
+
+   ret = true;
+
+   if (reply) {
+      bson_append_array_begin (reply, "replies", 7, &replies);
+   }
+
+   for (i = 0; i < n_targets; i++) {
+      target = &targets[i];
+
+      if (target->io_failed) {
+         mongoc_cluster_disconnect_node (&client->cluster, target->server_id);
+      }
+
+      if (target->error.code && ret) {
+         ret = false;
+         if (error) {
+            memcpy (error, &target->error, sizeof *error);
+         }
+      }
+
+      if (reply) {
+         _mongoc_client_scatter_append_result (target, (uint32_t) i,
+                                               &replies);
+      }
+
+      if (target->has_reply) {
+         bson_destroy (&target->reply);
+      }
+
+      mongoc_server_stream_cleanup (target->server_stream);
+   }
+
+   if (reply) {
+      bson_append_array_end (reply, &replies);
+   }
+
+done:
+   for (i = 0; i < sds.len; i++) {
+      mongoc_server_description_destroy (
+         _mongoc_array_index (&sds, mongoc_server_description_t *, i));
+   }
+
+   _mongoc_array_destroy (&sds);
+   bson_free (targets);
+   mongoc_read_prefs_destroy (local_prefs);
+
+   RETURN (ret);
+}
+
+
 static void
-_mongoc_client_prepare_killcursors_command (int64_t     cursor_id,
-                                            const char *collection,
-                                            bson_t     *command)
+_mongoc_client_prepare_killcursors_command (const int64_t *cursor_ids,
+                                            int32_t        n_cursors,
+                                            const char    *collection,
+                                            bson_t        *command)
 {
    bson_t child;
+   const char *key;
+   char buf[16];
+   int32_t i;
 
    bson_append_utf8 (command, "killCursors", 11, collection, -1);
    bson_append_array_begin (command, "cursors", 7, &child);
-   bson_append_int64 (&child, "0", 1, cursor_id);
+   for (i = 0; i < n_cursors; i++) {
+      bson_uint32_to_string ((uint32_t) i, &key, buf, sizeof buf);
+      bson_append_int64 (&child, key, -1, cursor_ids[i]);
+   }
    bson_append_array_end (command, &child);
 }
 
 
+static void
+_mongoc_client_send_kill_cursors (mongoc_client_t        *client,
+                                  mongoc_server_stream_t *server_stream,
+                                  const int64_t          *cursor_ids,
+                                  int32_t                 n_cursors,
+                                  int64_t                 operation_id,
+                                  const char             *db,
+                                  const char             *collection)
+{
+   if (db && collection &&
+       server_stream->sd->max_wire_version >=
+       WIRE_VERSION_KILLCURSORS_CMD) {
+      _mongoc_client_killcursors_command (&client->cluster, server_stream,
+                                          cursor_ids, n_cursors,
+                                          db, collection);
+   } else {
+      _mongoc_client_op_killcursors (&client->cluster,
+                                     server_stream,
+                                     cursor_ids, n_cursors, operation_id,
+                                     db, collection);
+   }
+}
+
+
 void
 _mongoc_client_kill_cursor (mongoc_client_t *client,
                             uint32_t         server_id,
@@ -1354,6 +1720,14 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
    BSON_ASSERT (client);
    BSON_ASSERT (cursor_id);
 
+   if (db && collection &&
+       _mongoc_kill_cursors_queue_push (&client->topology->kill_cursors,
+                                        server_id, cursor_id, operation_id,
+                                        db, collection)) {
+      /* killed later, in a batch with other cursors on this server */
+      EXIT;
+   }
+
    /* don't attempt reconnect if server unavailable, and ignore errors */
    server_stream = mongoc_cluster_stream_for_server (&client->cluster,
                                                      server_id,
@@ -1364,17 +1738,8 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
       return;
    }
 
-   if (db && collection &&
-       server_stream->sd->max_wire_version >=
-       WIRE_VERSION_KILLCURSORS_CMD) {
-      _mongoc_client_killcursors_command (&client->cluster, server_stream,
-                                          cursor_id, db, collection);
-   } else {
-      _mongoc_client_op_killcursors (&client->cluster,
-                                     server_stream,
-                                     cursor_id, operation_id,
-                                     db, collection);
-   }
+   _mongoc_client_send_kill_cursors (client, server_stream, &cursor_id, 1,
+                                     operation_id, db, collection);
 
    mongoc_server_stream_cleanup (server_stream);
 
@@ -1382,10 +1747,170 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_kill_cursors_for_server --
+ *
+ *       Kill the cursors queued for @server_stream's server, one
+ *       killCursors command per namespace. Only cursors that are due are
+ *       killed, unless @force is true.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       Errors are ignored; the server times out cursors we fail to kill.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_kill_cursors_for_server (mongoc_client_t        *client,
+                                        mongoc_server_stream_t *server_stream,
+                                        bool                    force)
+{
+   mongoc_array_t entries;
+   mongoc_array_t ids;
+   mongoc_kill_cursors_entry_t *entry;
+   mongoc_kill_cursors_entry_t *other;
+   size_t i;
+   size_t j;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+   BSON_ASSERT (server_stream);
+
+   _mongoc_array_init (&entries, sizeof (mongoc_kill_cursors_entry_t));
+
+   if (!_mongoc_kill_cursors_queue_take (&client->topology->kill_cursors,
+                                         server_stream->sd->id,
+                                         force,
+                                         &entries)) {
+      _mongoc_array_destroy (&entries);
+      EXIT;
+   }
+
+   _mongoc_array_init (&ids, sizeof (int64_t));
+
+   for (i = 0; i < entries.len; i++) {
+      entry = &_mongoc_array_index (&entries, mongoc_kill_cursors_entry_t, i);
+      if (!entry->cursor_id) {
+         /* already sent with an earlier entry's namespace */
+         continue;
+      }
+
+      _mongoc_array_clear (&ids);
+
+      for (j = i; j < entries.len; j++) {
+         other = &_mongoc_array_index (&entries,
+                                       mongoc_kill_cursors_entry_t, j);
+         if (other->cursor_id &&
+             !strcmp (other->db, entry->db) &&
+             !strcmp (other->collection, entry->collection)) {
+            _mongoc_array_append_val (&ids, other->cursor_id);
+            if (j > i) {
+               other->cursor_id = 0;
+            }
+         }
+      }
+
+      _mongoc_client_send_kill_cursors (client, server_stream,
+                                        (int64_t *) ids.data,
+                                        (int32_t) ids.len,
+                                        entry->operation_id,
+                                        entry->db, entry->collection);
+   }
+
+   _mongoc_array_destroy (&ids);
+   _mongoc_kill_cursors_entries_clear (&entries);
+   _mongoc_array_destroy (&entries);
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_kill_cursors_flush --
+ *
+ *       Kill queued cursors on every server that has some due, or on every
+ *       server at all if @force is true. Without @force, cursors on
+ *       servers this client isn't connected to stay queued for a client
+ *       that is. With @force, this is the final flush: we connect if we
+ *       must, and cursors we still can't kill are dropped with a warning.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_kill_cursors_flush (mongoc_client_t *client,
+                                   bool             force)
+{
+   mongoc_kill_cursors_queue_t *queue;
+   mongoc_server_stream_t *server_stream;
+   mongoc_array_t dropped;
+   uint32_t server_id = 0;
+   bson_error_t error;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+
+   queue = &client->topology->kill_cursors;
+
+   if (client->in_exhaust) {
+      /* the connection is busy streaming replies */
+      EXIT;
+   }
+
+   while ((server_id = _mongoc_kill_cursors_queue_next_due (queue,
+                                                           server_id,
+                                                           force))) {
+      /* a pooled client flushes on every push: only the final flush may
+       * block on a connect */
+      server_stream = mongoc_cluster_stream_for_server (&client->cluster,
+                                                        server_id,
+                                                        force /* reconnect_ok */,
+                                                        &error);
+
+      if (server_stream) {
+         /* fetching the stream killed the cursors that were due, the rest
+          * are killed here if forced */
+         _mongoc_client_kill_cursors_for_server (client, server_stream, force);
+         mongoc_server_stream_cleanup (server_stream);
+      } else if (force) {
+         _mongoc_array_init (&dropped, sizeof (mongoc_kill_cursors_entry_t));
+         _mongoc_kill_cursors_queue_take (queue, server_id, true, &dropped);
+
+         if (dropped.len) {
+            MONGOC_WARNING ("Could not kill %d cursors on server %u, the "
+                            "server will time them out: %s",
+                            (int) dropped.len, server_id, error.message);
+         }
+
+         _mongoc_kill_cursors_entries_clear (&dropped);
+         _mongoc_array_destroy (&dropped);
+      }
+   }
+
+   EXIT;
+}
+
+
 static void
 _mongoc_client_monitor_op_killcursors (mongoc_cluster_t       *cluster,
                                        mongoc_server_stream_t *server_stream,
-                                       int64_t                 cursor_id,
+                                       const int64_t          *cursor_ids,
+                                       int32_t                 n_cursors,
                                        int64_t                 operation_id,
                                        const char             *db,
                                        const char             *collection)
@@ -1403,7 +1928,8 @@ _mongoc_client_monitor_op_killcursors (mongoc_cluster_t       *cluster,
    }
 
    bson_init (&doc);
-   _mongoc_client_prepare_killcursors_command (cursor_id, collection, &doc);
+   _mongoc_client_prepare_killcursors_command (cursor_ids, n_cursors,
+                                               collection, &doc);
    mongoc_apm_command_started_init (&event,
                                     &doc,
                                     db,
@@ -1427,13 +1953,17 @@ _mongoc_client_monitor_op_killcursors_succeeded (
    mongoc_cluster_t       *cluster,
    int64_t                 duration,
    mongoc_server_stream_t *server_stream,
-   int64_t                 cursor_id,
+   const int64_t          *cursor_ids,
+   int32_t                 n_cursors,
    int64_t                 operation_id)
 {
    mongoc_client_t *client;
    bson_t doc;
    bson_t cursors_unknown;
    mongoc_apm_command_succeeded_t event;
+   const char *key;
+   char buf[16];
+   int32_t i;
 
    ENTRY;
 
@@ -1447,7 +1977,10 @@ _mongoc_client_monitor_op_killcursors_succeeded (
    bson_init (&doc);
    bson_append_int32 (&doc, "ok", 2, 1);
    bson_append_array_begin (&doc, "cursorsUnknown", 14, &cursors_unknown);
-   bson_append_int64 (&cursors_unknown, "0", 1, cursor_id);
+   for (i = 0; i < n_cursors; i++) {
+      bson_uint32_to_string ((uint32_t) i, &key, buf, sizeof buf);
+      bson_append_int64 (&cursors_unknown, key, -1, cursor_ids[i]);
+   }
    bson_append_array_end (&doc, &cursors_unknown);
 
    mongoc_apm_command_succeeded_init (&event,
@@ -1505,7 +2038,8 @@ _mongoc_client_monitor_op_killcursors_failed (
 static void
 _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
                                mongoc_server_stream_t *server_stream,
-                               int64_t                 cursor_id,
+                               const int64_t          *cursor_ids,
+                               int32_t                 n_cursors,
                                int64_t                 operation_id,
                                const char             *db,
                                const char             *collection)
@@ -1524,10 +2058,11 @@ _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
    rpc.kill_cursors.response_to = 0;
    rpc.kill_cursors.opcode = MONGOC_OPCODE_KILL_CURSORS;
    rpc.kill_cursors.zero = 0;
-   rpc.kill_cursors.cursors = &cursor_id;
-   rpc.kill_cursors.n_cursors = 1;
+   rpc.kill_cursors.cursors = (int64_t *) cursor_ids;
+   rpc.kill_cursors.n_cursors = n_cursors;
 
-   _mongoc_client_monitor_op_killcursors (cluster, server_stream, cursor_id,
+   _mongoc_client_monitor_op_killcursors (cluster, server_stream,
+                                          cursor_ids, n_cursors,
                                           operation_id, db, collection);
 
    r = mongoc_cluster_sendv_to_server (cluster, &rpc, 1, server_stream,
@@ -1538,7 +2073,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
          cluster,
          bson_get_monotonic_time () - started,
          server_stream,
-         cursor_id,
+         cursor_ids,
+         n_cursors,
          operation_id);
    } else {
       _mongoc_client_monitor_op_killcursors_failed (
@@ -1554,7 +2090,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t       *cluster,
 static void
 _mongoc_client_killcursors_command (mongoc_cluster_t       *cluster,
                                     mongoc_server_stream_t *server_stream,
-                                    int64_t                 cursor_id,
+                                    const int64_t          *cursor_ids,
+                                    int32_t                 n_cursors,
                                     const char             *db,
                                     const char             *collection)
 {
@@ -1562,7 +2099,8 @@ _mongoc_client_killcursors_command (mongoc_cluster_t       *cluster,
 
    ENTRY;
 
-   _mongoc_client_prepare_killcursors_command (cursor_id,
+   _mongoc_client_prepare_killcursors_command (cursor_ids,
+                                               n_cursors,
                                                collection,
                                                &command);
 
@@ -1788,6 +2326,109 @@ _mongoc_client_set_apm_callbacks_private (mongoc_client_t        *client,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_set_deferred_kill_cursors --
+ *
+ *       Queue the ids of cursors destroyed before they were exhausted,
+ *       and kill them in batches: one killCursors command per server and
+ *       namespace. A server's queue is flushed by the next operation on
+ *       that server once its oldest cursor has waited @delay_msec, or
+ *       once it holds @max_cursors ids. Pass 0 for both to kill cursors
+ *       immediately, the default.
+ *
+ * Returns:
+ *       false if @client belongs to a pool, use
+ *       mongoc_client_pool_set_deferred_kill_cursors instead.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_set_deferred_kill_cursors (mongoc_client_t *client,
+                                         int32_t          delay_msec,
+                                         uint32_t         max_cursors)
+{
+   BSON_ASSERT (client);
+
+   if (!client->topology->single_threaded) {
+      MONGOC_ERROR ("Cannot defer killing cursors on a pooled client, use "
+                    "mongoc_client_pool_set_deferred_kill_cursors");
+      return false;
+   }
+
+   _mongoc_kill_cursors_queue_set (&client->topology->kill_cursors,
+                                   delay_msec, max_cursors);
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_set_unacknowledged_write_buffer --
+ *
+ *       Buffer legacy unacknowledged (w:0) inserts, updates and deletes
+ *       instead of sending each one as it is issued. The buffer holds
+ *       writes for one server and is sent in a single write when it
+ *       reaches @max_bytes, before any other message to that server, or
+ *       by mongoc_client_flush_unacknowledged_writes. Pass 0 to send
+ *       writes immediately, the default.
+ *
+ * Side effects:
+ *       Writes buffered when @max_bytes is 0 are sent now.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_client_set_unacknowledged_write_buffer (mongoc_client_t *client,
+                                               size_t           max_bytes)
+{
+   bson_error_t error;
+
+   BSON_ASSERT (client);
+
+   client->cluster.unacked_max_bytes = max_bytes;
+
+   if (!max_bytes &&
+       !_mongoc_cluster_flush_unacknowledged (&client->cluster, &error)) {
+      MONGOC_WARNING ("Failed to send unacknowledged writes: %s",
+                      error.message);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_flush_unacknowledged_writes --
+ *
+ *       Send unacknowledged writes buffered by
+ *       mongoc_client_set_unacknowledged_write_buffer.
+ *
+ * Returns:
+ *       false and sets @error if the writes could not be sent. They are
+ *       discarded either way.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_flush_unacknowledged_writes (mongoc_client_t *client,
+                                           bson_error_t    *error)
+{
+   BSON_ASSERT (client);
+
+   return _mongoc_cluster_flush_unacknowledged (&client->cluster, error);
+}
+
+
 bool
 mongoc_client_set_apm_callbacks (mongoc_client_t        *client,
                                  mongoc_apm_callbacks_t *callbacks,
@@ -126,6 +126,14 @@ bool                           mongoc_client_command_simple_with_server_id (mong
                                                                             uint32_t                      server_id,
                                                                             bson_t                       *reply,
                                                                             bson_error_t                 *error);
+bool                           mongoc_client_command_scatter               (mongoc_client_t              *client,
+                                                                            const char                   *db_name,
+                                                                            const bson_t                 *command,
+                                                                            const mongoc_read_prefs_t    *read_prefs,
+                                                                            const uint32_t               *server_ids,
+                                                                            size_t                        n_server_ids,
+                                                                            bson_t                       *reply,
+                                                                            bson_error_t                 *error);
 void                           mongoc_client_destroy                       (mongoc_client_t              *client);
 mongoc_database_t             *mongoc_client_get_database                  (mongoc_client_t              *client,
                                                                             const char                   *name);
@@ -175,6 +183,13 @@ mongoc_server_description_t   *mongoc_client_select_server                 (mong
                                                                             bson_error_t                 *error);
 bool                           mongoc_client_set_error_api                 (mongoc_client_t              *client,
                                                                             int32_t                       version);
+bool                           mongoc_client_set_deferred_kill_cursors     (mongoc_client_t              *client,
+                                                                            int32_t                       delay_msec,
+                                                                            uint32_t                      max_cursors);
+void                           mongoc_client_set_unacknowledged_write_buffer (mongoc_client_t            *client,
+                                                                            size_t                        max_bytes);
+bool                           mongoc_client_flush_unacknowledged_writes   (mongoc_client_t              *client,
+                                                                            bson_error_t                 *error);
 #ifdef MONGOC_EXPERIMENTAL_FEATURES
 bool                           mongoc_client_set_appname                   (mongoc_client_t              *client,
                                                                             const char                   *appname);
@@ -68,6 +68,12 @@ typedef struct _mongoc_cluster_t
 
    mongoc_set_t    *nodes;
    mongoc_array_t   iov;
+
+   /* unacknowledged writes not yet sent to unacked_server_id. anything
+    * written to that server must go through _mongoc_cluster_writev */
+   mongoc_array_t   unacked;
+   uint32_t         unacked_server_id;
+   size_t           unacked_max_bytes;
 } mongoc_cluster_t;
 
 void
@@ -78,6 +84,23 @@ mongoc_cluster_init (mongoc_cluster_t   *cluster,
 void
 mongoc_cluster_destroy (mongoc_cluster_t *cluster);
 
+bool
+_mongoc_cluster_flush_unacknowledged (mongoc_cluster_t *cluster,
+                                      bson_error_t     *error);
+
+bool
+_mongoc_cluster_writev (mongoc_cluster_t *cluster,
+                        uint32_t          server_id,
+                        mongoc_stream_t  *stream,
+                        mongoc_iovec_t   *iov,
+                        size_t            iovcnt,
+                        bson_error_t     *error);
+
+mongoc_stream_t *
+_mongoc_cluster_connect_server (mongoc_cluster_t *cluster,
+                                uint32_t          server_id,
+                                bson_error_t     *error);
+
 void
 mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster,
                                 uint32_t          id);
@@ -237,8 +237,8 @@ mongoc_cluster_run_command_internal (mongoc_cluster_t         *cluster,
    /*
     * send and receive
     */
-   if (!_mongoc_stream_writev_full (stream, (mongoc_iovec_t *)ar.data, ar.len,
-                                    cluster->sockettimeoutms, error)) {
+   if (!_mongoc_cluster_writev (cluster, server_id, stream,
+                                (mongoc_iovec_t *)ar.data, ar.len, error)) {
       mongoc_cluster_disconnect_node (cluster, server_id);
 
       /* add info about the command to writev_full's error message */
@@ -1304,6 +1304,12 @@ mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster, uint32_t server_id)
    mongoc_topology_t *topology = cluster->client->topology;
    ENTRY;
 
+   /* buffered unacknowledged writes are lost with the connection, as if
+    * they had been sent */
+   if (cluster->unacked_server_id == server_id) {
+      _mongoc_array_clear (&cluster->unacked);
+   }
+
    if (topology->single_threaded) {
       mongoc_topology_scanner_node_t *scanner_node;
 
@@ -1424,6 +1430,78 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
    RETURN (stream);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_connect_server --
+ *
+ *       Open a connection to @server_id the way a cluster node's is
+ *       opened, with ismaster and authentication, but owned by the caller
+ *       and not added to the cluster's nodes.
+ *
+ * Returns:
+ *       A stream the caller must destroy, or NULL and @error is set.
+ *
+ * Side effects:
+ *       Makes blocking I/O calls.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_stream_t *
+_mongoc_cluster_connect_server (mongoc_cluster_t *cluster,
+                                uint32_t          server_id,
+                                bson_error_t     *error)
+{
+   mongoc_server_description_t *sd;
+   mongoc_cluster_node_t *cluster_node;
+   mongoc_stream_t *stream;
+
+   ENTRY;
+
+   BSON_ASSERT (cluster);
+
+   sd = mongoc_topology_server_by_id (cluster->client->topology, server_id,
+                                      error);
+   if (!sd) {
+      RETURN (NULL);
+   }
+
+   stream = _mongoc_client_create_stream (cluster->client, &sd->host, error);
+   if (!stream) {
+      GOTO (done);
+   }
+
+   cluster_node = _mongoc_cluster_node_new (stream);
+   if (!_mongoc_cluster_run_ismaster (cluster, cluster_node)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_CONNECT,
+                      "Failed connection to %s (ismaster failed)",
+                      sd->connection_address);
+      _mongoc_cluster_node_destroy (cluster_node);
+      stream = NULL;
+      GOTO (done);
+   }
+
+   if (cluster->requires_auth &&
+       !_mongoc_cluster_auth_node (cluster, stream, sd->host.host,
+                                   cluster_node->max_wire_version, error)) {
+      _mongoc_cluster_node_destroy (cluster_node);
+      stream = NULL;
+      GOTO (done);
+   }
+
+   /* keep the stream, discard the node */
+   bson_free (cluster_node);
+
+done:
+   mongoc_server_description_destroy (sd);
+
+   RETURN (stream);
+}
+
+
 static void
 node_not_found (mongoc_server_description_t *sd,
                 bson_error_t *error /* OUT */)
@@ -1463,6 +1541,64 @@ stream_not_found (mongoc_server_description_t *sd,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_kill_queued_cursors --
+ *
+ *       If cursors on @sd were queued to be killed and are due, kill them
+ *       before we use the server for something else. The kill runs on its
+ *       own server stream: if it fails the node is disconnected, and the
+ *       caller's stream is fetched (and maybe reconnected) afterward.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       May disconnect the node.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_cluster_kill_queued_cursors (mongoc_cluster_t *cluster,
+                                     mongoc_server_description_t *sd)
+{
+   mongoc_topology_t *topology;
+   mongoc_server_description_t *sd_copy;
+   mongoc_server_stream_t *server_stream;
+   bson_error_t error;
+
+   topology = cluster->client->topology;
+
+   if (cluster->client->in_exhaust ||
+       !_mongoc_kill_cursors_queue_is_due (&topology->kill_cursors, sd->id)) {
+      return;
+   }
+
+   sd_copy = mongoc_server_description_new_copy (sd);
+
+   if (topology->single_threaded) {
+      server_stream = mongoc_cluster_fetch_stream_single (
+         cluster, sd_copy, false /* reconnect_ok */, &error);
+   } else {
+      server_stream = mongoc_cluster_fetch_stream_pooled (
+         cluster, sd_copy, false /* reconnect_ok */, &error);
+   }
+
+   if (!server_stream) {
+      /* leave them queued until we're connected */
+      mongoc_server_description_destroy (sd_copy);
+      return;
+   }
+
+   _mongoc_client_kill_cursors_for_server (cluster->client, server_stream,
+                                           false /* force */);
+
+   mongoc_server_stream_cleanup (server_stream);
+}
+
+
 static mongoc_server_stream_t *
 _mongoc_cluster_stream_for_server_description (mongoc_cluster_t *cluster,
                                                mongoc_server_description_t *sd,
@@ -1476,6 +1612,8 @@ _mongoc_cluster_stream_for_server_description (mongoc_cluster_t *cluster,
 
    topology = cluster->client->topology;
 
+   _mongoc_cluster_kill_queued_cursors (cluster, sd);
+
    /* in the single-threaded use case we share topology's streams */
    if (topology->single_threaded) {
       server_stream = mongoc_cluster_fetch_stream_single (cluster,
@@ -1735,6 +1873,7 @@ mongoc_cluster_init (mongoc_cluster_t   *cluster,
    cluster->nodes = mongoc_set_new(8, _mongoc_cluster_node_dtor, NULL);
 
    _mongoc_array_init (&cluster->iov, sizeof (mongoc_iovec_t));
+   _mongoc_array_init (&cluster->unacked, sizeof (uint8_t));
 
    cluster->operation_id = rand ();
 
@@ -1770,6 +1909,7 @@ mongoc_cluster_destroy (mongoc_cluster_t *cluster) /* INOUT */
    mongoc_set_destroy(cluster->nodes);
 
    _mongoc_array_destroy(&cluster->iov);
+   _mongoc_array_destroy(&cluster->unacked);
 
    EXIT;
 }
@@ -2202,6 +2342,172 @@ _mongoc_cluster_check_interval (mongoc_cluster_t *cluster,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_can_buffer --
+ *
+ *       Whether @rpcs are all writes that need no getlasterror, so that
+ *       mongoc_cluster_sendv_to_server can buffer them instead of
+ *       sending them now.
+ *
+ *       Only legacy write opcodes qualify; a write command always waits
+ *       for its reply. _mongoc_write_command sends w:0 writes as legacy
+ *       opcodes to any server with minWireVersion 0, so this covers
+ *       servers with write commands too.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_can_buffer (mongoc_cluster_t             *cluster,
+                            mongoc_rpc_t                 *rpcs,
+                            size_t                        rpcs_len,
+                            const mongoc_write_concern_t *write_concern)
+{
+   size_t i;
+
+   if (!cluster->unacked_max_bytes) {
+      return false;
+   }
+
+   for (i = 0; i < rpcs_len; i++) {
+      switch (rpcs[i].header.opcode) {
+      case MONGOC_OPCODE_INSERT:
+      case MONGOC_OPCODE_UPDATE:
+      case MONGOC_OPCODE_DELETE:
+         if (_mongoc_rpc_needs_gle (&rpcs[i], write_concern)) {
+            return false;
+         }
+         break;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_writev --
+ *
+ *       Write @iovcnt buffers to @stream, a connection to @server_id.
+ *
+ *       This is the one way a request reaches a cluster's stream: any
+ *       unacknowledged writes buffered for @server_id are sent first, in
+ *       the same write, so the server sees operations in the order the
+ *       application issued them. Code that hands a stream to another
+ *       writer, such as the async command loop, calls this with @iovcnt 0
+ *       beforehand to send the buffered writes alone.
+ *
+ * Returns:
+ *       false and sets @error if the write failed. The buffered writes
+ *       are discarded either way.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_cluster_writev (mongoc_cluster_t *cluster,
+                        uint32_t          server_id,
+                        mongoc_stream_t  *stream,
+                        mongoc_iovec_t   *iov,
+                        size_t            iovcnt,
+                        bson_error_t     *error)
+{
+   mongoc_iovec_t *all;
+   size_t n = 0;
+   bool ret;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (stream);
+
+   if (!cluster->unacked.len || cluster->unacked_server_id != server_id) {
+      if (!iovcnt) {
+         return true;
+      }
+
+      return _mongoc_stream_writev_full (stream, iov, iovcnt,
+                                         cluster->sockettimeoutms, error);
+   }
+
+   all = (mongoc_iovec_t *)bson_malloc ((iovcnt + 1) * sizeof *all);
+   all[n].iov_base = cluster->unacked.data;
+   all[n].iov_len = cluster->unacked.len;
+   n++;
+
+   if (iovcnt) {
+      memcpy (all + n, iov, iovcnt * sizeof *all);
+      n += iovcnt;
+   }
+
+   ret = _mongoc_stream_writev_full (stream, all, n,
+                                     cluster->sockettimeoutms, error);
+
+   _mongoc_array_clear (&cluster->unacked);
+   bson_free (all);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_flush_unacknowledged --
+ *
+ *       Send any buffered unacknowledged writes to their server.
+ *
+ * Returns:
+ *       false and sets @error if the server could not be reached or the
+ *       write failed. The buffered writes are discarded either way.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_cluster_flush_unacknowledged (mongoc_cluster_t *cluster,
+                                      bson_error_t     *error)
+{
+   mongoc_server_stream_t *server_stream;
+   uint32_t server_id;
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT (cluster);
+
+   if (!cluster->unacked.len) {
+      RETURN (true);
+   }
+
+   server_id = cluster->unacked_server_id;
+
+   /* fetching the stream may itself run a command on it, which sends the
+    * buffered writes first */
+   server_stream = mongoc_cluster_stream_for_server (cluster, server_id,
+                                                     false /* reconnect_ok */,
+                                                     error);
+   if (!server_stream) {
+      _mongoc_array_clear (&cluster->unacked);
+      RETURN (false);
+   }
+
+   ret = _mongoc_cluster_writev (cluster, server_id, server_stream->stream,
+                                 NULL, 0, error);
+   if (!ret) {
+      mongoc_cluster_disconnect_node (cluster, server_id);
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+
+   RETURN (ret);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -2237,6 +2543,7 @@ mongoc_cluster_sendv_to_server (mongoc_cluster_t              *cluster,
    size_t iovcnt;
    size_t i;
    bool need_gle;
+   bool buffer;
    char cmdname[140];
    int32_t max_msg_size;
 
@@ -2267,6 +2574,17 @@ mongoc_cluster_sendv_to_server (mongoc_cluster_t              *cluster,
       RETURN (false);
    }
 
+   buffer = _mongoc_cluster_can_buffer (cluster, rpcs, rpcs_len,
+                                        write_concern);
+
+   /* the buffer holds writes for one server at a time. flush before
+    * gathering, since fetching a stream may send rpcs with cluster->iov */
+   if (buffer && cluster->unacked.len &&
+       cluster->unacked_server_id != server_id &&
+       !_mongoc_cluster_flush_unacknowledged (cluster, error)) {
+      RETURN (false);
+   }
+
    _mongoc_array_clear(&cluster->iov);
 
    /*
@@ -2335,8 +2653,26 @@ mongoc_cluster_sendv_to_server (mongoc_cluster_t              *cluster,
 
    BSON_ASSERT (cluster->iov.len);
 
-   if (!_mongoc_stream_writev_full (server_stream->stream, iov, iovcnt,
-                                    cluster->sockettimeoutms, error)) {
+   if (buffer) {
+      for (i = 0; i < iovcnt; i++) {
+         _mongoc_array_append_vals (&cluster->unacked, iov[i].iov_base,
+                                    (uint32_t) iov[i].iov_len);
+      }
+
+      cluster->unacked_server_id = server_id;
+
+      /* past the cap the caller waits for the buffer to drain */
+      if (cluster->unacked.len >= cluster->unacked_max_bytes &&
+          !_mongoc_cluster_writev (cluster, server_id, server_stream->stream,
+                                   NULL, 0, error)) {
+         RETURN (false);
+      }
+
+      RETURN (true);
+   }
+
+   if (!_mongoc_cluster_writev (cluster, server_id, server_stream->stream,
+                                iov, iovcnt, error)) {
       RETURN (false);
    }
 
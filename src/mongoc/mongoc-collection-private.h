@@ -25,6 +25,7 @@
 
 #include "mongoc-buffer-private.h"
 #include "mongoc-client.h"
+#include "mongoc-write-command-private.h"
 
 
 BSON_BEGIN_DECLS
@@ -54,6 +55,10 @@ mongoc_collection_t *_mongoc_collection_new                  (mongoc_client_t
                                                               const mongoc_write_concern_t *write_concern);
 mongoc_cursor_t    *_mongoc_collection_find_indexes_legacy   (mongoc_collection_t          *collection,
                                                               bson_error_t                 *error);
+void                _mongoc_collection_write_command_execute (mongoc_write_command_t       *command,
+                                                              const mongoc_collection_t    *collection,
+                                                              const mongoc_write_concern_t *write_concern,
+                                                              mongoc_write_result_t        *result);
 
 
 BSON_END_DECLS
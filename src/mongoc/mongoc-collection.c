@@ -20,6 +20,7 @@
 
 #include "mongoc-bulk-operation.h"
 #include "mongoc-bulk-operation-private.h"
+#include "mongoc-change-stream-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-find-and-modify-private.h"
 #include "mongoc-find-and-modify.h"
@@ -33,6 +34,7 @@
 #include "mongoc-log.h"
 #include "mongoc-trace.h"
 #include "mongoc-read-concern-private.h"
+#include "mongoc-write-combiner-private.h"
 #include "mongoc-write-concern-private.h"
 
 
@@ -75,7 +77,7 @@ _mongoc_collection_cursor_new (mongoc_collection_t *collection,
                              NULL);              /* read concern */
 }
 
-static void
+void
 _mongoc_collection_write_command_execute (mongoc_write_command_t       *command,
                                           const mongoc_collection_t    *collection,
                                           const mongoc_write_concern_t *write_concern,
@@ -455,6 +457,38 @@ done:
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_watch --
+ *
+ *       Open a change stream on @collection: an aggregation whose pipeline
+ *       begins with $changeStream, followed by the stages in @pipeline.
+ *       @opts may contain "fullDocument", "resumeAfter", "batchSize", and
+ *       "maxAwaitTimeMS".
+ *
+ * Returns:
+ *       A mongoc_change_stream_t, even on failure; errors are reported by
+ *       mongoc_change_stream_error. Free it with
+ *       mongoc_change_stream_destroy.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_change_stream_t *
+mongoc_collection_watch (mongoc_collection_t *collection,
+                         const bson_t        *pipeline,
+                         const bson_t        *opts)
+{
+   BSON_ASSERT (collection);
+
+   return _mongoc_change_stream_new (collection, pipeline, opts);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -724,7 +758,8 @@ mongoc_collection_count_with_opts (mongoc_collection_t       *collection,  /* IN
    apply_read_preferences (read_prefs, server_stream,
                            &cmd, flags, &read_prefs_result);
 
-   success = mongoc_cluster_run_command_monitored (
+   success = _mongoc_single_flight_run_command (
+      collection->client->single_flight,
       cluster, server_stream, read_prefs_result.flags, collection->db,
       read_prefs_result.query_with_read_prefs, &reply, error);
 
@@ -1408,12 +1443,21 @@ mongoc_collection_insert (mongoc_collection_t          *collection,
    }
 
    _mongoc_write_result_init (&result);
-   _mongoc_write_command_init_insert (&command, document, write_flags,
-                                      ++collection->client->cluster.operation_id,
-                                      false);
 
-   _mongoc_collection_write_command_execute (&command, collection,
-                                             write_concern, &result);
+   /* a pooled client may combine this insert with other threads' inserts */
+   if (!collection->client->write_combiner ||
+       !_mongoc_write_combiner_insert (collection->client->write_combiner,
+                                       collection, document, write_concern,
+                                       &result)) {
+      _mongoc_write_command_init_insert (&command, document, write_flags,
+                                         ++collection->client->cluster.operation_id,
+                                         false);
+
+      _mongoc_collection_write_command_execute (&command, collection,
+                                                write_concern, &result);
+
+      _mongoc_write_command_destroy (&command);
+   }
 
    collection->gle = bson_new ();
    ret = _mongoc_write_result_complete (&result,
@@ -1423,7 +1467,6 @@ mongoc_collection_insert (mongoc_collection_t          *collection,
                                         error);
 
    _mongoc_write_result_destroy (&result);
-   _mongoc_write_command_destroy (&command);
 
    RETURN (ret);
 }
@@ -24,6 +24,7 @@
 #include <bson.h>
 
 #include "mongoc-bulk-operation.h"
+#include "mongoc-change-stream.h"
 #include "mongoc-flags.h"
 #include "mongoc-cursor.h"
 #include "mongoc-index.h"
@@ -50,6 +51,9 @@ mongoc_cursor_t               *mongoc_collection_aggregate_with_write_concern
                                                                       const bson_t                  *options,
                                                                       const mongoc_read_prefs_t     *read_prefs,
                                                                       mongoc_write_concern_t        *write_concern) BSON_GNUC_WARN_UNUSED_RESULT;
+mongoc_change_stream_t       *mongoc_collection_watch                (mongoc_collection_t           *collection,
+                                                                      const bson_t                  *pipeline,
+                                                                      const bson_t                  *opts) BSON_GNUC_WARN_UNUSED_RESULT;
 void                          mongoc_collection_destroy              (mongoc_collection_t           *collection);
 mongoc_collection_t          *mongoc_collection_copy                 (mongoc_collection_t           *collection);
 mongoc_cursor_t              *mongoc_collection_command              (mongoc_collection_t           *collection,
@@ -43,6 +43,7 @@ bool _mongoc_cursor_cursorid_start_batch    (mongoc_cursor_t  *cursor);
 bool _mongoc_cursor_cursorid_prime          (mongoc_cursor_t  *cursor);
 bool _mongoc_cursor_cursorid_next           (mongoc_cursor_t  *cursor,
                                              const bson_t    **bson);
+bool _mongoc_cursor_cursorid_batch_done     (mongoc_cursor_t  *cursor);
 void _mongoc_cursor_cursorid_init           (mongoc_cursor_t  *cursor,
                                              const bson_t     *command);
 bool _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t  *cursor,
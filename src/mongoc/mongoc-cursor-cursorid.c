@@ -298,8 +298,40 @@ again:
    }
 
 done:
-   cursor->done = *bson ? false : true;
-   RETURN (!cursor->done);
+   /* a tailable cursor outlives an empty batch while the server keeps it */
+   cursor->done = !*bson &&
+                  !((cursor->flags & MONGOC_QUERY_TAILABLE_CURSOR) &&
+                    mongoc_cursor_get_id (cursor) &&
+                    !cursor->error.domain);
+   RETURN (*bson != NULL);
+}
+
+
+/*
+ * True if the document last returned by _mongoc_cursor_cursorid_next was the
+ * final one in the current batch, meaning the next call will free or replace
+ * the memory it points into.
+ */
+bool
+_mongoc_cursor_cursorid_batch_done (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_cursorid_t *cid;
+   bson_iter_t iter;
+
+   cid = (mongoc_cursor_cursorid_t *)cursor->iface_data;
+   BSON_ASSERT (cid);
+
+   if (cid->in_batch) {
+      memcpy (&iter, &cid->batch_iter, sizeof iter);
+      return !bson_iter_next (&iter);
+   }
+
+   if (cid->in_reader && cursor->reader) {
+      return bson_reader_tell (cursor->reader) >=
+             (off_t) cursor->rpc.reply.documents_len;
+   }
+
+   return true;
 }
 
 
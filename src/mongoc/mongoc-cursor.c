@@ -15,6 +15,7 @@
  */
 
 
+#include "mongoc-array-private.h"
 #include "mongoc-cursor.h"
 #include "mongoc-cursor-private.h"
 #include "mongoc-client-private.h"
@@ -24,6 +25,7 @@
 #include "mongoc-trace.h"
 #include "mongoc-cursor-cursorid-private.h"
 #include "mongoc-read-concern-private.h"
+#include "mongoc-stream-private.h"
 #include "mongoc-util-private.h"
 
 
@@ -33,6 +35,11 @@
 
 #define CURSOR_FAILED(cursor_) ((cursor_)->error.domain != 0)
 
+/* most platforms reject a writev with more than 1024 iovecs */
+#ifndef MONGOC_CURSOR_DUMP_IOV_MAX
+# define MONGOC_CURSOR_DUMP_IOV_MAX 1024
+#endif
+
 static const bson_t *
 _mongoc_cursor_op_query (mongoc_cursor_t        *cursor,
                          mongoc_server_stream_t *server_stream);
@@ -253,7 +260,7 @@ _mongoc_cursor_new (mongoc_client_t           *client,
       cursor->read_concern = mongoc_read_concern_copy (read_concern);
    }
 
-   _mongoc_buffer_init(&cursor->buffer, NULL, 0, NULL, NULL);
+   _mongoc_buffer_init_from_pool (&cursor->buffer, client->buffer_pool);
 
 finish:
    mongoc_counter_cursors_active_inc();
@@ -752,7 +759,8 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
    apply_read_preferences (cursor->read_prefs, server_stream,
                            command, cursor->flags, &read_prefs_result);
 
-   ret = mongoc_cluster_run_command_monitored (
+   ret = _mongoc_single_flight_run_command (
+      cursor->client->single_flight,
       cluster,
       server_stream,
       read_prefs_result.flags,
@@ -1467,7 +1475,7 @@ _mongoc_cursor_clone (const mongoc_cursor_t *cursor)
 
    bson_strncpy (_clone->ns, cursor->ns, sizeof _clone->ns);
 
-   _mongoc_buffer_init (&_clone->buffer, NULL, 0, NULL, NULL);
+   _mongoc_buffer_init_from_pool (&_clone->buffer, cursor->client->buffer_pool);
 
    mongoc_counter_cursors_active_inc ();
 
@@ -1651,3 +1659,126 @@ mongoc_cursor_new_from_command_reply (mongoc_client_t *client,
 
    return cursor;
 }
+
+
+/*
+ * True if the document last returned by mongoc_cursor_next is the final one
+ * in the reply we have buffered, so the next call reuses that memory.
+ */
+static bool
+_mongoc_cursor_batch_done (mongoc_cursor_t *cursor)
+{
+   if (cursor->iface.next == _mongoc_cursor_cursorid_next) {
+      return _mongoc_cursor_cursorid_batch_done (cursor);
+   }
+
+   if (!cursor->iface.next && cursor->reader) {
+      return bson_reader_tell (cursor->reader) >=
+             (off_t) cursor->rpc.reply.documents_len;
+   }
+
+   /* unknown storage, don't hold on to the document */
+   return true;
+}
+
+
+static bool
+_mongoc_cursor_dump_iov (mongoc_cursor_t *cursor,
+                         mongoc_stream_t *stream,
+                         mongoc_array_t  *iov,
+                         bson_error_t    *error)
+{
+   bool ret;
+
+   if (!iov->len) {
+      return true;
+   }
+
+   ret = _mongoc_stream_writev_full (stream,
+                                     (mongoc_iovec_t *) iov->data,
+                                     iov->len,
+                                     cursor->client->cluster.sockettimeoutms,
+                                     error);
+
+   _mongoc_array_clear (iov);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cursor_dump_to_stream --
+ *
+ *       Exhaust @cursor, writing each document's raw BSON to @stream.
+ *
+ *       Documents are not copied: each one is referenced in place in the
+ *       reply buffer and every batch is written with a single writev.
+ *       Documents that are adjacent in the reply, as they are in
+ *       OP_REPLY messages, are merged into one iovec.
+ *
+ * Returns:
+ *       true if the cursor was exhausted and all documents were written,
+ *       otherwise false and @error is set.
+ *
+ * Side effects:
+ *       Advances @cursor to its end.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cursor_dump_to_stream (mongoc_cursor_t *cursor,
+                              mongoc_stream_t *stream,
+                              bson_error_t    *error)
+{
+   mongoc_array_t iov;
+   mongoc_iovec_t *last;
+   mongoc_iovec_t item;
+   const bson_t *doc;
+   bool ret = true;
+
+   ENTRY;
+
+   BSON_ASSERT (cursor);
+   BSON_ASSERT (stream);
+
+   _mongoc_array_init (&iov, sizeof (mongoc_iovec_t));
+
+   while (mongoc_cursor_next (cursor, &doc)) {
+      item.iov_base = (void *) bson_get_data (doc);
+      item.iov_len = doc->len;
+
+      last = iov.len
+         ? &_mongoc_array_index (&iov, mongoc_iovec_t, iov.len - 1)
+         : NULL;
+
+      if (last && (char *) last->iov_base + last->iov_len ==
+                  (char *) item.iov_base) {
+         last->iov_len += item.iov_len;
+      } else {
+         _mongoc_array_append_val (&iov, item);
+      }
+
+      if (iov.len >= MONGOC_CURSOR_DUMP_IOV_MAX ||
+          _mongoc_cursor_batch_done (cursor)) {
+         if (!_mongoc_cursor_dump_iov (cursor, stream, &iov, error)) {
+            ret = false;
+            GOTO (done);
+         }
+      }
+   }
+
+   if (mongoc_cursor_error (cursor, error)) {
+      ret = false;
+      GOTO (done);
+   }
+
+   ret = _mongoc_cursor_dump_iov (cursor, stream, &iov, error);
+
+done:
+   _mongoc_array_destroy (&iov);
+
+   RETURN (ret);
+}
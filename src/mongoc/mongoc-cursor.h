@@ -24,6 +24,7 @@
 #include <bson.h>
 
 #include "mongoc-host-list.h"
+#include "mongoc-stream.h"
 
 
 BSON_BEGIN_DECLS
@@ -65,6 +66,9 @@ mongoc_cursor_t *mongoc_cursor_new_from_command_reply (struct _mongoc_client_t *
                                                        bson_t                  *reply,
                                                        uint32_t                 server_id)
    BSON_GNUC_WARN_UNUSED_RESULT;
+bool             mongoc_cursor_dump_to_stream         (mongoc_cursor_t         *cursor,
+                                                       mongoc_stream_t         *stream,
+                                                       bson_error_t            *error);
 
 BSON_END_DECLS
 
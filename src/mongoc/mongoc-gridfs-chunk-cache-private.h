@@ -0,0 +1,66 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_GRIDFS_CHUNK_CACHE_PRIVATE_H
+#define MONGOC_GRIDFS_CHUNK_CACHE_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct
+{
+   int32_t   n;
+   uint8_t  *data;
+   uint32_t  len;
+   /* the cache's clock when the chunk was last put or got */
+   uint64_t  used;
+} mongoc_gridfs_chunk_cache_entry_t;
+
+
+typedef struct
+{
+   mongoc_gridfs_chunk_cache_entry_t *entries;
+   uint32_t                           capacity;
+   uint32_t                           count;
+   uint64_t                           clock;
+} mongoc_gridfs_chunk_cache_t;
+
+
+mongoc_gridfs_chunk_cache_t *_mongoc_gridfs_chunk_cache_new     (uint32_t                     capacity);
+void                         _mongoc_gridfs_chunk_cache_destroy (mongoc_gridfs_chunk_cache_t *cache);
+bool                         _mongoc_gridfs_chunk_cache_get     (mongoc_gridfs_chunk_cache_t *cache,
+                                                                 int32_t                      n,
+                                                                 const uint8_t              **data,
+                                                                 uint32_t                    *len);
+void                         _mongoc_gridfs_chunk_cache_put     (mongoc_gridfs_chunk_cache_t *cache,
+                                                                 int32_t                      n,
+                                                                 const uint8_t               *data,
+                                                                 uint32_t                     len);
+void                         _mongoc_gridfs_chunk_cache_remove  (mongoc_gridfs_chunk_cache_t *cache,
+                                                                 int32_t                      n);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_GRIDFS_CHUNK_CACHE_PRIVATE_H */
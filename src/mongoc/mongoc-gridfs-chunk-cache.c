@@ -0,0 +1,189 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc-gridfs-chunk-cache-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "gridfs_chunk_cache"
+
+
+/*
+ * A GridFS file's cache of the chunks it read last, for readers that seek
+ * back and forth within a file. Each entry owns a copy of a chunk's data.
+ * A cache holds tens of chunks, so a lookup scans the entries, and the
+ * least recently used one is found by its clock when room is needed.
+ */
+
+
+mongoc_gridfs_chunk_cache_t *
+_mongoc_gridfs_chunk_cache_new (uint32_t capacity)
+{
+   mongoc_gridfs_chunk_cache_t *cache;
+
+   BSON_ASSERT (capacity);
+
+   cache = (mongoc_gridfs_chunk_cache_t *)bson_malloc0 (sizeof *cache);
+   cache->entries = (mongoc_gridfs_chunk_cache_entry_t *)bson_malloc0 (
+      capacity * sizeof *cache->entries);
+   cache->capacity = capacity;
+
+   return cache;
+}
+
+
+void
+_mongoc_gridfs_chunk_cache_destroy (mongoc_gridfs_chunk_cache_t *cache)
+{
+   uint32_t i;
+
+   if (!cache) {
+      return;
+   }
+
+   for (i = 0; i < cache->count; i++) {
+      bson_free (cache->entries[i].data);
+   }
+
+   bson_free (cache->entries);
+   bson_free (cache);
+}
+
+
+static mongoc_gridfs_chunk_cache_entry_t *
+_mongoc_gridfs_chunk_cache_find (mongoc_gridfs_chunk_cache_t *cache,
+                                 int32_t                      n)
+{
+   uint32_t i;
+
+   for (i = 0; i < cache->count; i++) {
+      if (cache->entries[i].n == n) {
+         return &cache->entries[i];
+      }
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_chunk_cache_get --
+ *
+ *       Look up chunk number @n and mark it used.
+ *
+ * Returns:
+ *       true and sets @data and @len if the chunk is cached. @data belongs
+ *       to the cache and is valid until the next put or remove.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_gridfs_chunk_cache_get (mongoc_gridfs_chunk_cache_t *cache,
+                                int32_t                      n,
+                                const uint8_t              **data,
+                                uint32_t                    *len)
+{
+   mongoc_gridfs_chunk_cache_entry_t *entry;
+
+   BSON_ASSERT (cache);
+   BSON_ASSERT (data);
+   BSON_ASSERT (len);
+
+   if (!(entry = _mongoc_gridfs_chunk_cache_find (cache, n))) {
+      return false;
+   }
+
+   entry->used = ++cache->clock;
+   *data = entry->data;
+   *len = entry->len;
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_chunk_cache_put --
+ *
+ *       Cache a copy of chunk number @n, evicting the least recently used
+ *       chunk if the cache is full.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_gridfs_chunk_cache_put (mongoc_gridfs_chunk_cache_t *cache,
+                                int32_t                      n,
+                                const uint8_t               *data,
+                                uint32_t                     len)
+{
+   mongoc_gridfs_chunk_cache_entry_t *entry;
+   uint32_t i;
+
+   BSON_ASSERT (cache);
+   BSON_ASSERT (data || !len);
+
+   if (!(entry = _mongoc_gridfs_chunk_cache_find (cache, n))) {
+      if (cache->count < cache->capacity) {
+         entry = &cache->entries[cache->count++];
+      } else {
+         entry = &cache->entries[0];
+
+         for (i = 1; i < cache->count; i++) {
+            if (cache->entries[i].used < entry->used) {
+               entry = &cache->entries[i];
+            }
+         }
+      }
+
+      entry->n = n;
+   }
+
+   bson_free (entry->data);
+   entry->data = (uint8_t *)bson_malloc (len ? len : 1);
+
+   if (len) {
+      memcpy (entry->data, data, len);
+   }
+
+   entry->len = len;
+   entry->used = ++cache->clock;
+}
+
+
+/* forget chunk number @n, if cached, after it is rewritten */
+void
+_mongoc_gridfs_chunk_cache_remove (mongoc_gridfs_chunk_cache_t *cache,
+                                   int32_t                      n)
+{
+   mongoc_gridfs_chunk_cache_entry_t *entry;
+
+   BSON_ASSERT (cache);
+
+   if (!(entry = _mongoc_gridfs_chunk_cache_find (cache, n))) {
+      return;
+   }
+
+   bson_free (entry->data);
+
+   /* the last entry takes the freed slot */
+   *entry = cache->entries[--cache->count];
+   memset (&cache->entries[cache->count], 0, sizeof *entry);
+}
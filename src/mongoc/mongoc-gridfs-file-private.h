@@ -23,42 +23,75 @@
 
 #include <bson.h>
 
+#include "mongoc-bulk-operation.h"
 #include "mongoc-gridfs.h"
+#include "mongoc-gridfs-chunk-cache-private.h"
 #include "mongoc-gridfs-file.h"
 #include "mongoc-gridfs-file-page.h"
+#include "mongoc-gridfs-transfer-private.h"
 #include "mongoc-cursor.h"
 
 
 BSON_BEGIN_DECLS
 
 
+typedef enum
+{
+   MONGOC_GRIDFS_COMPRESSOR_NONE,
+   MONGOC_GRIDFS_COMPRESSOR_ZLIB,
+   /* named in the files document, but not built into this driver */
+   MONGOC_GRIDFS_COMPRESSOR_UNSUPPORTED
+} mongoc_gridfs_compressor_t;
+
+
 struct _mongoc_gridfs_file_t
 {
-   mongoc_gridfs_t           *gridfs;
-   bson_t                     bson;
-   mongoc_gridfs_file_page_t *page;
-   uint64_t                   pos;
-   int32_t                    n;
-   bson_error_t               error;
-   mongoc_cursor_t           *cursor;
-   uint32_t                   cursor_range[2]; /* current chunk, # of chunks */
-   bool                       is_dirty;
-
-   bson_value_t               files_id;
-   int64_t                    length;
-   int32_t                    chunk_size;
-   int64_t                    upload_date;
-
-   char                      *md5;
-   char                      *filename;
-   char                      *content_type;
-   bson_t                     aliases;
-   bson_t                     metadata;
-   const char                *bson_md5;
-   const char                *bson_filename;
-   const char                *bson_content_type;
-   bson_t                     bson_aliases;
-   bson_t                     bson_metadata;
+   mongoc_gridfs_t             *gridfs;
+   bson_t                       bson;
+   mongoc_gridfs_file_page_t   *page;
+   uint64_t                     pos;
+   int32_t                      n;
+   bson_error_t                 error;
+   mongoc_cursor_t             *cursor;
+   uint32_t                     cursor_range[2]; /* current chunk, # of chunks */
+   bool                         is_dirty;
+   /* chunks move on several connections at once if set */
+   mongoc_gridfs_transfer_t    *transfer;
+   /* chunks appended past the stored end of the file, inserted together */
+   mongoc_bulk_operation_t     *chunk_batch;
+   uint32_t                     chunk_batch_size;
+   /* the first chunk number the server has never stored */
+   int32_t                      first_new_n;
+   /* copies of the chunks read last, if set */
+   mongoc_gridfs_chunk_cache_t *chunk_cache;
+   /* moved by a seek since the last read */
+   bool                         seeked;
+   /* md5 of the file's bytes, while they have all been appended in order */
+   bson_md5_t                   md5_ctx;
+   bool                         md5_ok;
+   /* the files document holds an md5 computed from md5_ctx */
+   bool                         md5_saved;
+   /* each chunk's data is compressed, unlike the page */
+   mongoc_gridfs_compressor_t   compressor;
+   int32_t                      compression_level;
+   uint8_t                     *compress_buf;
+   uint8_t                     *decompress_buf;
+
+   bson_value_t                 files_id;
+   int64_t                      length;
+   int32_t                      chunk_size;
+   int64_t                      upload_date;
+
+   char                        *md5;
+   char                        *filename;
+   char                        *content_type;
+   bson_t                       aliases;
+   bson_t                       metadata;
+   const char                  *bson_md5;
+   const char                  *bson_filename;
+   const char                  *bson_content_type;
+   bson_t                       bson_aliases;
+   bson_t                       bson_metadata;
 };
 
 
@@ -22,8 +22,19 @@
 #include <time.h>
 #include <errno.h>
 
+#include "mongoc-config.h"
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+#include <zlib.h>
+#endif
+
+#include "mongoc-bulk-operation.h"
+#include "mongoc-bulk-operation-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
 #include "mongoc-cursor.h"
 #include "mongoc-cursor-private.h"
+#include "mongoc-gridfs-chunk-cache-private.h"
 #include "mongoc-collection.h"
 #include "mongoc-gridfs.h"
 #include "mongoc-gridfs-private.h"
@@ -31,16 +42,25 @@
 #include "mongoc-gridfs-file-private.h"
 #include "mongoc-gridfs-file-page.h"
 #include "mongoc-gridfs-file-page-private.h"
+#include "mongoc-gridfs-transfer-private.h"
 #include "mongoc-iovec.h"
 #include "mongoc-trace.h"
 #include "mongoc-error.h"
 
 static bool
-_mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file);
+_mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file,
+                                  int32_t               last_n);
 
 static bool
 _mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file);
 
+static bool
+_mongoc_gridfs_file_send_chunk_batch (mongoc_gridfs_file_t *file);
+
+static bool
+_mongoc_gridfs_file_write_whole_chunk (mongoc_gridfs_file_t *file,
+                                       const uint8_t        *data);
+
 static ssize_t
 _mongoc_gridfs_file_extend (mongoc_gridfs_file_t *file);
 
@@ -122,12 +142,44 @@ mongoc_gridfs_file_set_id (mongoc_gridfs_file_t *file, const bson_value_t *id,
    return true; 
 }
 
+/* the hex md5 of the whole file, if every byte was appended in order by
+ * this mongoc_gridfs_file_t */
+static bool
+_mongoc_gridfs_file_hex_md5 (mongoc_gridfs_file_t *file,
+                             char                  hex[33])
+{
+   bson_md5_t md5;
+   uint8_t digest[16];
+   int i;
+
+   if (!file->md5_ok) {
+      return false;
+   }
+
+   /* finish a copy, more bytes may be appended after this save */
+   memcpy (&md5, &file->md5_ctx, sizeof md5);
+   bson_md5_finish (&md5, digest);
+
+   for (i = 0; i < sizeof digest; i++) {
+      bson_snprintf (&hex[i * 2], 3, "%02x", digest[i]);
+   }
+
+   hex[32] = '\0';
+
+   return true;
+}
+
+
 /** save a gridfs file */
 bool
 mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
 {
    bson_t *selector, *update, child;
    const char *md5;
+   char md5_str[33];
+   bool computed_md5;
+   bool unset_md5;
+   bool unset_compression;
    const char *filename;
    const char *content_type;
    const bson_t *aliases;
@@ -144,7 +196,23 @@ mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
       _mongoc_gridfs_file_flush_page (file);
    }
 
+   /* describe only chunks the server has stored */
+   if (!_mongoc_gridfs_file_send_chunk_batch (file)) {
+      RETURN (false);
+   }
+
+   if (file->transfer && !_mongoc_gridfs_transfer_drain (file->transfer)) {
+      RETURN (false);
+   }
+
    md5 = mongoc_gridfs_file_get_md5 (file);
+
+   /* without the caller's md5, describe the bytes this file wrote itself */
+   computed_md5 = !md5 && _mongoc_gridfs_file_hex_md5 (file, md5_str);
+   if (computed_md5) {
+      md5 = md5_str;
+   }
+
    filename = mongoc_gridfs_file_get_filename (file);
    content_type = mongoc_gridfs_file_get_content_type (file);
    aliases = mongoc_gridfs_file_get_aliases (file);
@@ -179,11 +247,36 @@ mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
       bson_append_document (&child, "metadata", -1, metadata);
    }
 
+   if (file->compressor == MONGOC_GRIDFS_COMPRESSOR_ZLIB) {
+      bson_append_utf8 (&child, "compression", -1, "zlib", -1);
+   }
+
    bson_append_document_end (update, &child);
 
+   /* a rewrite made the md5 saved before wrong */
+   unset_md5 = !md5 && file->md5_saved;
+   unset_compression = file->compressor == MONGOC_GRIDFS_COMPRESSOR_NONE &&
+                       file->bson.len &&
+                       bson_has_field (&file->bson, "compression");
+
+   if (unset_md5 || unset_compression) {
+      bson_append_document_begin (update, "$unset", -1, &child);
+      if (unset_md5) {
+         bson_append_utf8 (&child, "md5", -1, "", 0);
+      }
+      if (unset_compression) {
+         bson_append_utf8 (&child, "compression", -1, "", 0);
+      }
+      bson_append_document_end (update, &child);
+   }
+
    r = mongoc_collection_update (file->gridfs->files, MONGOC_UPDATE_UPSERT,
                                  selector, update, NULL, &file->error);
 
+   if (r) {
+      file->md5_saved = computed_md5;
+   }
+
    bson_destroy (selector);
    bson_destroy (update);
 
@@ -193,6 +286,175 @@ mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
 }
 
 
+/* destroy the file's transfer once neither parallel transfer nor read-ahead
+ * is on */
+static void
+_mongoc_gridfs_file_release_transfer (mongoc_gridfs_file_t *file)
+{
+   if (file->transfer &&
+       !file->transfer->parallel && !file->transfer->read_ahead) {
+      /* a clean page may read from a fetched chunk's memory */
+      if (file->page && !_mongoc_gridfs_file_page_is_dirty (file->page)) {
+         _mongoc_gridfs_file_page_destroy (file->page);
+         file->page = NULL;
+      }
+
+      _mongoc_gridfs_transfer_destroy (file->transfer);
+      file->transfer = NULL;
+   }
+}
+
+
+/**
+ * mongoc_gridfs_file_set_parallel:
+ *
+ * move chunks on up to max_connections connections of their own, with up to
+ * max_chunks_in_flight uploads or fetches pending. 0 connections goes back
+ * to one chunk at a time on the gridfs client.
+ */
+void
+mongoc_gridfs_file_set_parallel (mongoc_gridfs_file_t *file,
+                                 uint32_t              max_connections,
+                                 uint32_t              max_chunks_in_flight)
+{
+   ENTRY;
+
+   BSON_ASSERT (file);
+
+   if (file->transfer) {
+      /* a failed upload leaves its error for mongoc_gridfs_file_error */
+      _mongoc_gridfs_transfer_drain (file->transfer);
+   } else if (max_connections) {
+      file->transfer = _mongoc_gridfs_transfer_new (file);
+   } else {
+      EXIT;
+   }
+
+   _mongoc_gridfs_transfer_set_parallel (file->transfer, max_connections,
+                                         max_chunks_in_flight);
+   _mongoc_gridfs_file_release_transfer (file);
+
+   EXIT;
+}
+
+
+/**
+ * mongoc_gridfs_file_set_read_ahead:
+ *
+ * once reads are sequential, keep the next n_chunks chunks on their way while
+ * the current one is read. 0 turns read-ahead off.
+ */
+void
+mongoc_gridfs_file_set_read_ahead (mongoc_gridfs_file_t *file,
+                                   uint32_t              n_chunks)
+{
+   ENTRY;
+
+   BSON_ASSERT (file);
+
+   if (!file->transfer) {
+      if (!n_chunks) {
+         EXIT;
+      }
+
+      file->transfer = _mongoc_gridfs_transfer_new (file);
+   }
+
+   _mongoc_gridfs_transfer_set_read_ahead (file->transfer, n_chunks);
+   _mongoc_gridfs_file_release_transfer (file);
+
+   EXIT;
+}
+
+
+/**
+ * mongoc_gridfs_file_set_chunk_cache:
+ *
+ * keep copies of the last n_chunks chunks read, for readers that seek back
+ * and forth. 0 turns the cache off.
+ */
+void
+mongoc_gridfs_file_set_chunk_cache (mongoc_gridfs_file_t *file,
+                                    uint32_t              n_chunks)
+{
+   ENTRY;
+
+   BSON_ASSERT (file);
+
+   if (file->chunk_cache) {
+      /* a clean page may read from the cache's memory */
+      if (file->page && !_mongoc_gridfs_file_page_is_dirty (file->page)) {
+         _mongoc_gridfs_file_page_destroy (file->page);
+         file->page = NULL;
+      }
+
+      _mongoc_gridfs_chunk_cache_destroy (file->chunk_cache);
+      file->chunk_cache = NULL;
+   }
+
+   if (n_chunks) {
+      file->chunk_cache = _mongoc_gridfs_chunk_cache_new (n_chunks);
+   }
+
+   EXIT;
+}
+
+
+/**
+ * mongoc_gridfs_file_set_compression:
+ *
+ * compress each chunk with compressor, "zlib" or NULL for none, at level, or
+ * -1 for the compressor's default. only a file with no data can change.
+ */
+bool
+mongoc_gridfs_file_set_compression (mongoc_gridfs_file_t *file,
+                                    const char           *compressor,
+                                    int32_t               level,
+                                    bson_error_t         *error)
+{
+   ENTRY;
+
+   BSON_ASSERT (file);
+
+   if (file->length || file->page) {
+      bson_set_error (error,
+                      MONGOC_ERROR_GRIDFS,
+                      MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                      "Cannot change the compression of a file with data.");
+      RETURN (false);
+   }
+
+   if (!compressor) {
+      file->compressor = MONGOC_GRIDFS_COMPRESSOR_NONE;
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   } else if (!strcmp (compressor, "zlib")) {
+      if (level < Z_DEFAULT_COMPRESSION || level > Z_BEST_COMPRESSION) {
+         bson_set_error (error,
+                         MONGOC_ERROR_COMMAND,
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                         "Invalid zlib compression level %" PRId32 ".",
+                         level);
+         RETURN (false);
+      }
+
+      file->compressor = MONGOC_GRIDFS_COMPRESSOR_ZLIB;
+#endif
+   } else {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Unsupported compressor \"%s\".",
+                      compressor);
+      RETURN (false);
+   }
+
+   file->compression_level = level;
+   file->is_dirty = true;
+
+   RETURN (true);
+}
+
+
 /**
  * _mongoc_gridfs_file_new_from_bson:
  *
@@ -220,6 +482,7 @@ _mongoc_gridfs_file_new_from_bson (mongoc_gridfs_t *gridfs,
    file = (mongoc_gridfs_file_t *)bson_malloc0 (sizeof *file);
 
    file->gridfs = gridfs;
+   file->compression_level = -1;
    bson_copy_to (data, &file->bson);
 
    bson_iter_init (&iter, &file->bson);
@@ -279,12 +542,29 @@ _mongoc_gridfs_file_new_from_bson (mongoc_gridfs_t *gridfs,
          }
          bson_iter_document (&iter, &buf_len, &buf);
          bson_init_static (&file->bson_metadata, buf, buf_len);
+      } else if (0 == strcmp (key, "compression")) {
+         if (!BSON_ITER_HOLDS_UTF8 (&iter)) {
+            GOTO (failure);
+         }
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+         if (0 == strcmp (bson_iter_utf8 (&iter, NULL), "zlib")) {
+            file->compressor = MONGOC_GRIDFS_COMPRESSOR_ZLIB;
+            continue;
+         }
+#endif
+         /* fail on the first chunk read or written */
+         file->compressor = MONGOC_GRIDFS_COMPRESSOR_UNSUPPORTED;
       }
    }
 
    /* TODO: is there are a minimal object we should be verifying that we
     * actually have here? */
 
+   if (file->chunk_size > 0) {
+      file->first_new_n = (int32_t)((file->length + file->chunk_size - 1) /
+                                    file->chunk_size);
+   }
+
    RETURN (file);
 
 failure:
@@ -359,6 +639,11 @@ _mongoc_gridfs_file_new (mongoc_gridfs_t          *gridfs,
    file->pos = 0;
    file->n = 0;
 
+   bson_md5_init (&file->md5_ctx);
+   file->md5_ok = true;
+
+   file->compression_level = -1;
+
    RETURN (file);
 }
 
@@ -369,8 +654,24 @@ mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file)
 
    BSON_ASSERT (file);
 
+   /* batched chunks are sent only when the file is saved: save it, dirty
+    * page included, so the files document describes exactly the chunks
+    * stored rather than leave them unsent. Nothing returns the error, so
+    * log it */
+   if (file->chunk_batch && !mongoc_gridfs_file_save (file)) {
+      bson_error_t error;
+
+      if (!mongoc_gridfs_file_error (file, &error)) {
+         bson_snprintf (error.message, sizeof error.message, "unknown error");
+      }
+
+      MONGOC_WARNING ("Failed to save GridFS file on destroy: %s",
+                      error.message);
+   }
+
    if (file->page) {
       _mongoc_gridfs_file_page_destroy (file->page);
+      file->page = NULL;
    }
 
    if (file->bson.len) {
@@ -381,6 +682,13 @@ mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file)
       mongoc_cursor_destroy (file->cursor);
    }
 
+   _mongoc_gridfs_chunk_cache_destroy (file->chunk_cache);
+
+   if (file->transfer) {
+      _mongoc_gridfs_transfer_drain (file->transfer);
+      _mongoc_gridfs_transfer_destroy (file->transfer);
+   }
+
    if (file->files_id.value_type) {
       bson_value_destroy (&file->files_id);
    }
@@ -413,6 +721,9 @@ mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file)
       bson_destroy (&file->bson_metadata);
    }
 
+   bson_free (file->compress_buf);
+   bson_free (file->decompress_buf);
+
    bson_free (file);
 
    EXIT;
@@ -431,6 +742,8 @@ mongoc_gridfs_file_readv (mongoc_gridfs_file_t *file,
    int32_t r;
    size_t i;
    uint32_t iov_pos;
+   uint64_t end;
+   int32_t last_n = -1;
 
    ENTRY;
 
@@ -446,8 +759,22 @@ mongoc_gridfs_file_readv (mongoc_gridfs_file_t *file,
       return 0;
    }
 
+   /* after a seek, ask for just the chunks this read covers; a reader that
+    * goes on in order gets the whole rest of the file in batches */
+   if (file->seeked) {
+      end = file->pos;
+
+      for (i = 0; i < iovcnt; i++) {
+         end += iov[i].iov_len;
+      }
+
+      end = BSON_MIN (end, (uint64_t)file->length);
+      last_n = (int32_t)((end - 1) / file->chunk_size);
+      file->seeked = false;
+   }
+
    /* Try to get the current chunk */
-   if (!file->page && !_mongoc_gridfs_file_refresh_page (file)) {
+   if (!file->page && !_mongoc_gridfs_file_refresh_page (file, last_n)) {
       return -1;
    }
 
@@ -473,7 +800,7 @@ mongoc_gridfs_file_readv (mongoc_gridfs_file_t *file,
          } else if (bytes_read >= min_bytes) {
             /* we need a new page, but we've read enough bytes to stop */
             RETURN (bytes_read);
-         } else if (!_mongoc_gridfs_file_refresh_page (file)) {
+         } else if (!_mongoc_gridfs_file_refresh_page (file, last_n)) {
             /* more to read, just on a new page */
             return -1;
          }
@@ -495,6 +822,7 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
    int32_t r;
    size_t i;
    uint32_t iov_pos;
+   bool hash;
 
    ENTRY;
 
@@ -505,10 +833,9 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
 
    /* TODO: we should probably do something about timeout_msec here */
 
-   /* Pull in the correct page */
-   if (!file->page && !_mongoc_gridfs_file_refresh_page (file)) {
-      return -1;
-   }
+   /* the md5 can follow appends, not rewrites or a zero-filled gap */
+   hash = file->md5_ok && (int64_t)file->pos == file->length;
+   file->md5_ok = false;
 
    /* When writing past the end-of-file, fill the gap with zeros */
    if (file->pos > file->length && !_mongoc_gridfs_file_extend (file)) {
@@ -519,7 +846,25 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
       iov_pos = 0;
 
       for (;; ) {
-         if (!file->page && !_mongoc_gridfs_file_refresh_page (file)) {
+         /* a whole aligned chunk goes from the caller's memory to the
+          * server without a page, and without fetching the chunk it
+          * replaces */
+         while (!(file->pos % file->chunk_size) &&
+                iov[i].iov_len - iov_pos >= (size_t)file->chunk_size) {
+            if (!_mongoc_gridfs_file_write_whole_chunk (
+                   file, (uint8_t *)iov[i].iov_base + iov_pos)) {
+               return -1;
+            }
+
+            iov_pos += file->chunk_size;
+            bytes_written += file->chunk_size;
+         }
+
+         if (iov_pos == iov[i].iov_len) {
+            break;
+         }
+
+         if (!file->page && !_mongoc_gridfs_file_refresh_page (file, -1)) {
             return -1;
          }
 
@@ -547,6 +892,15 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
 
    file->is_dirty = 1;
 
+   if (hash) {
+      for (i = 0; i < iovcnt; i++) {
+         bson_md5_append (&file->md5_ctx, (const uint8_t *)iov[i].iov_base,
+                          (uint32_t)iov[i].iov_len);
+      }
+
+      file->md5_ok = true;
+   }
+
    RETURN (bytes_written);
 }
 
@@ -585,7 +939,7 @@ _mongoc_gridfs_file_extend (mongoc_gridfs_file_t *file)
    mongoc_gridfs_file_seek (file, 0, SEEK_END);
 
    while (true) {
-      if (!file->page && !_mongoc_gridfs_file_refresh_page (file)) {
+      if (!file->page && !_mongoc_gridfs_file_refresh_page (file, -1)) {
          RETURN (-1);
       }
 
@@ -610,33 +964,283 @@ _mongoc_gridfs_file_extend (mongoc_gridfs_file_t *file)
 
 
 /**
- * _mongoc_gridfs_file_flush_page:
+ * _mongoc_gridfs_file_send_chunk_batch:
  *
- *    Unconditionally flushes the file's current page to the database.
- *    The page to flush is determined by page->n.
+ *    Insert the chunks batched by _mongoc_gridfs_file_batch_chunk, if any.
  *
  * Side Effects:
  *
- *    On success, file->page is properly destroyed and set to NULL.
+ *    file->chunk_batch is destroyed and set to NULL. file->error is set on
+ *    error.
  *
  * Returns:
  *
  *    True on success; false otherwise.
  */
 static bool
-_mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
+_mongoc_gridfs_file_send_chunk_batch (mongoc_gridfs_file_t *file)
+{
+   bool r;
+
+   ENTRY;
+
+   if (!file->chunk_batch) {
+      RETURN (true);
+   }
+
+   r = mongoc_bulk_operation_execute (file->chunk_batch, NULL, &file->error);
+
+   mongoc_bulk_operation_destroy (file->chunk_batch);
+   file->chunk_batch = NULL;
+   file->chunk_batch_size = 0;
+
+   RETURN (r);
+}
+
+
+/**
+ * _mongoc_gridfs_file_batch_chunk:
+ *
+ *    Add chunk number file->n, which the server has never stored, to a
+ *    batch of inserts. The batch is sent when the next chunk would take it
+ *    past the server's maxMessageSizeBytes, or before anything that must
+ *    see the chunks stored: a rewrite, a read, a save.
+ *
+ * Returns:
+ *
+ *    True on success; false if a full batch couldn't be sent.
+ */
+static bool
+_mongoc_gridfs_file_batch_chunk (mongoc_gridfs_file_t *file,
+                                 const uint8_t        *data,
+                                 uint32_t              len)
+{
+   mongoc_write_command_t *command;
+   bson_t chunk;
+   bson_oid_t oid;
+   int32_t max_msg_size;
+   uint32_t batch_len;
+
+   ENTRY;
+
+   max_msg_size = mongoc_cluster_get_max_msg_size (
+      &file->gridfs->client->cluster);
+
+   /* with room for the command and the documents' own fields */
+   if (file->chunk_batch &&
+       (int64_t)file->chunk_batch_size + len + 1024 > max_msg_size &&
+       !_mongoc_gridfs_file_send_chunk_batch (file)) {
+      RETURN (false);
+   }
+
+   if (!file->chunk_batch) {
+      file->chunk_batch = mongoc_collection_create_bulk_operation (
+         file->gridfs->chunks, true, NULL);
+   }
+
+   /* build the chunk straight into the insert command's documents, so its
+    * data is copied once, from @data */
+   command = _mongoc_bulk_operation_insert_command (file->chunk_batch);
+   batch_len = command->documents->len;
+   bson_oid_init (&oid, NULL);
+
+   _mongoc_write_command_insert_append_begin (command, &chunk);
+   BSON_APPEND_OID (&chunk, "_id", &oid);
+   BSON_APPEND_VALUE (&chunk, "files_id", &file->files_id);
+   BSON_APPEND_INT32 (&chunk, "n", file->n);
+   BSON_APPEND_BINARY (&chunk, "data", BSON_SUBTYPE_BINARY, data, len);
+   _mongoc_write_command_insert_append_end (command, &chunk);
+
+   file->chunk_batch_size += command->documents->len - batch_len;
+   file->first_new_n = file->n + 1;
+
+   RETURN (true);
+}
+
+
+/**
+ * _mongoc_gridfs_file_compress:
+ *
+ *    Compress the @len bytes at @data with the file's compressor.
+ *
+ * Side Effects:
+ *
+ *    On success, @data and @len describe the compressed bytes, which stay
+ *    in file->compress_buf until the next chunk is compressed.
+ *    file->error is set on error.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_compress (mongoc_gridfs_file_t  *file,
+                              const uint8_t        **data,
+                              uint32_t              *len)
+{
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   uLongf compressed_len;
+
+   if (file->compressor == MONGOC_GRIDFS_COMPRESSOR_ZLIB) {
+      compressed_len = compressBound ((uLong)file->chunk_size);
+
+      if (!file->compress_buf) {
+         file->compress_buf = (uint8_t *)bson_malloc (compressed_len);
+      }
+
+      if (compress2 (file->compress_buf, &compressed_len, *data, (uLong)*len,
+                     (int)file->compression_level) != Z_OK) {
+         bson_set_error (&file->error,
+                         MONGOC_ERROR_GRIDFS,
+                         MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                         "Failed to compress chunk number %" PRId32,
+                         file->n);
+         return false;
+      }
+
+      *data = file->compress_buf;
+      *len = (uint32_t)compressed_len;
+
+      return true;
+   }
+#endif
+
+   bson_set_error (&file->error,
+                   MONGOC_ERROR_GRIDFS,
+                   MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                   "The file's chunks use an unsupported compressor");
+
+   return false;
+}
+
+
+/**
+ * _mongoc_gridfs_file_decompress:
+ *
+ *    Decompress the @len bytes at @data, read from chunk number file->n.
+ *    A chunk never holds more than chunk_size bytes once decompressed.
+ *
+ * Side Effects:
+ *
+ *    On success, @data and @len describe the decompressed bytes, which
+ *    stay in file->decompress_buf until the next chunk is decompressed.
+ *    file->error is set on error.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_decompress (mongoc_gridfs_file_t  *file,
+                                const uint8_t        **data,
+                                uint32_t              *len)
+{
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   uLongf decompressed_len;
+
+   if (file->compressor == MONGOC_GRIDFS_COMPRESSOR_ZLIB) {
+      decompressed_len = (uLongf)file->chunk_size;
+
+      if (!file->decompress_buf) {
+         file->decompress_buf = (uint8_t *)bson_malloc (
+            (size_t)file->chunk_size);
+      }
+
+      if (uncompress (file->decompress_buf, &decompressed_len, *data,
+                      (uLong)*len) != Z_OK) {
+         bson_set_error (&file->error,
+                         MONGOC_ERROR_GRIDFS,
+                         MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                         "Corrupt compressed chunk number %" PRId32,
+                         file->n);
+         return false;
+      }
+
+      *data = file->decompress_buf;
+      *len = (uint32_t)decompressed_len;
+
+      return true;
+   }
+#endif
+
+   bson_set_error (&file->error,
+                   MONGOC_ERROR_GRIDFS,
+                   MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                   "The file's chunks use an unsupported compressor");
+
+   return false;
+}
+
+
+/**
+ * _mongoc_gridfs_file_write_chunk:
+ *
+ *    Store @len bytes at @data as chunk number file->n. @data is copied
+ *    straight into the command, it may be the page's buffer or the caller's.
+ *    A chunk past the stored end of the file is batched with the chunks
+ *    after it, an existing chunk is replaced with an upsert. If the file
+ *    compresses its chunks, the compressed bytes are stored instead.
+ *
+ * Side Effects:
+ *
+ *    Chunks read ahead are discarded. file->error is set on error.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_write_chunk (mongoc_gridfs_file_t *file,
+                                 const uint8_t        *data,
+                                 uint32_t              len)
 {
    bson_t *selector, *update;
    bool r;
-   const uint8_t *buf;
-   uint32_t len;
 
    ENTRY;
-   BSON_ASSERT (file);
-   BSON_ASSERT (file->page);
 
-   buf = _mongoc_gridfs_file_page_get_data (file->page);
-   len = _mongoc_gridfs_file_page_get_len (file->page);
+   if (file->chunk_cache) {
+      _mongoc_gridfs_chunk_cache_remove (file->chunk_cache, file->n);
+   }
+
+   if (file->compressor != MONGOC_GRIDFS_COMPRESSOR_NONE &&
+       !_mongoc_gridfs_file_compress (file, &data, &len)) {
+      RETURN (false);
+   }
+
+   if (file->n >= file->first_new_n &&
+       !(file->transfer && file->transfer->parallel)) {
+      /* nothing to replace: append to the batch of new chunks */
+      r = _mongoc_gridfs_file_batch_chunk (file, data, len);
+
+      if (r && file->transfer) {
+         _mongoc_gridfs_transfer_drop_fetches (file->transfer);
+      }
+
+      RETURN (r);
+   }
+
+   /* inserts of earlier chunks go first */
+   if (!_mongoc_gridfs_file_send_chunk_batch (file)) {
+      RETURN (false);
+   }
+
+   if (file->transfer && file->transfer->parallel) {
+      /* an earlier upload of this chunk may still be in flight, and must
+       * not land after this one */
+      if (file->n < file->first_new_n &&
+          !_mongoc_gridfs_transfer_drain (file->transfer)) {
+         RETURN (false);
+      }
+
+      file->first_new_n = BSON_MAX (file->first_new_n, file->n + 1);
+
+      /* the files document is written once, when the file is saved */
+      RETURN (_mongoc_gridfs_transfer_upload (file->transfer, file->n,
+                                              data, len));
+   }
+
+   file->first_new_n = BSON_MAX (file->first_new_n, file->n + 1);
 
    selector = bson_new ();
 
@@ -647,7 +1251,7 @@ _mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
 
    bson_append_value (update, "files_id", -1, &file->files_id);
    bson_append_int32 (update, "n", -1, file->n);
-   bson_append_binary (update, "data", -1, BSON_SUBTYPE_BINARY, buf, len);
+   bson_append_binary (update, "data", -1, BSON_SUBTYPE_BINARY, data, len);
 
    r = mongoc_collection_update (file->gridfs->chunks, MONGOC_UPDATE_UPSERT,
                                  selector, update, NULL, &file->error);
@@ -655,9 +1259,109 @@ _mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
    bson_destroy (selector);
    bson_destroy (update);
 
-   if (r) {
+   if (r && file->transfer) {
+      /* chunks read ahead may predate this write */
+      _mongoc_gridfs_transfer_drop_fetches (file->transfer);
+   }
+
+   RETURN (r);
+}
+
+
+/**
+ * _mongoc_gridfs_file_flush_page:
+ *
+ *    Unconditionally flushes the file's current page to the database.
+ *    The page to flush is determined by page->n.
+ *
+ * Side Effects:
+ *
+ *    On success, file->page is properly destroyed and set to NULL.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
+{
+   bool parallel;
+   bool r;
+
+   ENTRY;
+   BSON_ASSERT (file);
+   BSON_ASSERT (file->page);
+
+   parallel = file->transfer && file->transfer->parallel;
+
+   r = _mongoc_gridfs_file_write_chunk (
+      file,
+      _mongoc_gridfs_file_page_get_data (file->page),
+      _mongoc_gridfs_file_page_get_len (file->page));
+
+   /* a parallel upload owns a copy of the page once it is sent */
+   if (r || parallel) {
       _mongoc_gridfs_file_page_destroy (file->page);
       file->page = NULL;
+   }
+
+   /* a batched chunk waits for the save that ends the upload */
+   if (r && !parallel && !file->chunk_batch) {
+      r = mongoc_gridfs_file_save (file);
+   }
+
+   RETURN (r);
+}
+
+
+/**
+ * _mongoc_gridfs_file_write_whole_chunk:
+ *
+ *    Overwrite the whole chunk at file->pos, which is on a chunk boundary,
+ *    with chunk_size bytes of the caller's memory at @data. The bytes go
+ *    into the chunk command directly instead of through a page.
+ *
+ * Side Effects:
+ *
+ *    A dirty page for an earlier chunk is flushed first; the page for this
+ *    chunk is discarded. file->pos and file->length move past the chunk.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_write_whole_chunk (mongoc_gridfs_file_t *file,
+                                       const uint8_t        *data)
+{
+   bool r;
+
+   ENTRY;
+
+   BSON_ASSERT (!(file->pos % file->chunk_size));
+
+   if (file->page) {
+      if (file->n != (int32_t)(file->pos / file->chunk_size) &&
+          _mongoc_gridfs_file_page_is_dirty (file->page)) {
+         /* the previous write filled its page exactly */
+         if (!_mongoc_gridfs_file_flush_page (file)) {
+            RETURN (false);
+         }
+      } else {
+         _mongoc_gridfs_file_page_destroy (file->page);
+         file->page = NULL;
+      }
+   }
+
+   file->n = (int32_t)(file->pos / file->chunk_size);
+   file->pos += file->chunk_size;
+   file->length = BSON_MAX (file->length, (int64_t)file->pos);
+
+   r = _mongoc_gridfs_file_write_chunk (file, data,
+                                        (uint32_t)file->chunk_size);
+
+   if (r && !(file->transfer && file->transfer->parallel) &&
+       !file->chunk_batch) {
       r = mongoc_gridfs_file_save (file);
    }
 
@@ -722,9 +1426,13 @@ _mongoc_gridfs_file_keep_cursor (mongoc_gridfs_file_t *file)
  *    of the file position being far past the end-of-file.
  *
  *    file->n is set based on file->pos. file->error is set on error.
+ *
+ *    If @last_n is at least file->n, a new query asks for exactly the
+ *    chunks file->n to @last_n, the span a read after a seek needs.
  */
 static bool
-_mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file)
+_mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file,
+                                  int32_t               last_n)
 {
    bson_t *query, *fields, child, child2;
    const bson_t *chunk;
@@ -751,58 +1459,92 @@ _mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file)
    if ((int64_t)file->pos >= file->length && !(file->pos % file->chunk_size)) {
       data = (uint8_t *)"";
       len = 0;
+   } else if (file->chunk_cache &&
+              _mongoc_gridfs_chunk_cache_get (file->chunk_cache, file->n,
+                                              &data, &len)) {
+      /* read recently, and not written since */
    } else {
-      /* if we have a cursor, but the cursor doesn't have the chunk we're going
-       * to need, destroy it (we'll grab a new one immediately there after) */
-      if (file->cursor && !_mongoc_gridfs_file_keep_cursor (file)) {
-         mongoc_cursor_destroy (file->cursor);
-         file->cursor = NULL;
+      /* the chunk may still be in the batch of new chunks */
+      if (!_mongoc_gridfs_file_send_chunk_batch (file)) {
+         RETURN (0);
       }
 
-      if (!file->cursor) {
-         query = bson_new ();
-
-         bson_append_document_begin(query, "$query", -1, &child);
-            bson_append_value (&child, "files_id", -1, &file->files_id);
-
-            bson_append_document_begin (&child, "n", -1, &child2);
-               bson_append_int32 (&child2, "$gte", -1, file->n);
-            bson_append_document_end (&child, &child2);
-         bson_append_document_end(query, &child);
-
-         bson_append_document_begin(query, "$orderby", -1, &child);
-            bson_append_int32 (&child, "n", -1, 1);
-         bson_append_document_end(query, &child);
+      if (file->transfer) {
+         /* read what this file's own pending uploads wrote */
+         if (!_mongoc_gridfs_transfer_drain (file->transfer) ||
+             !_mongoc_gridfs_transfer_fetch (file->transfer, file->n,
+                                             last_n, &chunk)) {
+            RETURN (0);
+         }
+      } else {
+         /* if we have a cursor, but the cursor doesn't have the chunk we're
+          * going to need, destroy it (we'll grab a new one immediately there
+          * after) */
+         if (file->cursor && !_mongoc_gridfs_file_keep_cursor (file)) {
+            mongoc_cursor_destroy (file->cursor);
+            file->cursor = NULL;
+         }
 
-         fields = bson_new ();
-         bson_append_int32 (fields, "n", -1, 1);
-         bson_append_int32 (fields, "data", -1, 1);
-         bson_append_int32 (fields, "_id", -1, 0);
+         if (!file->cursor) {
+            query = bson_new ();
+
+            bson_append_document_begin(query, "$query", -1, &child);
+               bson_append_value (&child, "files_id", -1, &file->files_id);
+
+               bson_append_document_begin (&child, "n", -1, &child2);
+                  bson_append_int32 (&child2, "$gte", -1, file->n);
+                  if (last_n >= file->n) {
+                     bson_append_int32 (&child2, "$lte", -1, last_n);
+                  }
+               bson_append_document_end (&child, &child2);
+            bson_append_document_end(query, &child);
+
+            bson_append_document_begin(query, "$orderby", -1, &child);
+               bson_append_int32 (&child, "n", -1, 1);
+            bson_append_document_end(query, &child);
+
+            fields = bson_new ();
+            bson_append_int32 (fields, "n", -1, 1);
+            bson_append_int32 (fields, "data", -1, 1);
+            bson_append_int32 (fields, "_id", -1, 0);
+
+            if (last_n >= file->n) {
+               /* find the span in one batch */
+               file->cursor = mongoc_collection_find (
+                  file->gridfs->chunks, MONGOC_QUERY_NONE, 0,
+                  (uint32_t)(last_n - file->n + 1), 0, query, fields, NULL);
+
+               file->cursor_range[1] = (uint32_t)last_n;
+            } else {
+               /* find all chunks greater than or equal to our current file
+                * pos */
+               file->cursor = mongoc_collection_find (file->gridfs->chunks,
+                                                      MONGOC_QUERY_NONE, 0, 0,
+                                                      0, query, fields, NULL);
+
+               file->cursor_range[1] =
+                  (uint32_t)(file->length / file->chunk_size);
+            }
 
-         /* find all chunks greater than or equal to our current file pos */
-         file->cursor = mongoc_collection_find (file->gridfs->chunks,
-                                                MONGOC_QUERY_NONE, 0, 0, 0, query,
-                                                fields, NULL);
+            file->cursor_range[0] = file->n;
 
-         file->cursor_range[0] = file->n;
-         file->cursor_range[1] = (uint32_t)(file->length / file->chunk_size);
+            bson_destroy (query);
+            bson_destroy (fields);
 
-         bson_destroy (query);
-         bson_destroy (fields);
+            BSON_ASSERT (file->cursor);
+         }
 
-         BSON_ASSERT (file->cursor);
-      }
+         /* we might have had a cursor before, then seeked ahead past a chunk.
+          * iterate until we're on the right chunk */
+         while (file->cursor_range[0] <= file->n) {
+            if (!mongoc_cursor_next (file->cursor, &chunk)) {
+               /* copy cursor error, if any. might just lack a matching chunk. */
+               mongoc_cursor_error (file->cursor, &file->error);
+               RETURN (0);
+            }
 
-      /* we might have had a cursor before, then seeked ahead past a chunk.
-       * iterate until we're on the right chunk */
-      while (file->cursor_range[0] <= file->n) {
-         if (!mongoc_cursor_next (file->cursor, &chunk)) {
-            /* copy cursor error, if any. might just lack a matching chunk. */
-            mongoc_cursor_error (file->cursor, &file->error);
-            RETURN (0);
+            file->cursor_range[0]++;
          }
-
-         file->cursor_range[0]++;
       }
 
       bson_iter_init (&iter, chunk);
@@ -831,6 +1573,16 @@ _mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file)
       if (file->n != file->pos / file->chunk_size) {
          return 0;
       }
+
+      if (file->compressor != MONGOC_GRIDFS_COMPRESSOR_NONE &&
+          !_mongoc_gridfs_file_decompress (file, &data, &len)) {
+         RETURN (0);
+      }
+
+      if (file->chunk_cache) {
+         _mongoc_gridfs_chunk_cache_put (file->chunk_cache, file->n,
+                                         data, len);
+      }
    }
 
    file->page = _mongoc_gridfs_file_page_new (data, len, file->chunk_size);
@@ -920,6 +1672,10 @@ mongoc_gridfs_file_seek (mongoc_gridfs_file_t *file,
       _mongoc_gridfs_file_page_seek (file->page, offset % file->chunk_size);
    }
 
+   if ((uint64_t)offset != file->pos) {
+      file->seeked = true;
+   }
+
    file->pos = offset;
    file->n = file->pos / file->chunk_size;
 
@@ -994,6 +1750,19 @@ mongoc_gridfs_file_remove (mongoc_gridfs_file_t *file,
 
    BSON_ASSERT (file);
 
+   /* an upload still in flight would recreate its chunk after the delete;
+    * its error, if any, doesn't matter once the file is gone */
+   if (file->transfer) {
+      _mongoc_gridfs_transfer_drain (file->transfer);
+   }
+
+   /* chunks still waiting to be inserted never reach the server */
+   if (file->chunk_batch) {
+      mongoc_bulk_operation_destroy (file->chunk_batch);
+      file->chunk_batch = NULL;
+      file->chunk_batch_size = 0;
+   }
+
    BSON_APPEND_VALUE (&sel, "_id", &file->files_id);
 
    if (!mongoc_collection_remove (file->gridfs->files,
@@ -105,6 +105,25 @@ mongoc_gridfs_file_set_id (mongoc_gridfs_file_t *file,
 bool
 mongoc_gridfs_file_save (mongoc_gridfs_file_t *file);
 
+void
+mongoc_gridfs_file_set_parallel (mongoc_gridfs_file_t *file,
+                                 uint32_t              max_connections,
+                                 uint32_t              max_chunks_in_flight);
+
+void
+mongoc_gridfs_file_set_read_ahead (mongoc_gridfs_file_t *file,
+                                   uint32_t              n_chunks);
+
+void
+mongoc_gridfs_file_set_chunk_cache (mongoc_gridfs_file_t *file,
+                                    uint32_t              n_chunks);
+
+bool
+mongoc_gridfs_file_set_compression (mongoc_gridfs_file_t *file,
+                                    const char           *compressor,
+                                    int32_t               level,
+                                    bson_error_t         *error);
+
 void
 mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file);
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_GRIDFS_TRANSFER_PRIVATE_H
+#define MONGOC_GRIDFS_TRANSFER_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client-async.h"
+#include "mongoc-gridfs-file.h"
+#include "mongoc-socket.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_gridfs_fetch_t    mongoc_gridfs_fetch_t;
+typedef struct _mongoc_gridfs_transfer_t mongoc_gridfs_transfer_t;
+
+
+/* a span of chunks requested from the server with one find */
+struct _mongoc_gridfs_fetch_t
+{
+   mongoc_gridfs_transfer_t *transfer;
+   int32_t                   first;
+   int32_t                   last;
+   bool                      done;
+   /* dropped from the window while in flight, freed by its callback */
+   bool                      orphaned;
+   bool                      ok;
+   /* the reply's batch, an array of chunks */
+   bson_t                    chunks;
+   bson_error_t              error;
+   mongoc_gridfs_fetch_t    *next;
+};
+
+
+struct _mongoc_gridfs_transfer_t
+{
+   mongoc_gridfs_file_t     *file;
+   mongoc_client_async_t    *async;
+   /* chunks are uploaded here, not by the gridfs client */
+   bool                      parallel;
+   uint32_t                  max_in_flight;
+   uint32_t                  read_ahead;
+   uint32_t                  n_uploads;
+   bool                      upload_failed;
+   bson_error_t              upload_error;
+   /* spans of consecutive chunks, in order */
+   mongoc_gridfs_fetch_t    *fetches;
+   /* the chunk last fetched, to detect sequential reads */
+   int32_t                   last_n;
+   /* the chunk the file's page reads from, inside a span */
+   bson_t                    chunk;
+   mongoc_socket_poll_t     *sds;
+   size_t                    n_sds;
+};
+
+
+mongoc_gridfs_transfer_t *_mongoc_gridfs_transfer_new            (mongoc_gridfs_file_t     *file);
+void                      _mongoc_gridfs_transfer_destroy        (mongoc_gridfs_transfer_t *transfer);
+void                      _mongoc_gridfs_transfer_set_parallel   (mongoc_gridfs_transfer_t *transfer,
+                                                                  uint32_t                  max_connections,
+                                                                  uint32_t                  max_in_flight);
+void                      _mongoc_gridfs_transfer_set_read_ahead (mongoc_gridfs_transfer_t *transfer,
+                                                                  uint32_t                  n_chunks);
+bool                      _mongoc_gridfs_transfer_upload         (mongoc_gridfs_transfer_t *transfer,
+                                                                  int32_t                   n,
+                                                                  const uint8_t            *data,
+                                                                  uint32_t                  len);
+bool                      _mongoc_gridfs_transfer_drain          (mongoc_gridfs_transfer_t *transfer);
+void                      _mongoc_gridfs_transfer_drop_fetches   (mongoc_gridfs_transfer_t *transfer);
+bool                      _mongoc_gridfs_transfer_fetch          (mongoc_gridfs_transfer_t *transfer,
+                                                                  int32_t                   n,
+                                                                  int32_t                   last_n,
+                                                                  const bson_t            **chunk);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_GRIDFS_TRANSFER_PRIVATE_H */
@@ -0,0 +1,613 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-collection-private.h"
+#include "mongoc-error.h"
+#include "mongoc-gridfs-private.h"
+#include "mongoc-gridfs-file-private.h"
+#include "mongoc-gridfs-transfer-private.h"
+#include "mongoc-read-concern-private.h"
+#include "mongoc-trace.h"
+#include "mongoc-write-concern-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "gridfs_transfer"
+
+
+/*
+ * A parallel transfer moves a GridFS file's chunks on an async client's
+ * connections instead of one round trip at a time on the gridfs client.
+ * Flushed chunks are sent as upsert commands without waiting for earlier
+ * ones, and reads fetch the chunks after the one they need ahead of time.
+ * At most max_in_flight uploads, and max_in_flight fetches, are pending at
+ * once; the async client spreads them over its connections.
+ *
+ * Read-ahead uses the same machinery on one connection. Once a reader
+ * asks for chunks in order, each find fetches a span of read_ahead chunks,
+ * and the next span is requested while the reader is still in this one,
+ * so it never waits at a chunk boundary unless it outruns the network.
+ *
+ * The transfer only ever waits when the window is full, a chunk it needs
+ * hasn't arrived, or the file is saved: mongoc_gridfs_file_save drains
+ * the uploads before it writes the files document, so the document never
+ * describes chunks that aren't stored.
+ */
+
+
+mongoc_gridfs_transfer_t *
+_mongoc_gridfs_transfer_new (mongoc_gridfs_file_t *file)
+{
+   mongoc_gridfs_transfer_t *transfer;
+
+   BSON_ASSERT (file);
+
+   transfer = (mongoc_gridfs_transfer_t *)bson_malloc0 (sizeof *transfer);
+   transfer->file = file;
+   transfer->async = mongoc_client_async_new (file->gridfs->client);
+   mongoc_client_async_set_max_connections (transfer->async, 1);
+   transfer->max_in_flight = 1;
+   transfer->last_n = -1;
+
+   return transfer;
+}
+
+
+void
+_mongoc_gridfs_transfer_set_parallel (mongoc_gridfs_transfer_t *transfer,
+                                      uint32_t                  max_connections,
+                                      uint32_t                  max_in_flight)
+{
+   BSON_ASSERT (transfer);
+
+   transfer->parallel = max_connections > 0;
+   transfer->max_in_flight = BSON_MAX (max_in_flight, 1);
+   mongoc_client_async_set_max_connections (transfer->async, max_connections);
+}
+
+
+void
+_mongoc_gridfs_transfer_set_read_ahead (mongoc_gridfs_transfer_t *transfer,
+                                        uint32_t                  n_chunks)
+{
+   BSON_ASSERT (transfer);
+
+   transfer->read_ahead = n_chunks;
+}
+
+
+static void
+_mongoc_gridfs_fetch_destroy (mongoc_gridfs_fetch_t *fetch)
+{
+   bson_destroy (&fetch->chunks);
+   bson_free (fetch);
+}
+
+
+/* forget every fetch; those in flight are freed by their callbacks */
+void
+_mongoc_gridfs_transfer_drop_fetches (mongoc_gridfs_transfer_t *transfer)
+{
+   mongoc_gridfs_fetch_t *fetch;
+
+   while ((fetch = transfer->fetches)) {
+      transfer->fetches = fetch->next;
+
+      if (fetch->done) {
+         _mongoc_gridfs_fetch_destroy (fetch);
+      } else {
+         fetch->orphaned = true;
+      }
+   }
+}
+
+
+void
+_mongoc_gridfs_transfer_destroy (mongoc_gridfs_transfer_t *transfer)
+{
+   if (!transfer) {
+      return;
+   }
+
+   _mongoc_gridfs_transfer_drop_fetches (transfer);
+
+   /* calls the callbacks of commands still pending, with errors */
+   mongoc_client_async_destroy (transfer->async);
+   bson_free (transfer->sds);
+   bson_free (transfer);
+}
+
+
+/* one round of polling the async client's sockets, up to @timeout_msec */
+static void
+_mongoc_gridfs_transfer_wait (mongoc_gridfs_transfer_t *transfer,
+                              int32_t                   timeout_msec)
+{
+   int32_t timeout;
+   size_t n;
+
+   for (;;) {
+      n = mongoc_client_async_get_sockets (transfer->async, transfer->sds,
+                                           transfer->n_sds);
+      if (n <= transfer->n_sds) {
+         break;
+      }
+
+      transfer->sds = (mongoc_socket_poll_t *)bson_realloc (
+         transfer->sds, n * sizeof *transfer->sds);
+      transfer->n_sds = n;
+   }
+
+   timeout = mongoc_client_async_get_timeout (transfer->async);
+   if (timeout_msec >= 0 && (timeout < 0 || timeout_msec < timeout)) {
+      timeout = timeout_msec;
+   }
+
+   if (n) {
+      mongoc_socket_poll (transfer->sds, n, timeout);
+   }
+
+   mongoc_client_async_step (transfer->async, transfer->sds, n);
+}
+
+
+static void
+_mongoc_gridfs_transfer_upload_cb (const bson_t       *reply,
+                                   const bson_error_t *error,
+                                   void               *context)
+{
+   mongoc_gridfs_transfer_t *transfer = (mongoc_gridfs_transfer_t *)context;
+   bson_error_t write_error;
+   bson_iter_t iter;
+   bson_iter_t child;
+
+   transfer->n_uploads--;
+
+   if (transfer->upload_failed) {
+      return;
+   }
+
+   if (error) {
+      memcpy (&write_error, error, sizeof write_error);
+   } else if (bson_iter_init_find (&iter, reply, "writeErrors") &&
+              bson_iter_recurse (&iter, &child) &&
+              bson_iter_next (&child) &&
+              BSON_ITER_HOLDS_DOCUMENT (&child) &&
+              bson_iter_recurse (&child, &iter)) {
+      bson_set_error (&write_error, MONGOC_ERROR_COMMAND, 0,
+                      "Failed to write a chunk");
+      while (bson_iter_next (&iter)) {
+         if (!strcmp (bson_iter_key (&iter), "code")) {
+            write_error.code = (uint32_t) bson_iter_as_int64 (&iter);
+         } else if (!strcmp (bson_iter_key (&iter), "errmsg") &&
+                    BSON_ITER_HOLDS_UTF8 (&iter)) {
+            bson_strncpy (write_error.message, bson_iter_utf8 (&iter, NULL),
+                          sizeof write_error.message);
+         }
+      }
+   } else if (bson_iter_init_find (&iter, reply, "writeConcernError")) {
+      bson_set_error (&write_error, MONGOC_ERROR_WRITE_CONCERN,
+                      MONGOC_ERROR_WRITE_CONCERN_ERROR,
+                      "Write concern error while writing a chunk");
+   } else {
+      return;
+   }
+
+   transfer->upload_failed = true;
+   memcpy (&transfer->upload_error, &write_error, sizeof write_error);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_transfer_upload --
+ *
+ *       Send chunk @n of the file, once fewer than max_in_flight uploads
+ *       are pending. Like a serial flush, the chunk is upserted, so
+ *       rewriting a chunk replaces it. Fetched chunks are dropped, since
+ *       they may be stale now.
+ *
+ * Returns:
+ *       false and sets the file's error if an earlier upload failed or
+ *       this one couldn't be sent.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_gridfs_transfer_upload (mongoc_gridfs_transfer_t *transfer,
+                                int32_t                   n,
+                                const uint8_t            *data,
+                                uint32_t                  len)
+{
+   mongoc_gridfs_file_t *file;
+   mongoc_collection_t *chunks;
+   mongoc_write_concern_t *write_concern;
+   bson_t command = BSON_INITIALIZER;
+   bson_t updates;
+   bson_t update;
+   bson_t child;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (transfer);
+
+   file = transfer->file;
+   chunks = file->gridfs->chunks;
+
+   _mongoc_gridfs_transfer_drop_fetches (transfer);
+
+   while (transfer->n_uploads >= transfer->max_in_flight &&
+          !transfer->upload_failed) {
+      _mongoc_gridfs_transfer_wait (transfer, -1);
+   }
+
+   if (transfer->upload_failed) {
+      memcpy (&file->error, &transfer->upload_error, sizeof file->error);
+      GOTO (done);
+   }
+
+   BSON_APPEND_UTF8 (&command, "update", chunks->collection);
+   BSON_APPEND_ARRAY_BEGIN (&command, "updates", &updates);
+   BSON_APPEND_DOCUMENT_BEGIN (&updates, "0", &update);
+   BSON_APPEND_DOCUMENT_BEGIN (&update, "q", &child);
+   BSON_APPEND_VALUE (&child, "files_id", &file->files_id);
+   BSON_APPEND_INT32 (&child, "n", n);
+   bson_append_document_end (&update, &child);
+   BSON_APPEND_DOCUMENT_BEGIN (&update, "u", &child);
+   BSON_APPEND_VALUE (&child, "files_id", &file->files_id);
+   BSON_APPEND_INT32 (&child, "n", n);
+   BSON_APPEND_BINARY (&child, "data", BSON_SUBTYPE_BINARY, data, len);
+   bson_append_document_end (&update, &child);
+   BSON_APPEND_BOOL (&update, "upsert", true);
+   bson_append_document_end (&updates, &update);
+   bson_append_array_end (&command, &updates);
+
+   write_concern = chunks->write_concern;
+   if (!_mongoc_write_concern_is_default (write_concern)) {
+      BSON_APPEND_DOCUMENT (&command, "writeConcern",
+                            _mongoc_write_concern_get_bson (write_concern));
+   }
+
+   if (!mongoc_client_async_command (transfer->async, chunks->db, &command,
+                                     NULL, 0,
+                                     _mongoc_gridfs_transfer_upload_cb,
+                                     transfer, &file->error)) {
+      GOTO (done);
+   }
+
+   transfer->n_uploads++;
+
+   /* start sending without waiting */
+   _mongoc_gridfs_transfer_wait (transfer, 0);
+
+   ret = true;
+
+done:
+   bson_destroy (&command);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_transfer_drain --
+ *
+ *       Wait for every pending upload.
+ *
+ * Returns:
+ *       false and sets the file's error if any upload failed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_gridfs_transfer_drain (mongoc_gridfs_transfer_t *transfer)
+{
+   ENTRY;
+
+   BSON_ASSERT (transfer);
+
+   while (transfer->n_uploads) {
+      _mongoc_gridfs_transfer_wait (transfer, -1);
+   }
+
+   if (transfer->upload_failed) {
+      memcpy (&transfer->file->error, &transfer->upload_error,
+              sizeof transfer->file->error);
+      RETURN (false);
+   }
+
+   RETURN (true);
+}
+
+
+static void
+_mongoc_gridfs_transfer_fetch_cb (const bson_t       *reply,
+                                  const bson_error_t *error,
+                                  void               *context)
+{
+   mongoc_gridfs_fetch_t *fetch = (mongoc_gridfs_fetch_t *)context;
+   bson_iter_t iter;
+   bson_iter_t batch;
+   const uint8_t *data;
+   uint32_t len;
+   bson_t chunks;
+
+   if (fetch->orphaned) {
+      _mongoc_gridfs_fetch_destroy (fetch);
+      return;
+   }
+
+   fetch->done = true;
+
+   if (error) {
+      memcpy (&fetch->error, error, sizeof fetch->error);
+      return;
+   }
+
+   if (bson_iter_init (&iter, reply) &&
+       bson_iter_find_descendant (&iter, "cursor.firstBatch", &batch) &&
+       BSON_ITER_HOLDS_ARRAY (&batch)) {
+      bson_iter_array (&batch, &len, &data);
+
+      /* the reply is only valid during this callback */
+      if (bson_init_static (&chunks, data, len)) {
+         bson_destroy (&fetch->chunks);
+         bson_copy_to (&chunks, &fetch->chunks);
+         fetch->ok = true;
+         return;
+      }
+   }
+
+   bson_set_error (&fetch->error, MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Invalid reply to find chunks %" PRId32 " to %" PRId32,
+                   fetch->first, fetch->last);
+}
+
+
+static bool
+_mongoc_gridfs_transfer_send_fetch (mongoc_gridfs_transfer_t *transfer,
+                                    mongoc_gridfs_fetch_t    *fetch)
+{
+   mongoc_gridfs_file_t *file;
+   mongoc_collection_t *chunks;
+   const bson_t *read_concern;
+   bson_t command = BSON_INITIALIZER;
+   bson_t child;
+   bson_t range;
+   int32_t count;
+   bool ret;
+
+   file = transfer->file;
+   chunks = file->gridfs->chunks;
+   count = fetch->last - fetch->first + 1;
+
+   BSON_APPEND_UTF8 (&command, "find", chunks->collection);
+   BSON_APPEND_DOCUMENT_BEGIN (&command, "filter", &child);
+   BSON_APPEND_VALUE (&child, "files_id", &file->files_id);
+   if (count == 1) {
+      BSON_APPEND_INT32 (&child, "n", fetch->first);
+   } else {
+      BSON_APPEND_DOCUMENT_BEGIN (&child, "n", &range);
+      BSON_APPEND_INT32 (&range, "$gte", fetch->first);
+      BSON_APPEND_INT32 (&range, "$lte", fetch->last);
+      bson_append_document_end (&child, &range);
+   }
+   bson_append_document_end (&command, &child);
+   BSON_APPEND_DOCUMENT_BEGIN (&command, "sort", &child);
+   BSON_APPEND_INT32 (&child, "n", 1);
+   bson_append_document_end (&command, &child);
+   BSON_APPEND_DOCUMENT_BEGIN (&command, "projection", &child);
+   BSON_APPEND_INT32 (&child, "n", 1);
+   BSON_APPEND_INT32 (&child, "data", 1);
+   BSON_APPEND_INT32 (&child, "_id", 0);
+   bson_append_document_end (&command, &child);
+   BSON_APPEND_INT32 (&command, "batchSize", count);
+   BSON_APPEND_INT32 (&command, "limit", count);
+   BSON_APPEND_BOOL (&command, "singleBatch", true);
+
+   if (chunks->read_concern->level != NULL) {
+      read_concern = _mongoc_read_concern_get_bson (chunks->read_concern);
+      BSON_APPEND_DOCUMENT (&command, "readConcern", read_concern);
+   }
+
+   ret = mongoc_client_async_command (transfer->async, chunks->db, &command,
+                                      chunks->read_prefs, 0,
+                                      _mongoc_gridfs_transfer_fetch_cb,
+                                      fetch, &file->error);
+
+   bson_destroy (&command);
+
+   return ret;
+}
+
+
+/* find chunk @n in a fetched span */
+static bool
+_mongoc_gridfs_fetch_find (mongoc_gridfs_fetch_t *fetch,
+                           int32_t                n,
+                           bson_t                *chunk)
+{
+   bson_iter_t iter;
+   bson_iter_t child;
+   const uint8_t *data;
+   uint32_t len;
+
+   if (!bson_iter_init (&iter, &fetch->chunks)) {
+      return false;
+   }
+
+   while (bson_iter_next (&iter)) {
+      if (BSON_ITER_HOLDS_DOCUMENT (&iter) &&
+          bson_iter_recurse (&iter, &child) &&
+          bson_iter_find (&child, "n") &&
+          BSON_ITER_HOLDS_INT32 (&child) &&
+          bson_iter_int32 (&child) == n) {
+         bson_iter_document (&iter, &len, &data);
+         return bson_init_static (chunk, data, len);
+      }
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_transfer_fetch --
+ *
+ *       Wait for chunk @n of the file, fetching it if it isn't already
+ *       on its way, and fetch chunks after it: in a parallel transfer,
+ *       up to max_in_flight spans, and with read-ahead, the read_ahead
+ *       chunks after @n once reads are sequential. Each span is fetched
+ *       with one find command; a span is read_ahead chunks, or for a
+ *       read that isn't sequential, the chunks @n to @last_n it covers.
+ *
+ *       Fetches that don't continue from @n, as after a seek, are
+ *       dropped.
+ *
+ * Returns:
+ *       true and sets @chunk, valid until the next fetch or upload, or
+ *       false and sets the file's error.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_gridfs_transfer_fetch (mongoc_gridfs_transfer_t *transfer,
+                               int32_t                   n,
+                               int32_t                   last_n,
+                               const bson_t            **chunk)
+{
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_fetch_t *fetch;
+   mongoc_gridfs_fetch_t **link;
+   bool sequential;
+   int32_t file_last;
+   int32_t max_span;
+   int32_t span;
+   int32_t end;
+   int32_t next;
+
+   ENTRY;
+
+   BSON_ASSERT (transfer);
+   BSON_ASSERT (chunk);
+
+   file = transfer->file;
+   sequential = (n == transfer->last_n + 1);
+   transfer->last_n = n;
+
+   /* keep the window only if it continues from @n */
+   while ((fetch = transfer->fetches) && fetch->last < n) {
+      transfer->fetches = fetch->next;
+
+      if (fetch->done) {
+         _mongoc_gridfs_fetch_destroy (fetch);
+      } else {
+         fetch->orphaned = true;
+      }
+   }
+
+   if (transfer->fetches && transfer->fetches->first > n) {
+      _mongoc_gridfs_transfer_drop_fetches (transfer);
+   }
+
+   file_last = file->length ?
+               (int32_t)((file->length - 1) / file->chunk_size) : 0;
+   file_last = BSON_MAX (file_last, n);
+
+   /* a reply's batch holds at most 16MB */
+   max_span = BSON_MAX (
+      (16 * 1024 * 1024 - 16 * 1024) / (file->chunk_size + 64), 1);
+   span = BSON_MIN ((int32_t) BSON_MAX (transfer->read_ahead, 1), max_span);
+
+   if (transfer->parallel) {
+      end = n + (int32_t) transfer->max_in_flight * span - 1;
+   } else if (sequential && transfer->read_ahead) {
+      end = n + (int32_t) transfer->read_ahead;
+   } else {
+      /* a read after a seek wants just the chunks it covers */
+      end = BSON_MAX (n, last_n);
+      span = BSON_MIN (end - n + 1, max_span);
+   }
+
+   end = BSON_MIN (end, file_last);
+
+   link = &transfer->fetches;
+   next = n;
+
+   while (*link) {
+      next = (*link)->last + 1;
+      link = &(*link)->next;
+   }
+
+   for (; next <= end; next = fetch->last + 1) {
+      fetch = (mongoc_gridfs_fetch_t *)bson_malloc0 (sizeof *fetch);
+      fetch->transfer = transfer;
+      fetch->first = next;
+      fetch->last = BSON_MIN (next + span - 1, file_last);
+      bson_init (&fetch->chunks);
+
+      if (!_mongoc_gridfs_transfer_send_fetch (transfer, fetch)) {
+         _mongoc_gridfs_fetch_destroy (fetch);
+
+         if (transfer->fetches) {
+            /* make do with the window we have */
+            break;
+         }
+
+         RETURN (false);
+      }
+
+      *link = fetch;
+      link = &fetch->next;
+   }
+
+   fetch = transfer->fetches;
+
+   while (!fetch->done) {
+      _mongoc_gridfs_transfer_wait (transfer, -1);
+   }
+
+   if (!fetch->ok) {
+      memcpy (&file->error, &fetch->error, sizeof file->error);
+      transfer->fetches = fetch->next;
+      _mongoc_gridfs_fetch_destroy (fetch);
+      RETURN (false);
+   }
+
+   if (!_mongoc_gridfs_fetch_find (fetch, n, &transfer->chunk)) {
+      bson_set_error (&file->error,
+                      MONGOC_ERROR_GRIDFS,
+                      MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                      "missing chunk number %" PRId32, n);
+      RETURN (false);
+   }
+
+   *chunk = &transfer->chunk;
+
+   RETURN (true);
+}
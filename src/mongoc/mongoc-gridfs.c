@@ -31,10 +31,29 @@
 #include "mongoc-gridfs-file-list.h"
 #include "mongoc-gridfs-file-list-private.h"
 #include "mongoc-client.h"
+#include "mongoc-stream-private.h"
+#include "mongoc-stream-file.h"
 #include "mongoc-trace.h"
 
+#ifndef _WIN32
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 #define MONGOC_GRIDFS_STREAM_CHUNK 4096
 
+/* how much of a local file is mapped at once when it is ingested */
+#define MONGOC_GRIDFS_MAP_WINDOW (64 * 1024 * 1024)
+
+
+#ifndef _WIN32
+static bool
+_mongoc_gridfs_file_write_mapped (mongoc_gridfs_file_t *file,
+                                  int                   fd,
+                                  bson_error_t         *error);
+#endif
+
 
 /**
  * _mongoc_gridfs_ensure_index:
@@ -245,6 +264,7 @@ mongoc_gridfs_create_file_from_stream (mongoc_gridfs_t          *gridfs,
    uint8_t buf[MONGOC_GRIDFS_STREAM_CHUNK];
    mongoc_iovec_t iov;
    int timeout;
+   bool mapped = false;
 
    ENTRY;
 
@@ -257,7 +277,24 @@ mongoc_gridfs_create_file_from_stream (mongoc_gridfs_t          *gridfs,
    file = _mongoc_gridfs_file_new (gridfs, opt);
    timeout = gridfs->client->cluster.sockettimeoutms;
 
-   for (;; ) {
+#ifndef _WIN32
+   /* a local file is mapped instead of read into a buffer */
+   if (stream->type == MONGOC_STREAM_FILE) {
+      bson_error_t error = { 0 };
+
+      mapped = _mongoc_gridfs_file_write_mapped (
+         file, mongoc_stream_file_get_fd ((mongoc_stream_file_t *)stream),
+         &error);
+
+      if (!mapped && error.domain) {
+         mongoc_gridfs_file_destroy (file);
+         RETURN (NULL);
+      }
+   }
+#endif
+
+   /* otherwise, or if it can't be mapped, read it */
+   while (!mapped) {
       r = mongoc_stream_read (stream, iov.iov_base, MONGOC_GRIDFS_STREAM_CHUNK,
                               0, timeout);
 
@@ -280,6 +317,99 @@ mongoc_gridfs_create_file_from_stream (mongoc_gridfs_t          *gridfs,
 }
 
 
+#ifndef _WIN32
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_file_write_mapped --
+ *
+ *       Write the rest of the regular file behind @fd to @file by mapping
+ *       it a window at a time, so whole chunks go from the mapping into
+ *       the chunk inserts without a read buffer. Each window is a multiple
+ *       of the chunk size, which keeps every window's chunks aligned.
+ *
+ * Returns:
+ *       true if the whole file was written. false if @fd can't be mapped,
+ *       leaving its offset where the bytes written so far end, so the
+ *       caller can read the rest. false and sets @error if a write
+ *       failed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_gridfs_file_write_mapped (mongoc_gridfs_file_t *file,
+                                  int                   fd,
+                                  bson_error_t         *error)
+{
+   struct stat st;
+   mongoc_iovec_t iov;
+   off_t offset;
+   off_t map_offset;
+   size_t window;
+   size_t map_len;
+   size_t len;
+   long page_size;
+   void *map;
+   ssize_t r;
+
+   ENTRY;
+
+   if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) ||
+       (offset = lseek (fd, 0, SEEK_CUR)) < 0) {
+      RETURN (false);
+   }
+
+   page_size = sysconf (_SC_PAGESIZE);
+   window = MONGOC_GRIDFS_MAP_WINDOW;
+   window = BSON_MAX (window - window % file->chunk_size,
+                      (size_t)file->chunk_size);
+
+   while (offset < st.st_size) {
+      len = (size_t)BSON_MIN ((off_t)window, st.st_size - offset);
+
+      /* a mapping starts on a page boundary */
+      map_offset = offset - offset % page_size;
+      map_len = len + (size_t)(offset - map_offset);
+
+      map = mmap (NULL, map_len, PROT_READ, MAP_PRIVATE, fd, map_offset);
+      if (map == MAP_FAILED) {
+         lseek (fd, offset, SEEK_SET);
+         RETURN (false);
+      }
+
+#ifdef MADV_SEQUENTIAL
+      madvise (map, map_len, MADV_SEQUENTIAL);
+#endif
+
+      iov.iov_base = (char *)map + (offset - map_offset);
+      iov.iov_len = len;
+      r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+
+      munmap (map, map_len);
+
+      if (r != (ssize_t)len) {
+         if (!mongoc_gridfs_file_error (file, error)) {
+            bson_set_error (error,
+                            MONGOC_ERROR_GRIDFS,
+                            MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                            "Failed to write mapped file to GridFS");
+         }
+
+         RETURN (false);
+      }
+
+      offset += len;
+   }
+
+   /* the stream is consumed, as if it had been read */
+   lseek (fd, offset, SEEK_SET);
+
+   RETURN (true);
+}
+#endif
+
+
 /** create an empty gridfs file */
 mongoc_gridfs_file_t *
 mongoc_gridfs_create_file (mongoc_gridfs_t          *gridfs,
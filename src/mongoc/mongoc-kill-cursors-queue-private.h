@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MONGOC_KILL_CURSORS_QUEUE_PRIVATE_H
+#define MONGOC_KILL_CURSORS_QUEUE_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-array-private.h"
+#include "mongoc-thread-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct
+{
+   uint32_t  server_id;
+   int64_t   cursor_id;
+   int64_t   operation_id;
+   char     *db;
+   char     *collection;
+   int64_t   queued_at;
+} mongoc_kill_cursors_entry_t;
+
+
+/* cursor ids waiting to be killed, shared by all clients of a topology. when
+ * neither a delay nor a threshold is set, cursors are killed immediately */
+typedef struct
+{
+   mongoc_mutex_t  mutex;
+   mongoc_array_t  entries;
+   /* entries.len, changed under the mutex but read atomically without it */
+   volatile int32_t n_entries;
+   int64_t         delay_usec;
+   uint32_t        max_cursors;
+} mongoc_kill_cursors_queue_t;
+
+
+void     _mongoc_kill_cursors_queue_init     (mongoc_kill_cursors_queue_t *queue);
+void     _mongoc_kill_cursors_queue_destroy  (mongoc_kill_cursors_queue_t *queue);
+void     _mongoc_kill_cursors_queue_set      (mongoc_kill_cursors_queue_t *queue,
+                                              int32_t                      delay_msec,
+                                              uint32_t                     max_cursors);
+bool     _mongoc_kill_cursors_queue_push     (mongoc_kill_cursors_queue_t *queue,
+                                              uint32_t                     server_id,
+                                              int64_t                      cursor_id,
+                                              int64_t                      operation_id,
+                                              const char                  *db,
+                                              const char                  *collection);
+bool     _mongoc_kill_cursors_queue_is_due   (mongoc_kill_cursors_queue_t *queue,
+                                              uint32_t                     server_id);
+uint32_t _mongoc_kill_cursors_queue_next_due (mongoc_kill_cursors_queue_t *queue,
+                                              uint32_t                     after,
+                                              bool                         force);
+bool     _mongoc_kill_cursors_queue_take     (mongoc_kill_cursors_queue_t *queue,
+                                              uint32_t                     server_id,
+                                              bool                         force,
+                                              mongoc_array_t              *entries);
+void     _mongoc_kill_cursors_entries_clear  (mongoc_array_t              *entries);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_KILL_CURSORS_QUEUE_PRIVATE_H */
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-kill-cursors-queue-private.h"
+#include "mongoc-trace.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "cursor"
+
+
+void
+_mongoc_kill_cursors_queue_init (mongoc_kill_cursors_queue_t *queue)
+{
+   BSON_ASSERT (queue);
+
+   mongoc_mutex_init (&queue->mutex);
+   _mongoc_array_init (&queue->entries, sizeof (mongoc_kill_cursors_entry_t));
+   queue->n_entries = 0;
+   queue->delay_usec = 0;
+   queue->max_cursors = 0;
+}
+
+
+void
+_mongoc_kill_cursors_queue_destroy (mongoc_kill_cursors_queue_t *queue)
+{
+   BSON_ASSERT (queue);
+
+   _mongoc_kill_cursors_entries_clear (&queue->entries);
+   _mongoc_array_destroy (&queue->entries);
+   mongoc_mutex_destroy (&queue->mutex);
+}
+
+
+void
+_mongoc_kill_cursors_queue_set (mongoc_kill_cursors_queue_t *queue,
+                                int32_t                      delay_msec,
+                                uint32_t                     max_cursors)
+{
+   BSON_ASSERT (queue);
+
+   mongoc_mutex_lock (&queue->mutex);
+   queue->delay_usec = delay_msec > 0 ? (int64_t) delay_msec * 1000 : 0;
+   queue->max_cursors = max_cursors;
+   mongoc_mutex_unlock (&queue->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_kill_cursors_queue_push --
+ *
+ *       Queue a cursor to be killed later, if deferred killing is enabled.
+ *
+ * Returns:
+ *       true if the cursor was queued, false if the caller must kill it
+ *       now.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_kill_cursors_queue_push (mongoc_kill_cursors_queue_t *queue,
+                                 uint32_t                     server_id,
+                                 int64_t                      cursor_id,
+                                 int64_t                      operation_id,
+                                 const char                  *db,
+                                 const char                  *collection)
+{
+   mongoc_kill_cursors_entry_t entry;
+   bool ret = false;
+
+   BSON_ASSERT (queue);
+   BSON_ASSERT (db);
+   BSON_ASSERT (collection);
+
+   mongoc_mutex_lock (&queue->mutex);
+
+   if (queue->delay_usec || queue->max_cursors) {
+      entry.server_id = server_id;
+      entry.cursor_id = cursor_id;
+      entry.operation_id = operation_id;
+      entry.db = bson_strdup (db);
+      entry.collection = bson_strdup (collection);
+      entry.queued_at = bson_get_monotonic_time ();
+      _mongoc_array_append_val (&queue->entries, entry);
+      bson_atomic_int_add (&queue->n_entries, 1);
+      ret = true;
+   }
+
+   mongoc_mutex_unlock (&queue->mutex);
+
+   return ret;
+}
+
+
+/* entries are appended in order, so the first one for a server is its
+ * oldest. call with the mutex held */
+static bool
+_mongoc_kill_cursors_queue_due (mongoc_kill_cursors_queue_t *queue,
+                                uint32_t                     server_id,
+                                int64_t                      now)
+{
+   mongoc_kill_cursors_entry_t *entry;
+   uint32_t count = 0;
+   size_t i;
+
+   for (i = 0; i < queue->entries.len; i++) {
+      entry = &_mongoc_array_index (&queue->entries,
+                                    mongoc_kill_cursors_entry_t, i);
+
+      if (entry->server_id != server_id) {
+         continue;
+      }
+
+      if (!count && queue->delay_usec &&
+          now - entry->queued_at >= queue->delay_usec) {
+         return true;
+      }
+
+      if (++count >= queue->max_cursors && queue->max_cursors) {
+         return true;
+      }
+   }
+
+   /* deferred killing was turned off since these were queued */
+   return count && !queue->delay_usec && !queue->max_cursors;
+}
+
+
+bool
+_mongoc_kill_cursors_queue_is_due (mongoc_kill_cursors_queue_t *queue,
+                                   uint32_t                     server_id)
+{
+   bool ret;
+
+   BSON_ASSERT (queue);
+
+   /* checked on every stream fetch: skip the mutex in the common case. a
+    * cursor pushed just after this read waits for the next check */
+   if (!bson_atomic_int_add (&queue->n_entries, 0)) {
+      return false;
+   }
+
+   mongoc_mutex_lock (&queue->mutex);
+   ret = queue->entries.len &&
+         _mongoc_kill_cursors_queue_due (queue, server_id,
+                                         bson_get_monotonic_time ());
+   mongoc_mutex_unlock (&queue->mutex);
+
+   return ret;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_kill_cursors_queue_next_due --
+ *
+ *       Find the server with the lowest id above @after whose queued
+ *       cursors have waited long enough, or have reached the threshold.
+ *       If @force, any server with queued cursors is returned. Start with
+ *       @after 0 and pass each result back in to visit every such server
+ *       once, even those whose cursors stay queued.
+ *
+ * Returns:
+ *       A server id, or 0 if no more cursors are due.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+uint32_t
+_mongoc_kill_cursors_queue_next_due (mongoc_kill_cursors_queue_t *queue,
+                                     uint32_t                     after,
+                                     bool                         force)
+{
+   mongoc_kill_cursors_entry_t *entry;
+   int64_t now;
+   uint32_t server_id = 0;
+   size_t i;
+
+   BSON_ASSERT (queue);
+
+   now = bson_get_monotonic_time ();
+
+   mongoc_mutex_lock (&queue->mutex);
+
+   for (i = 0; i < queue->entries.len; i++) {
+      entry = &_mongoc_array_index (&queue->entries,
+                                    mongoc_kill_cursors_entry_t, i);
+
+      if (entry->server_id <= after ||
+          (server_id && entry->server_id >= server_id)) {
+         continue;
+      }
+
+      if (force || _mongoc_kill_cursors_queue_due (queue,
+                                                   entry->server_id,
+                                                   now)) {
+         server_id = entry->server_id;
+      }
+   }
+
+   mongoc_mutex_unlock (&queue->mutex);
+
+   return server_id;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_kill_cursors_queue_take --
+ *
+ *       Move all cursors queued for @server_id into @entries, if they are
+ *       due or if @force is true. @entries must have been initialized
+ *       with _mongoc_array_init for mongoc_kill_cursors_entry_t; the
+ *       caller releases its contents with _mongoc_kill_cursors_entries_clear.
+ *
+ * Returns:
+ *       true if any entries were taken.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_kill_cursors_queue_take (mongoc_kill_cursors_queue_t *queue,
+                                 uint32_t                     server_id,
+                                 bool                         force,
+                                 mongoc_array_t              *entries)
+{
+   mongoc_kill_cursors_entry_t *entry;
+   size_t kept = 0;
+   size_t i;
+   bool ret = false;
+
+   BSON_ASSERT (queue);
+   BSON_ASSERT (entries);
+
+   mongoc_mutex_lock (&queue->mutex);
+
+   if (!queue->entries.len) {
+      /* the common case: nothing to do */
+      GOTO (done);
+   }
+
+   if (!force && !_mongoc_kill_cursors_queue_due (queue, server_id,
+                                                  bson_get_monotonic_time ())) {
+      GOTO (done);
+   }
+
+   for (i = 0; i < queue->entries.len; i++) {
+      entry = &_mongoc_array_index (&queue->entries,
+                                    mongoc_kill_cursors_entry_t, i);
+
+      if (entry->server_id == server_id) {
+         _mongoc_array_append_vals (entries, entry, 1);
+         ret = true;
+      } else {
+         _mongoc_array_index (&queue->entries,
+                              mongoc_kill_cursors_entry_t, kept++) = *entry;
+      }
+   }
+
+   bson_atomic_int_add (&queue->n_entries,
+                        (int32_t) kept - (int32_t) queue->entries.len);
+   queue->entries.len = kept;
+
+done:
+   mongoc_mutex_unlock (&queue->mutex);
+
+   return ret;
+}
+
+
+void
+_mongoc_kill_cursors_entries_clear (mongoc_array_t *entries)
+{
+   mongoc_kill_cursors_entry_t *entry;
+   size_t i;
+
+   for (i = 0; i < entries->len; i++) {
+      entry = &_mongoc_array_index (entries, mongoc_kill_cursors_entry_t, i);
+      bson_free (entry->db);
+      bson_free (entry->collection);
+   }
+
+   _mongoc_array_clear (entries);
+}
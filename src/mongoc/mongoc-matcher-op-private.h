@@ -126,6 +126,8 @@ mongoc_matcher_op_t *_mongoc_matcher_op_not_new     (const char              *pa
                                                      mongoc_matcher_op_t     *child);
 bool                 _mongoc_matcher_op_match       (mongoc_matcher_op_t     *op,
                                                      const bson_t            *bson);
+bool                 _mongoc_matcher_op_match_iter  (mongoc_matcher_op_t     *op,
+                                                     bson_iter_t             *iter);
 void                 _mongoc_matcher_op_destroy     (mongoc_matcher_op_t     *op);
 void                 _mongoc_matcher_op_to_bson     (mongoc_matcher_op_t     *op,
                                                      bson_t                  *bson);
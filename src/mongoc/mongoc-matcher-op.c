@@ -334,7 +334,7 @@ _mongoc_matcher_op_type_match (mongoc_matcher_op_type_t *type, /* IN */
 
    if (bson_iter_init (&iter, bson) &&
        bson_iter_find_descendant (&iter, type->path, &desc)) {
-      return (bson_iter_type (&iter) == type->type);
+      return (bson_iter_type (&desc) == type->type);
    }
 
    return false;
@@ -932,10 +932,10 @@ _mongoc_matcher_op_nin_match (mongoc_matcher_op_compare_t *compare, /* IN */
 /*
  *--------------------------------------------------------------------------
  *
- * _mongoc_matcher_op_compare_match --
+ * _mongoc_matcher_op_compare_match_iter --
  *
  *       Dispatch function for mongoc_matcher_op_compare_t operations
- *       to perform a match.
+ *       to perform a match against the field @iter.
  *
  * Returns:
  *       Opcode dependent.
@@ -946,6 +946,56 @@ _mongoc_matcher_op_nin_match (mongoc_matcher_op_compare_t *compare, /* IN */
  *--------------------------------------------------------------------------
  */
 
+static bool
+_mongoc_matcher_op_compare_match_iter (mongoc_matcher_op_compare_t *compare, /* IN */
+                                       bson_iter_t                 *iter)    /* IN */
+{
+   BSON_ASSERT (compare);
+   BSON_ASSERT (iter);
+
+   switch ((int)compare->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+      return _mongoc_matcher_op_eq_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GT:
+      return _mongoc_matcher_op_gt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GTE:
+      return _mongoc_matcher_op_gte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_IN:
+      return _mongoc_matcher_op_in_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LT:
+      return _mongoc_matcher_op_lt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LTE:
+      return _mongoc_matcher_op_lte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NE:
+      return _mongoc_matcher_op_ne_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return _mongoc_matcher_op_nin_match (compare, iter);
+   default:
+      BSON_ASSERT (false);
+      break;
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_compare_match --
+ *
+ *       Find the field at the path of @compare in @bson and perform a
+ *       match against it.
+ *
+ * Returns:
+ *       Opcode dependent. false if there is no such field.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
 static bool
 _mongoc_matcher_op_compare_match (mongoc_matcher_op_compare_t *compare, /* IN */
                                   const bson_t                *bson)    /* IN */
@@ -965,23 +1015,53 @@ _mongoc_matcher_op_compare_match (mongoc_matcher_op_compare_t *compare, /* IN */
       return false;
    }
 
-   switch ((int)compare->base.opcode) {
+   return _mongoc_matcher_op_compare_match_iter (compare, &iter);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_match_iter --
+ *
+ *       Perform the match of a compare, $exists or $type op against
+ *       @iter, the field already found at the op's path, or NULL if the
+ *       document has no such field.
+ *
+ * Returns:
+ *       Opcode specific.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_op_match_iter (mongoc_matcher_op_t *op,   /* IN */
+                               bson_iter_t         *iter) /* IN */
+{
+   BSON_ASSERT (op);
+
+   switch (op->base.opcode) {
    case MONGOC_MATCHER_OPCODE_EQ:
-      return _mongoc_matcher_op_eq_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_GT:
-      return _mongoc_matcher_op_gt_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_GTE:
-      return _mongoc_matcher_op_gte_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_IN:
-      return _mongoc_matcher_op_in_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_LT:
-      return _mongoc_matcher_op_lt_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_LTE:
-      return _mongoc_matcher_op_lte_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_NE:
-      return _mongoc_matcher_op_ne_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_NIN:
-      return _mongoc_matcher_op_nin_match (compare, &iter);
+      return iter && _mongoc_matcher_op_compare_match_iter (&op->compare,
+                                                            iter);
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return ((iter != NULL) == op->exists.exists);
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return iter && (bson_iter_type (iter) == op->type.type);
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOT:
+   case MONGOC_MATCHER_OPCODE_NOR:
    default:
       BSON_ASSERT (false);
       break;
@@ -24,6 +24,7 @@
 #include <bson.h>
 
 #include "mongoc-matcher-op-private.h"
+#include "mongoc-matcher-program-private.h"
 
 
 BSON_BEGIN_DECLS
@@ -31,8 +32,9 @@ BSON_BEGIN_DECLS
 
 struct _mongoc_matcher_t
 {
-   bson_t               query;
-   mongoc_matcher_op_t *optree;
+   bson_t                    query;
+   mongoc_matcher_op_t      *optree;
+   mongoc_matcher_program_t *program;
 };
 
 
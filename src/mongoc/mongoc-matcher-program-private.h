@@ -0,0 +1,87 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_MATCHER_PROGRAM_PRIVATE_H
+#define MONGOC_MATCHER_PROGRAM_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-matcher-op-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_matcher_insn_t    mongoc_matcher_insn_t;
+typedef struct _mongoc_matcher_program_t mongoc_matcher_program_t;
+
+
+typedef enum
+{
+   /* result = the leaf op's match on its field */
+   MONGOC_MATCHER_INSN_TEST,
+   /* result = !result */
+   MONGOC_MATCHER_INSN_NOT,
+   /* go to target if result is true, or false */
+   MONGOC_MATCHER_INSN_JUMP_IF_TRUE,
+   MONGOC_MATCHER_INSN_JUMP_IF_FALSE
+} mongoc_matcher_insn_type_t;
+
+
+struct _mongoc_matcher_insn_t
+{
+   mongoc_matcher_insn_type_t  type;
+   int                         target;
+   mongoc_matcher_op_t        *op;
+   /* the top-level field the op's path starts with */
+   int                         field;
+   /* the rest of the path, split at its dots and NULL-terminated */
+   char                      **segments;
+   /* an int32, int64 or double to compare with, else BSON_TYPE_EOD */
+   bson_type_t                 value_type;
+   int64_t                     value_int64;
+   double                      value_double;
+};
+
+
+struct _mongoc_matcher_program_t
+{
+   mongoc_matcher_insn_t *insns;
+   int                    n_insns;
+   int                    insns_alloc;
+   char                 **fields;
+   int                    n_fields;
+};
+
+
+mongoc_matcher_program_t *_mongoc_matcher_program_new        (mongoc_matcher_op_t             *optree);
+bool                      _mongoc_matcher_program_match      (const mongoc_matcher_program_t  *program,
+                                                              const bson_t                    *bson);
+void                      _mongoc_matcher_program_match_many (const mongoc_matcher_program_t  *program,
+                                                              const bson_t                   **docs,
+                                                              size_t                           n_docs,
+                                                              bool                            *matched);
+void                      _mongoc_matcher_program_destroy    (mongoc_matcher_program_t        *program);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_MATCHER_PROGRAM_PRIVATE_H */
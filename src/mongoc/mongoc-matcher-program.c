@@ -0,0 +1,636 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-matcher-program-private.h"
+
+
+/*
+ * A program is the optree flattened into an array of instructions that
+ * share one boolean result. Logical ops become forward jumps around the
+ * instructions of their right side, so a match runs the array once, front
+ * to back, with no recursion.
+ *
+ * Each leaf names the top-level field its path starts with. Before the
+ * program runs, one pass over the document's top-level fields finds all of
+ * them, instead of a search from the start of the document per leaf.
+ */
+
+
+/* fields found in a document without allocating */
+#define MONGOC_MATCHER_PROGRAM_STACK_FIELDS 16
+
+
+static int
+_mongoc_matcher_program_emit (mongoc_matcher_program_t   *program, /* IN */
+                              mongoc_matcher_insn_type_t  type)    /* IN */
+{
+   mongoc_matcher_insn_t *insn;
+
+   if (program->n_insns == program->insns_alloc) {
+      program->insns_alloc = program->insns_alloc ? program->insns_alloc * 2
+                                                  : 8;
+      program->insns = (mongoc_matcher_insn_t *)bson_realloc (
+         program->insns, program->insns_alloc * sizeof *program->insns);
+   }
+
+   insn = &program->insns[program->n_insns];
+   memset (insn, 0, sizeof *insn);
+   insn->type = type;
+   insn->field = -1;
+   insn->value_type = BSON_TYPE_EOD;
+
+   return program->n_insns++;
+}
+
+
+static const char *
+_mongoc_matcher_op_path (mongoc_matcher_op_t *op) /* IN */
+{
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return op->exists.path;
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return op->type.path;
+   default:
+      return op->compare.path;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_emit_test --
+ *
+ *       Emit the instruction for the leaf @op: its path split at the dots,
+ *       the top-level field it starts with, and its value if it's a
+ *       number compared with one of ==, !=, <, <=, > or >=.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       The first segment of the path is added to the program's fields.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_matcher_program_emit_test (mongoc_matcher_program_t *program, /* IN */
+                                   mongoc_matcher_op_t      *op)      /* IN */
+{
+   mongoc_matcher_insn_t *insn;
+   const char *path;
+   const char *dot;
+   char *first;
+   int n_segments;
+   int i;
+
+   i = _mongoc_matcher_program_emit (program, MONGOC_MATCHER_INSN_TEST);
+   insn = &program->insns[i];
+   insn->op = op;
+
+   path = _mongoc_matcher_op_path (op);
+
+   if ((dot = strchr (path, '.'))) {
+      first = bson_strndup (path, dot - path);
+   } else {
+      first = bson_strdup (path);
+   }
+
+   for (i = 0; i < program->n_fields; i++) {
+      if (!strcmp (program->fields[i], first)) {
+         break;
+      }
+   }
+
+   if (i == program->n_fields) {
+      program->fields = (char **)bson_realloc (
+         program->fields, (program->n_fields + 1) * sizeof (char *));
+      program->fields[program->n_fields++] = first;
+   } else {
+      bson_free (first);
+   }
+
+   insn->field = i;
+
+   n_segments = 0;
+   for (dot = strchr (path, '.'); dot; dot = strchr (dot + 1, '.')) {
+      n_segments++;
+   }
+
+   insn->segments = (char **)bson_malloc0 ((n_segments + 1) * sizeof (char *));
+
+   for (i = 0, dot = strchr (path, '.'); dot; i++) {
+      path = dot + 1;
+      dot = strchr (path, '.');
+      insn->segments[i] = dot ? bson_strndup (path, dot - path)
+                              : bson_strdup (path);
+   }
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+      switch (bson_iter_type (&op->compare.iter)) {
+      case BSON_TYPE_INT32:
+      case BSON_TYPE_INT64:
+         insn->value_type = bson_iter_type (&op->compare.iter);
+         insn->value_int64 = bson_iter_as_int64 (&op->compare.iter);
+         break;
+      case BSON_TYPE_DOUBLE:
+         insn->value_type = BSON_TYPE_DOUBLE;
+         insn->value_double = bson_iter_double (&op->compare.iter);
+         break;
+      default:
+         break;
+      }
+      break;
+   default:
+      break;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_compile --
+ *
+ *       Append the instructions for @op to @program. Afterward the
+ *       result is @op's match.
+ *
+ *       {$and: [l, r]} is l, JUMP_IF_FALSE end, r.
+ *       {$or: [l, r]} is l, JUMP_IF_TRUE end, r.
+ *       {$nor: [l, r]} is l, JUMP_IF_TRUE not, r, not: NOT.
+ *       {$not: c} is c, NOT.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_matcher_program_compile (mongoc_matcher_program_t *program, /* IN */
+                                 mongoc_matcher_op_t      *op)      /* IN */
+{
+   int jump;
+
+   BSON_ASSERT (op);
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOR:
+      _mongoc_matcher_program_compile (program, op->logical.left);
+
+      if (op->logical.right) {
+         jump = _mongoc_matcher_program_emit (
+            program, op->base.opcode == MONGOC_MATCHER_OPCODE_AND
+                     ? MONGOC_MATCHER_INSN_JUMP_IF_FALSE
+                     : MONGOC_MATCHER_INSN_JUMP_IF_TRUE);
+         _mongoc_matcher_program_compile (program, op->logical.right);
+         program->insns[jump].target = program->n_insns;
+      }
+
+      if (op->base.opcode == MONGOC_MATCHER_OPCODE_NOR) {
+         _mongoc_matcher_program_emit (program, MONGOC_MATCHER_INSN_NOT);
+      }
+      break;
+   case MONGOC_MATCHER_OPCODE_NOT:
+      _mongoc_matcher_program_compile (program, op->not_.child);
+      _mongoc_matcher_program_emit (program, MONGOC_MATCHER_INSN_NOT);
+      break;
+   default:
+      _mongoc_matcher_program_emit_test (program, op);
+      break;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_new --
+ *
+ *       Compile @optree into a program.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_program_t that should be freed
+ *       with _mongoc_matcher_program_destroy(). It refers to the ops of
+ *       @optree, which must outlive it.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_matcher_program_t *
+_mongoc_matcher_program_new (mongoc_matcher_op_t *optree) /* IN */
+{
+   mongoc_matcher_program_t *program;
+
+   BSON_ASSERT (optree);
+
+   program = (mongoc_matcher_program_t *)bson_malloc0 (sizeof *program);
+   _mongoc_matcher_program_compile (program, optree);
+
+   return program;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_insn_compare_number --
+ *
+ *       Compare a number in @iter with the number in @insn the way the
+ *       matcher's compare ops do: as doubles if either is a double,
+ *       otherwise as int64s.
+ *
+ * Returns:
+ *       true if @iter holds an int32, int64 or double and @result is set
+ *       to the match; otherwise false.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_insn_compare_number (const mongoc_matcher_insn_t *insn,   /* IN */
+                                     const bson_iter_t           *iter,   /* IN */
+                                     bool                        *result) /* OUT */
+{
+   double ld, rd;
+   int64_t li, ri;
+   int cmp;
+
+   switch (bson_iter_type (iter)) {
+   case BSON_TYPE_INT32:
+   case BSON_TYPE_INT64:
+      li = bson_iter_as_int64 (iter);
+
+      if (insn->value_type == BSON_TYPE_DOUBLE) {
+         ld = (double)li;
+         rd = insn->value_double;
+         break;
+      }
+
+      ri = insn->value_int64;
+      cmp = (li > ri) - (li < ri);
+      goto compare;
+   case BSON_TYPE_DOUBLE:
+      ld = bson_iter_double (iter);
+      rd = insn->value_type == BSON_TYPE_DOUBLE ? insn->value_double
+                                                : (double)insn->value_int64;
+      break;
+   default:
+      return false;
+   }
+
+   /* NaN is neither less, equal, nor greater */
+   if (ld != ld || rd != rd) {
+      *result = insn->op->base.opcode == MONGOC_MATCHER_OPCODE_NE;
+      return true;
+   }
+
+   cmp = (ld > rd) - (ld < rd);
+
+compare:
+   switch ((int)insn->op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+      *result = cmp == 0;
+      break;
+   case MONGOC_MATCHER_OPCODE_NE:
+      *result = cmp != 0;
+      break;
+   case MONGOC_MATCHER_OPCODE_GT:
+      *result = cmp > 0;
+      break;
+   case MONGOC_MATCHER_OPCODE_GTE:
+      *result = cmp >= 0;
+      break;
+   case MONGOC_MATCHER_OPCODE_LT:
+      *result = cmp < 0;
+      break;
+   case MONGOC_MATCHER_OPCODE_LTE:
+      *result = cmp <= 0;
+      break;
+   default:
+      BSON_ASSERT (false);
+      return false;
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_insn_test --
+ *
+ *       Run the TEST instruction @insn, given @field, the top-level field
+ *       its path starts with or NULL if the document has none.
+ *
+ * Returns:
+ *       The leaf op's match.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_insn_test (const mongoc_matcher_insn_t *insn,  /* IN */
+                           const bson_iter_t           *field) /* IN */
+{
+   bson_iter_t iter;
+   bson_iter_t child;
+   char **segment;
+   bool result;
+
+   if (!field) {
+      return _mongoc_matcher_op_match_iter (insn->op, NULL);
+   }
+
+   memcpy (&iter, field, sizeof iter);
+
+   /* like bson_iter_find_descendant, from the second segment on */
+   for (segment = insn->segments; *segment; segment++) {
+      if (!(BSON_ITER_HOLDS_DOCUMENT (&iter) ||
+            BSON_ITER_HOLDS_ARRAY (&iter)) ||
+          !bson_iter_recurse (&iter, &child) ||
+          !bson_iter_find (&child, *segment)) {
+         return _mongoc_matcher_op_match_iter (insn->op, NULL);
+      }
+
+      memcpy (&iter, &child, sizeof iter);
+   }
+
+   if (insn->value_type != BSON_TYPE_EOD &&
+       _mongoc_matcher_insn_compare_number (insn, &iter, &result)) {
+      return result;
+   }
+
+   return _mongoc_matcher_op_match_iter (insn->op, &iter);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_run --
+ *
+ *       Run @program on @bson. @found and @has have room for each of the
+ *       program's fields.
+ *
+ * Returns:
+ *       true if @bson matched the query the program was compiled from.
+ *
+ * Side effects:
+ *       @found and @has are overwritten.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_program_run (const mongoc_matcher_program_t *program, /* IN */
+                             const bson_t                   *bson,    /* IN */
+                             bson_iter_t                    *found,   /* OUT */
+                             bool                           *has)     /* OUT */
+{
+   const mongoc_matcher_insn_t *insn;
+   bson_iter_t iter;
+   const char *key;
+   int n_missing;
+   bool result = false;
+   int pc;
+   int i;
+
+   memset (has, 0, program->n_fields * sizeof *has);
+   n_missing = program->n_fields;
+
+   /* the first field with each name, as bson_iter_find would find */
+   if (bson_iter_init (&iter, bson)) {
+      while (n_missing && bson_iter_next (&iter)) {
+         key = bson_iter_key (&iter);
+
+         for (i = 0; i < program->n_fields; i++) {
+            if (!has[i] && !strcmp (key, program->fields[i])) {
+               memcpy (&found[i], &iter, sizeof iter);
+               has[i] = true;
+               n_missing--;
+               break;
+            }
+         }
+      }
+   }
+
+   for (pc = 0; pc < program->n_insns; pc++) {
+      insn = &program->insns[pc];
+
+      switch (insn->type) {
+      case MONGOC_MATCHER_INSN_TEST:
+         result = _mongoc_matcher_insn_test (
+            insn, has[insn->field] ? &found[insn->field] : NULL);
+         break;
+      case MONGOC_MATCHER_INSN_NOT:
+         result = !result;
+         break;
+      case MONGOC_MATCHER_INSN_JUMP_IF_TRUE:
+         if (result) {
+            pc = insn->target - 1;
+         }
+         break;
+      case MONGOC_MATCHER_INSN_JUMP_IF_FALSE:
+         if (!result) {
+            pc = insn->target - 1;
+         }
+         break;
+      default:
+         BSON_ASSERT (false);
+         break;
+      }
+   }
+
+   return result;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_match --
+ *
+ *       Run @program on @bson.
+ *
+ * Returns:
+ *       true if @bson matched the query the program was compiled from.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_program_match (const mongoc_matcher_program_t *program, /* IN */
+                               const bson_t                   *bson)    /* IN */
+{
+   bool matched;
+
+   BSON_ASSERT (program);
+   BSON_ASSERT (bson);
+
+   _mongoc_matcher_program_match_many (program, &bson, 1, &matched);
+
+   return matched;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_match_many --
+ *
+ *       Run @program on each of the @n_docs documents in @docs, setting
+ *       the same element of @matched to the result.
+ *
+ *       The room for the program's fields is set up once for the whole
+ *       batch. A program that is one number comparison on a top-level
+ *       field, like {"a": 1} or {"a": {"$gt": 1.5}}, skips the field
+ *       table and the instruction loop: each document is one search
+ *       for the field and one native comparison.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_matcher_program_match_many (const mongoc_matcher_program_t  *program, /* IN */
+                                    const bson_t                   **docs,    /* IN */
+                                    size_t                           n_docs,  /* IN */
+                                    bool                            *matched) /* OUT */
+{
+   bson_iter_t stack_found[MONGOC_MATCHER_PROGRAM_STACK_FIELDS];
+   bool stack_has[MONGOC_MATCHER_PROGRAM_STACK_FIELDS];
+   const mongoc_matcher_insn_t *insn;
+   bson_iter_t *found = stack_found;
+   bool *has = stack_has;
+   bson_iter_t iter;
+   size_t i;
+
+   BSON_ASSERT (program);
+   BSON_ASSERT (docs || !n_docs);
+   BSON_ASSERT (matched || !n_docs);
+
+   insn = program->insns;
+
+   if (program->n_insns == 1 &&
+       insn->type == MONGOC_MATCHER_INSN_TEST &&
+       !insn->segments[0] &&
+       insn->value_type != BSON_TYPE_EOD) {
+      for (i = 0; i < n_docs; i++) {
+         if (!bson_iter_init_find (&iter, docs[i], program->fields[0])) {
+            matched[i] = _mongoc_matcher_op_match_iter (insn->op, NULL);
+         } else if (!_mongoc_matcher_insn_compare_number (insn, &iter,
+                                                          &matched[i])) {
+            matched[i] = _mongoc_matcher_op_match_iter (insn->op, &iter);
+         }
+      }
+
+      return;
+   }
+
+   if (program->n_fields > MONGOC_MATCHER_PROGRAM_STACK_FIELDS) {
+      found = (bson_iter_t *)bson_malloc (program->n_fields * sizeof *found);
+      has = (bool *)bson_malloc (program->n_fields * sizeof *has);
+   }
+
+   for (i = 0; i < n_docs; i++) {
+      matched[i] = _mongoc_matcher_program_run (program, docs[i], found, has);
+   }
+
+   if (found != stack_found) {
+      bson_free (found);
+      bson_free (has);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_destroy --
+ *
+ *       Release all resources associated with @program, but not the ops
+ *       it refers to.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_matcher_program_destroy (mongoc_matcher_program_t *program) /* IN */
+{
+   char **segment;
+   int i;
+
+   if (!program) {
+      return;
+   }
+
+   for (i = 0; i < program->n_insns; i++) {
+      if (program->insns[i].segments) {
+         for (segment = program->insns[i].segments; *segment; segment++) {
+            bson_free (*segment);
+         }
+
+         bson_free (program->insns[i].segments);
+      }
+   }
+
+   for (i = 0; i < program->n_fields; i++) {
+      bson_free (program->fields[i]);
+   }
+
+   bson_free (program->insns);
+   bson_free (program->fields);
+   bson_free (program);
+}
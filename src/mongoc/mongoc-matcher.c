@@ -21,6 +21,7 @@
 #include "mongoc-matcher.h"
 #include "mongoc-matcher-private.h"
 #include "mongoc-matcher-op-private.h"
+#include "mongoc-matcher-program-private.h"
 
 
 static mongoc_matcher_op_t *
@@ -302,8 +303,9 @@ _mongoc_matcher_parse_logical (mongoc_matcher_opcode_t  opcode,  /* IN */
  *       Create a new mongoc_matcher_t using the query specification
  *       provided in @query.
  *
- *       This will build an operation tree that can be applied to arbitrary
- *       bson documents using mongoc_matcher_match().
+ *       This will build an operation tree, and compile it into a flat
+ *       program that can be applied to arbitrary bson documents using
+ *       mongoc_matcher_match().
  *
  * Returns:
  *       A newly allocated mongoc_matcher_t if successful; otherwise NULL
@@ -341,6 +343,7 @@ mongoc_matcher_new (const bson_t *query, /* IN */
    }
 
    matcher->optree = op;
+   matcher->program = _mongoc_matcher_program_new (op);
 
    return matcher;
 
@@ -373,10 +376,43 @@ mongoc_matcher_match (const mongoc_matcher_t *matcher,  /* IN */
                       const bson_t           *document) /* IN */
 {
    BSON_ASSERT (matcher);
-   BSON_ASSERT (matcher->optree);
+   BSON_ASSERT (matcher->program);
    BSON_ASSERT (document);
 
-   return _mongoc_matcher_op_match (matcher->optree, document);
+   return _mongoc_matcher_program_match (matcher->program, document);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_matcher_match_many --
+ *
+ *       Checks each of the @n_documents documents in @documents against
+ *       the query specified when creating @matcher, like
+ *       mongoc_matcher_match() does, for a batch at a time.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       matched[i] is set to TRUE if documents[i] matched the query,
+ *       otherwise FALSE.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_matcher_match_many (const mongoc_matcher_t  *matcher,     /* IN */
+                           const bson_t           **documents,   /* IN */
+                           size_t                   n_documents, /* IN */
+                           bool                    *matched)     /* OUT */
+{
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (matcher->program);
+
+   _mongoc_matcher_program_match_many (matcher->program, documents,
+                                       n_documents, matched);
 }
 
 
@@ -401,6 +437,7 @@ mongoc_matcher_destroy (mongoc_matcher_t *matcher) /* IN */
 {
    BSON_ASSERT (matcher);
 
+   _mongoc_matcher_program_destroy (matcher->program);
    _mongoc_matcher_op_destroy (matcher->optree);
    bson_destroy (&matcher->query);
    bson_free (matcher);
@@ -30,11 +30,15 @@ BSON_BEGIN_DECLS
 typedef struct _mongoc_matcher_t mongoc_matcher_t;
 
 
-mongoc_matcher_t *mongoc_matcher_new     (const bson_t           *query,
-                                          bson_error_t           *error)      BSON_GNUC_DEPRECATED;
-bool              mongoc_matcher_match   (const mongoc_matcher_t *matcher,
-                                          const bson_t           *document)   BSON_GNUC_DEPRECATED;
-void              mongoc_matcher_destroy (mongoc_matcher_t       *matcher)    BSON_GNUC_DEPRECATED;
+mongoc_matcher_t *mongoc_matcher_new        (const bson_t            *query,
+                                             bson_error_t            *error)      BSON_GNUC_DEPRECATED;
+bool              mongoc_matcher_match      (const mongoc_matcher_t  *matcher,
+                                             const bson_t            *document)   BSON_GNUC_DEPRECATED;
+void              mongoc_matcher_match_many (const mongoc_matcher_t  *matcher,
+                                             const bson_t           **documents,
+                                             size_t                   n_documents,
+                                             bool                    *matched)    BSON_GNUC_DEPRECATED;
+void              mongoc_matcher_destroy    (mongoc_matcher_t        *matcher)    BSON_GNUC_DEPRECATED;
 
 
 BSON_END_DECLS
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_MUX_PRIVATE_H
+#define MONGOC_MUX_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client-pool.h"
+#include "mongoc-read-prefs.h"
+#include "mongoc-stream.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-topology-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_mux_t        mongoc_mux_t;
+typedef struct _mongoc_mux_conn_t   mongoc_mux_conn_t;
+typedef struct _mongoc_mux_waiter_t mongoc_mux_waiter_t;
+
+
+/* a thread awaiting the reply to its request on a shared connection */
+struct _mongoc_mux_waiter_t
+{
+   int32_t              request_id;
+   bool                 done;
+   bool                 has_reply;
+   bson_t               reply;
+   bson_error_t         error;
+   mongoc_mux_waiter_t *next;
+};
+
+
+/* a connection shared by many threads: requests are written one at a
+ * time, and one thread at a time reads replies and routes each to the
+ * waiter whose request it answers */
+struct _mongoc_mux_conn_t
+{
+   uint32_t             server_id;
+   mongoc_stream_t     *stream;
+   /* held to write a request, and on TLS also to read a reply */
+   mongoc_mutex_t       io_mutex;
+   bool                 tls;
+   /* signalled when a reply is routed or the reader is done */
+   mongoc_cond_t        cond;
+   bool                 reading;
+   bool                 failed;
+   /* a slot reserved while a thread connects, with no stream yet */
+   bool                 connecting;
+   /* threads using the connection, it is closed once failed and unused */
+   uint32_t             n_users;
+   mongoc_mux_waiter_t *waiters;
+   mongoc_mux_conn_t   *next;
+};
+
+
+struct _mongoc_mux_t
+{
+   mongoc_mutex_t       mutex;
+   /* signalled when a connect finishes, for threads waiting on a slot */
+   mongoc_cond_t        cond;
+   /* per server, 0 if multiplexing is off */
+   uint32_t             max_connections;
+   int32_t              request_id;
+   mongoc_mux_conn_t   *conns;
+};
+
+
+mongoc_mux_t *_mongoc_mux_new                 (void);
+void          _mongoc_mux_destroy             (mongoc_mux_t              *mux);
+void          _mongoc_mux_set_max_connections (mongoc_mux_t              *mux,
+                                               uint32_t                   max_connections);
+bool          _mongoc_mux_enabled             (mongoc_mux_t              *mux);
+bool          _mongoc_mux_command             (mongoc_mux_t              *mux,
+                                               mongoc_client_pool_t      *pool,
+                                               mongoc_topology_t         *topology,
+                                               int32_t                    error_api_version,
+                                               int32_t                    timeout_msec,
+                                               const char                *db_name,
+                                               const bson_t              *command,
+                                               const mongoc_read_prefs_t *read_prefs,
+                                               bson_t                    *reply,
+                                               bson_error_t              *error);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_MUX_PRIVATE_H */
@@ -0,0 +1,596 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-client-pool.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
+#include "mongoc-error.h"
+#include "mongoc-mux-private.h"
+#include "mongoc-read-prefs-private.h"
+#include "mongoc-rpc-private.h"
+#include "mongoc-server-stream-private.h"
+#include "mongoc-stream-private.h"
+#include "mongoc-trace.h"
+#include "utlist.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "mux"
+
+
+/*
+ * The mux lets many threads share a few connections per server. A thread
+ * writes its request, tagged with a request id unique in the mux, then
+ * waits for the reply whose responseTo matches it. Whichever waiting
+ * thread finds no one reading the connection becomes its reader: it reads
+ * one reply, hands it to the waiter it belongs to, and wakes the others,
+ * so every waiter reads in turn until its own reply has arrived.
+ *
+ * A failure to write or read leaves the connection out of step, so all
+ * its waiters fail and it is closed once the last thread is done with it.
+ */
+
+
+mongoc_mux_t *
+_mongoc_mux_new (void)
+{
+   mongoc_mux_t *mux;
+
+   mux = (mongoc_mux_t *)bson_malloc0 (sizeof *mux);
+   mongoc_mutex_init (&mux->mutex);
+   mongoc_cond_init (&mux->cond);
+
+   return mux;
+}
+
+
+static void
+_mongoc_mux_conn_destroy (mongoc_mux_conn_t *conn)
+{
+   mongoc_stream_destroy (conn->stream);
+   mongoc_mutex_destroy (&conn->io_mutex);
+   mongoc_cond_destroy (&conn->cond);
+   bson_free (conn);
+}
+
+
+void
+_mongoc_mux_destroy (mongoc_mux_t *mux)
+{
+   mongoc_mux_conn_t *conn, *tmp;
+
+   LL_FOREACH_SAFE (mux->conns, conn, tmp)
+   {
+      BSON_ASSERT (!conn->n_users);
+      _mongoc_mux_conn_destroy (conn);
+   }
+
+   mongoc_cond_destroy (&mux->cond);
+   mongoc_mutex_destroy (&mux->mutex);
+   bson_free (mux);
+}
+
+
+void
+_mongoc_mux_set_max_connections (mongoc_mux_t *mux,
+                                 uint32_t      max_connections)
+{
+   mongoc_mutex_lock (&mux->mutex);
+   mux->max_connections = max_connections;
+   mongoc_mutex_unlock (&mux->mutex);
+}
+
+
+bool
+_mongoc_mux_enabled (mongoc_mux_t *mux)
+{
+   bool enabled;
+
+   mongoc_mutex_lock (&mux->mutex);
+   enabled = mux->max_connections > 0;
+   mongoc_mutex_unlock (&mux->mutex);
+
+   return enabled;
+}
+
+
+/* the usable connection to @server_id with the fewest users, and the
+ * number of usable connections to it, counting those still connecting.
+ * call with the mutex locked */
+static mongoc_mux_conn_t *
+_mongoc_mux_find_conn (mongoc_mux_t *mux,
+                       uint32_t      server_id,
+                       uint32_t     *n_conns)
+{
+   mongoc_mux_conn_t *conn;
+   mongoc_mux_conn_t *best = NULL;
+
+   *n_conns = 0;
+
+   LL_FOREACH (mux->conns, conn)
+   {
+      if (conn->server_id != server_id || conn->failed) {
+         continue;
+      }
+
+      (*n_conns)++;
+
+      if (conn->connecting) {
+         continue;
+      }
+
+      if (!best || conn->n_users < best->n_users) {
+         best = conn;
+      }
+   }
+
+   return best;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_mux_get_conn --
+ *
+ *       A connection to @server_id for the calling thread to use: the one
+ *       with the fewest users, or a new one if none is idle and fewer
+ *       than max_connections are open or connecting. A connect reserves
+ *       its slot first, so threads that find every slot reserved and no
+ *       connection to share wait for a connect to finish. Connecting
+ *       borrows a client from @pool for its settings and credentials.
+ *
+ * Returns:
+ *       A connection whose n_users counts the caller, or NULL and @error
+ *       is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_mux_conn_t *
+_mongoc_mux_get_conn (mongoc_mux_t         *mux,
+                      mongoc_client_pool_t *pool,
+                      uint32_t              server_id,
+                      bson_error_t         *error)
+{
+   mongoc_mux_conn_t *conn;
+   mongoc_mux_conn_t *pending;
+   mongoc_client_t *client;
+   mongoc_stream_t *stream;
+   uint32_t n_conns;
+
+   mongoc_mutex_lock (&mux->mutex);
+
+   for (;;) {
+      conn = _mongoc_mux_find_conn (mux, server_id, &n_conns);
+      if (conn && (!conn->n_users || n_conns >= mux->max_connections)) {
+         conn->n_users++;
+         mongoc_mutex_unlock (&mux->mutex);
+         return conn;
+      }
+
+      if (n_conns < mux->max_connections) {
+         break;
+      }
+
+      /* every slot is taken by a connect still in progress */
+      mongoc_cond_wait (&mux->cond, &mux->mutex);
+   }
+
+   pending = (mongoc_mux_conn_t *)bson_malloc0 (sizeof *pending);
+   pending->server_id = server_id;
+   pending->connecting = true;
+   LL_PREPEND (mux->conns, pending);
+
+   mongoc_mutex_unlock (&mux->mutex);
+
+   /* connect without blocking other threads */
+   client = mongoc_client_pool_pop (pool);
+   stream = _mongoc_cluster_connect_server (&client->cluster, server_id,
+                                            error);
+   mongoc_client_pool_push (pool, client);
+
+   mongoc_mutex_lock (&mux->mutex);
+
+   if (stream) {
+      conn = pending;
+      conn->stream = stream;
+      conn->tls = mongoc_stream_get_tls_stream (stream) != NULL;
+      mongoc_mutex_init (&conn->io_mutex);
+      mongoc_cond_init (&conn->cond);
+      conn->connecting = false;
+   } else {
+      LL_DELETE (mux->conns, pending);
+      bson_free (pending);
+
+      /* make do with the connections there are */
+      conn = _mongoc_mux_find_conn (mux, server_id, &n_conns);
+   }
+
+   if (conn) {
+      conn->n_users++;
+   }
+
+   mongoc_cond_broadcast (&mux->cond);
+   mongoc_mutex_unlock (&mux->mutex);
+
+   return conn;
+}
+
+
+/* fail every waiter on @conn. call with the mutex locked */
+static void
+_mongoc_mux_conn_fail (mongoc_mux_conn_t  *conn,
+                       const bson_error_t *error)
+{
+   mongoc_mux_waiter_t *waiter, *tmp;
+
+   conn->failed = true;
+
+   LL_FOREACH_SAFE (conn->waiters, waiter, tmp)
+   {
+      memcpy (&waiter->error, error, sizeof waiter->error);
+      waiter->done = true;
+      LL_DELETE (conn->waiters, waiter);
+   }
+
+   mongoc_cond_broadcast (&conn->cond);
+}
+
+
+/* hand a reply to the waiter whose request it answers. call with the
+ * mutex locked */
+static void
+_mongoc_mux_conn_route (mongoc_mux_conn_t *conn,
+                        int32_t            response_to,
+                        const bson_t      *reply)
+{
+   mongoc_mux_waiter_t *waiter;
+
+   LL_FOREACH (conn->waiters, waiter)
+   {
+      if (waiter->request_id == response_to) {
+         bson_copy_to (reply, &waiter->reply);
+         waiter->has_reply = true;
+         waiter->done = true;
+         LL_DELETE (conn->waiters, waiter);
+         return;
+      }
+   }
+
+   MONGOC_WARNING ("Discarding reply to unknown request %d.", response_to);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_mux_read_reply --
+ *
+ *       Read one OP_REPLY with a single document from @stream.
+ *
+ * Returns:
+ *       true and sets @response_to and initializes @reply, or false and
+ *       sets @error.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_mux_read_reply (mongoc_stream_t *stream,
+                        int32_t          timeout_msec,
+                        int32_t         *response_to,
+                        bson_t          *reply,
+                        bson_error_t    *error)
+{
+   const size_t reply_header_size = sizeof (mongoc_rpc_reply_header_t);
+   uint8_t reply_header_buf[sizeof (mongoc_rpc_reply_header_t)];
+   uint8_t *reply_buf;
+   mongoc_rpc_t rpc;
+   int32_t msg_len;
+   int32_t embedded_len;
+   size_t doc_len;
+
+   if (reply_header_size != mongoc_stream_read (stream, &reply_header_buf,
+                                                reply_header_size,
+                                                reply_header_size,
+                                                timeout_msec)) {
+      bson_set_error (error, MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET,
+                      "Failed to read %lu bytes from socket within "
+                      "%" PRId32 " milliseconds.",
+                      (unsigned long) reply_header_size, timeout_msec);
+      return false;
+   }
+
+   memcpy (&msg_len, reply_header_buf, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+
+   if ((msg_len < reply_header_size) ||
+       (msg_len > MONGOC_DEFAULT_MAX_MSG_SIZE) ||
+       !_mongoc_rpc_scatter_reply_header_only (&rpc, reply_header_buf,
+                                               reply_header_size)) {
+      goto invalid;
+   }
+
+   _mongoc_rpc_swab_from_le (&rpc);
+
+   if (rpc.header.opcode != MONGOC_OPCODE_REPLY ||
+       rpc.reply_header.n_returned != 1) {
+      goto invalid;
+   }
+
+   doc_len = (size_t) msg_len - reply_header_size;
+
+   if (doc_len < 5) {
+      goto invalid;
+   }
+
+   bson_init (reply);
+   reply_buf = bson_reserve_buffer (reply, (uint32_t) doc_len);
+   BSON_ASSERT (reply_buf);
+
+   if (doc_len != mongoc_stream_read (stream, (void *) reply_buf, doc_len,
+                                      doc_len, timeout_msec)) {
+      bson_destroy (reply);
+      bson_set_error (error, MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET,
+                      "Failed to read %lu bytes from socket within "
+                      "%" PRId32 " milliseconds.",
+                      (unsigned long) doc_len, timeout_msec);
+      return false;
+   }
+
+   /* the one document must fill the rest of the message */
+   memcpy (&embedded_len, reply_buf, 4);
+   embedded_len = BSON_UINT32_FROM_LE (embedded_len);
+
+   if ((size_t) embedded_len != doc_len || reply_buf[doc_len - 1] != '\0') {
+      bson_destroy (reply);
+      goto invalid;
+   }
+
+   *response_to = rpc.header.response_to;
+
+   return true;
+
+invalid:
+   bson_set_error (error, MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Invalid reply from server.");
+   return false;
+}
+
+
+/* write the request for @waiter, which is registered on @conn */
+static bool
+_mongoc_mux_conn_send (mongoc_mux_conn_t   *conn,
+                       mongoc_mux_waiter_t *waiter,
+                       mongoc_query_flags_t flags,
+                       const char          *db_name,
+                       const bson_t        *command,
+                       int32_t              timeout_msec,
+                       bson_error_t        *error)
+{
+   char cmd_ns[MONGOC_NAMESPACE_MAX];
+   mongoc_array_t ar;
+   mongoc_rpc_t rpc;
+   bool ret;
+
+   _mongoc_array_init (&ar, sizeof (mongoc_iovec_t));
+
+   bson_snprintf (cmd_ns, sizeof cmd_ns, "%s.$cmd", db_name);
+   _mongoc_rpc_prep_command (&rpc, cmd_ns, command, flags);
+   rpc.query.request_id = waiter->request_id;
+   _mongoc_rpc_gather (&rpc, &ar);
+   _mongoc_rpc_swab_to_le (&rpc);
+
+   mongoc_mutex_lock (&conn->io_mutex);
+   ret = _mongoc_stream_writev_full (conn->stream,
+                                     (mongoc_iovec_t *)ar.data, ar.len,
+                                     timeout_msec, error);
+   mongoc_mutex_unlock (&conn->io_mutex);
+
+   _mongoc_array_destroy (&ar);
+
+   return ret;
+}
+
+
+/* wait until @waiter is done, reading replies on @conn when no other
+ * thread is. call with the mutex locked */
+static void
+_mongoc_mux_conn_wait (mongoc_mux_t        *mux,
+                       mongoc_mux_conn_t   *conn,
+                       mongoc_mux_waiter_t *waiter,
+                       int32_t              timeout_msec)
+{
+   bson_error_t error;
+   int32_t response_to;
+   bson_t reply;
+   bool r;
+
+   while (!waiter->done) {
+      if (conn->reading) {
+         mongoc_cond_wait (&conn->cond, &mux->mutex);
+         continue;
+      }
+
+      conn->reading = true;
+      mongoc_mutex_unlock (&mux->mutex);
+
+      /* TLS can't read and write at once */
+      if (conn->tls) {
+         mongoc_mutex_lock (&conn->io_mutex);
+      }
+
+      r = _mongoc_mux_read_reply (conn->stream, timeout_msec, &response_to,
+                                  &reply, &error);
+
+      if (conn->tls) {
+         mongoc_mutex_unlock (&conn->io_mutex);
+      }
+
+      mongoc_mutex_lock (&mux->mutex);
+      conn->reading = false;
+
+      if (r) {
+         _mongoc_mux_conn_route (conn, response_to, &reply);
+         bson_destroy (&reply);
+         mongoc_cond_broadcast (&conn->cond);
+      } else {
+         _mongoc_mux_conn_fail (conn, &error);
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_mux_command --
+ *
+ *       Run @command on a server selected with @read_prefs, over a
+ *       connection shared with other threads. Thread safe.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @reply is always initialized.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_mux_command (mongoc_mux_t              *mux,
+                     mongoc_client_pool_t      *pool,
+                     mongoc_topology_t         *topology,
+                     int32_t                    error_api_version,
+                     int32_t                    timeout_msec,
+                     const char                *db_name,
+                     const bson_t              *command,
+                     const mongoc_read_prefs_t *read_prefs,
+                     bson_t                    *reply,
+                     bson_error_t              *error)
+{
+   mongoc_apply_read_prefs_result_t result = READ_PREFS_RESULT_INIT;
+   mongoc_topology_description_type_t topology_type;
+   mongoc_server_description_t *sd;
+   mongoc_server_stream_t *server_stream = NULL;
+   mongoc_mux_conn_t *conn;
+   mongoc_mux_waiter_t waiter = { 0 };
+   bson_error_t err_local;
+   bool send;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (mux);
+   BSON_ASSERT (pool);
+   BSON_ASSERT (read_prefs);
+
+   if (!error) {
+      error = &err_local;
+   }
+
+   if (reply) {
+      bson_init (reply);
+   }
+
+   sd = mongoc_topology_select (topology, MONGOC_SS_READ, read_prefs, error);
+   if (!sd) {
+      RETURN (false);
+   }
+
+   conn = _mongoc_mux_get_conn (mux, pool, sd->id, error);
+   if (!conn) {
+      mongoc_server_description_destroy (sd);
+      RETURN (false);
+   }
+
+   /* the pool's scanner thread may change the topology type */
+   mongoc_mutex_lock (&topology->mutex);
+   topology_type = topology->description.type;
+   mongoc_mutex_unlock (&topology->mutex);
+
+   /* sd becomes owned by server_stream */
+   server_stream = mongoc_server_stream_new (topology_type, sd, conn->stream);
+
+   apply_read_preferences (read_prefs, server_stream, command,
+                           MONGOC_QUERY_NONE, &result);
+
+   mongoc_mutex_lock (&mux->mutex);
+
+   if (conn->failed) {
+      bson_set_error (&waiter.error, MONGOC_ERROR_STREAM,
+                      MONGOC_ERROR_STREAM_SOCKET,
+                      "Connection failed with command pending.");
+      waiter.done = true;
+   } else {
+      waiter.request_id = ++mux->request_id;
+      LL_PREPEND (conn->waiters, &waiter);
+   }
+
+   /* once registered, the waiter is another thread's to finish */
+   send = !waiter.done;
+
+   mongoc_mutex_unlock (&mux->mutex);
+
+   if (send &&
+       !_mongoc_mux_conn_send (conn, &waiter, result.flags, db_name,
+                               result.query_with_read_prefs, timeout_msec,
+                               error)) {
+      mongoc_mutex_lock (&mux->mutex);
+      _mongoc_mux_conn_fail (conn, error);
+      mongoc_mutex_unlock (&mux->mutex);
+   }
+
+   mongoc_mutex_lock (&mux->mutex);
+
+   _mongoc_mux_conn_wait (mux, conn, &waiter, timeout_msec);
+
+   conn->n_users--;
+   if (conn->failed && !conn->n_users) {
+      LL_DELETE (mux->conns, conn);
+      _mongoc_mux_conn_destroy (conn);
+   }
+
+   mongoc_mutex_unlock (&mux->mutex);
+
+   if (waiter.has_reply) {
+      if (_mongoc_populate_cmd_error (&waiter.reply, error_api_version,
+                                      error)) {
+         ret = false;
+      } else {
+         ret = true;
+      }
+
+      if (reply) {
+         bson_destroy (reply);
+         bson_steal (reply, &waiter.reply);
+      } else {
+         bson_destroy (&waiter.reply);
+      }
+   } else {
+      memcpy (error, &waiter.error, sizeof *error);
+   }
+
+   apply_read_prefs_result_cleanup (&result);
+   mongoc_server_stream_cleanup (server_stream);
+
+   RETURN (ret);
+}
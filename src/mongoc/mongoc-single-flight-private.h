@@ -0,0 +1,85 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_SINGLE_FLIGHT_PRIVATE_H
+#define MONGOC_SINGLE_FLIGHT_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-cluster-private.h"
+#include "mongoc-server-stream-private.h"
+#include "mongoc-thread-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_single_flight_t      mongoc_single_flight_t;
+typedef struct _mongoc_single_flight_call_t mongoc_single_flight_call_t;
+
+
+/* one read command in flight, and the threads waiting for its reply */
+struct _mongoc_single_flight_call_t
+{
+   uint32_t                     server_id;
+   mongoc_query_flags_t         flags;
+   /* the leader's own, valid until the call is done */
+   const char                  *db_name;
+   const bson_t                *command;
+   mongoc_cond_t                cond;
+   bool                         done;
+   bool                         shared;
+   bool                         ret;
+   bson_t                       reply;
+   bson_error_t                 error;
+   uint32_t                     refs;
+   mongoc_single_flight_call_t *next;
+};
+
+
+struct _mongoc_single_flight_t
+{
+   mongoc_mutex_t               mutex;
+   bool                         enabled;
+   mongoc_single_flight_call_t *calls;
+};
+
+
+mongoc_single_flight_t *_mongoc_single_flight_new         (void);
+void                    _mongoc_single_flight_destroy     (mongoc_single_flight_t *single_flight);
+void                    _mongoc_single_flight_set_enabled (mongoc_single_flight_t *single_flight,
+                                                           bool                    enabled);
+uint32_t                _mongoc_single_flight_waiters     (mongoc_single_flight_t *single_flight);
+bool                    _mongoc_single_flight_run_command (mongoc_single_flight_t *single_flight,
+                                                           mongoc_cluster_t       *cluster,
+                                                           mongoc_server_stream_t *server_stream,
+                                                           mongoc_query_flags_t    flags,
+                                                           const char             *db_name,
+                                                           const bson_t           *command,
+                                                           bson_t                 *reply,
+                                                           bson_error_t           *error);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_SINGLE_FLIGHT_PRIVATE_H */
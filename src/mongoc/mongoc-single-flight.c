@@ -0,0 +1,323 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-counters-private.h"
+#include "mongoc-single-flight-private.h"
+#include "mongoc-trace.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "single-flight"
+
+
+/*
+ * Single flight coalesces identical reads. The first thread to send a find
+ * or count becomes the leader of a call; threads that send the same command
+ * with the same flags to the same server while the leader's round trip is
+ * in flight join the call and wait. When the reply comes, each of them
+ * takes a copy of it, so one round trip answers them all. Nothing is
+ * cached: a call is forgotten as soon as its reply arrives.
+ */
+
+
+mongoc_single_flight_t *
+_mongoc_single_flight_new (void)
+{
+   mongoc_single_flight_t *single_flight;
+
+   single_flight = (mongoc_single_flight_t *)bson_malloc0 (
+      sizeof *single_flight);
+   mongoc_mutex_init (&single_flight->mutex);
+
+   return single_flight;
+}
+
+
+void
+_mongoc_single_flight_destroy (mongoc_single_flight_t *single_flight)
+{
+   if (single_flight) {
+      /* every call's leader and followers have returned by now */
+      BSON_ASSERT (!single_flight->calls);
+      mongoc_mutex_destroy (&single_flight->mutex);
+      bson_free (single_flight);
+   }
+}
+
+
+void
+_mongoc_single_flight_set_enabled (mongoc_single_flight_t *single_flight,
+                                   bool                    enabled)
+{
+   BSON_ASSERT (single_flight);
+
+   mongoc_mutex_lock (&single_flight->mutex);
+   single_flight->enabled = enabled;
+   mongoc_mutex_unlock (&single_flight->mutex);
+}
+
+
+/* only reads whose whole result fits in one reply can be shared */
+static bool
+_is_coalescable (const bson_t *command)
+{
+   bson_iter_t iter;
+   const char *name;
+
+   if (!bson_iter_init (&iter, command) || !bson_iter_next (&iter)) {
+      return false;
+   }
+
+   name = bson_iter_key (&iter);
+
+   if (!strcmp (name, "count")) {
+      return true;
+   }
+
+   /* a tailable cursor is never exhausted in its first batch */
+   return !strcmp (name, "find") && !bson_has_field (command, "tailable");
+}
+
+
+/* a reply that opened a server cursor belongs to the leader alone: two
+ * threads can't iterate one cursor */
+static bool
+_is_shareable (const bson_t *reply)
+{
+   bson_iter_t iter;
+   bson_iter_t id;
+
+   if (bson_iter_init (&iter, reply) &&
+       bson_iter_find_descendant (&iter, "cursor.id", &id) &&
+       (BSON_ITER_HOLDS_INT32 (&id) || BSON_ITER_HOLDS_INT64 (&id))) {
+      return bson_iter_as_int64 (&id) == 0;
+   }
+
+   return true;
+}
+
+
+/* call with the mutex held */
+static mongoc_single_flight_call_t *
+_mongoc_single_flight_find (mongoc_single_flight_t *single_flight,
+                            uint32_t                server_id,
+                            mongoc_query_flags_t    flags,
+                            const char             *db_name,
+                            const bson_t           *command)
+{
+   mongoc_single_flight_call_t *call;
+
+   for (call = single_flight->calls; call; call = call->next) {
+      if (call->server_id == server_id &&
+          call->flags == flags &&
+          !strcmp (call->db_name, db_name) &&
+          bson_equal (call->command, command)) {
+         return call;
+      }
+   }
+
+   return NULL;
+}
+
+
+/* the number of threads waiting for in-flight calls to finish */
+uint32_t
+_mongoc_single_flight_waiters (mongoc_single_flight_t *single_flight)
+{
+   mongoc_single_flight_call_t *call;
+   uint32_t waiters = 0;
+
+   mongoc_mutex_lock (&single_flight->mutex);
+
+   for (call = single_flight->calls; call; call = call->next) {
+      waiters += call->refs - 1;
+   }
+
+   mongoc_mutex_unlock (&single_flight->mutex);
+
+   return waiters;
+}
+
+
+/* call with the mutex held */
+static void
+_mongoc_single_flight_release (mongoc_single_flight_call_t *call)
+{
+   if (--call->refs) {
+      return;
+   }
+
+   bson_destroy (&call->reply);
+   mongoc_cond_destroy (&call->cond);
+   bson_free (call);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_single_flight_run_command --
+ *
+ *       Run a command like mongoc_cluster_run_command_monitored. If
+ *       @single_flight is enabled and the command is a find or count
+ *       identical to one already in flight to the same server, wait for
+ *       that command's reply instead of sending another.
+ *
+ *       A find whose reply opens a server cursor isn't shared; the
+ *       threads that waited for it send their own.
+ *
+ *       A thread may join a command that was sent before its own last
+ *       write, so a coalesced read may not see that write.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *       The leader's command is monitored; a coalesced one is not, since
+ *       it never goes to the server.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_single_flight_run_command (mongoc_single_flight_t *single_flight,
+                                   mongoc_cluster_t       *cluster,
+                                   mongoc_server_stream_t *server_stream,
+                                   mongoc_query_flags_t    flags,
+                                   const char             *db_name,
+                                   const bson_t           *command,
+                                   bson_t                 *reply,
+                                   bson_error_t           *error)
+{
+   mongoc_single_flight_call_t *call;
+   mongoc_single_flight_call_t **link;
+   uint32_t server_id;
+   bool shared;
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (server_stream);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+
+   if (!single_flight || !_is_coalescable (command)) {
+      GOTO (send);
+   }
+
+   server_id = server_stream->sd->id;
+
+   mongoc_mutex_lock (&single_flight->mutex);
+
+   if (!single_flight->enabled) {
+      mongoc_mutex_unlock (&single_flight->mutex);
+      GOTO (send);
+   }
+
+   call = _mongoc_single_flight_find (single_flight, server_id, flags,
+                                      db_name, command);
+
+   if (call) {
+      /* join the call and wait for its leader's reply */
+      call->refs++;
+
+      while (!call->done) {
+         mongoc_cond_wait (&call->cond, &single_flight->mutex);
+      }
+
+      shared = call->shared;
+      ret = call->ret;
+
+      if (shared) {
+         bson_copy_to (&call->reply, reply);
+         if (!ret && error) {
+            memcpy (error, &call->error, sizeof *error);
+         }
+
+         mongoc_counter_read_coalescing_coalesced_inc ();
+      }
+
+      _mongoc_single_flight_release (call);
+      mongoc_mutex_unlock (&single_flight->mutex);
+
+      if (shared) {
+         RETURN (ret);
+      }
+
+      GOTO (send);
+   }
+
+   /* lead a new call */
+   call = (mongoc_single_flight_call_t *)bson_malloc0 (sizeof *call);
+   call->server_id = server_id;
+   call->flags = flags;
+   call->db_name = db_name;
+   call->command = command;
+   mongoc_cond_init (&call->cond);
+   bson_init (&call->reply);
+   call->refs = 1;
+   call->next = single_flight->calls;
+   single_flight->calls = call;
+
+   mongoc_mutex_unlock (&single_flight->mutex);
+
+   mongoc_counter_read_coalescing_leaders_inc ();
+
+   ret = mongoc_cluster_run_command_monitored (cluster, server_stream, flags,
+                                               db_name, command, reply,
+                                               &call->error);
+
+   mongoc_mutex_lock (&single_flight->mutex);
+
+   for (link = &single_flight->calls; *link; link = &(*link)->next) {
+      if (*link == call) {
+         *link = call->next;
+         break;
+      }
+   }
+
+   call->next = NULL;
+   call->command = NULL;
+   call->db_name = NULL;
+   call->done = true;
+   call->ret = ret;
+
+   /* copy the reply only if someone is waiting for it */
+   if (call->refs > 1 && _is_shareable (reply)) {
+      call->shared = true;
+      bson_destroy (&call->reply);
+      bson_copy_to (reply, &call->reply);
+   }
+
+   if (!ret && error) {
+      memcpy (error, &call->error, sizeof *error);
+   }
+
+   mongoc_cond_broadcast (&call->cond);
+   _mongoc_single_flight_release (call);
+   mongoc_mutex_unlock (&single_flight->mutex);
+
+   RETURN (ret);
+
+send:
+   RETURN (mongoc_cluster_run_command_monitored (cluster, server_stream, flags,
+                                                 db_name, command, reply,
+                                                 error));
+}
@@ -310,6 +310,30 @@ mongoc_socket_errno (mongoc_socket_t *sock) /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_socket_get_fd --
+ *
+ *       Returns the underlying file descriptor, for registering the socket
+ *       with an event loop. Do not read, write, or close it.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+#ifdef _WIN32
+SOCKET
+#else
+int
+#endif
+mongoc_socket_get_fd (mongoc_socket_t *sock) /* IN */
+{
+   BSON_ASSERT (sock);
+
+   return sock->sd;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -66,6 +66,11 @@ int              mongoc_socket_connect    (mongoc_socket_t       *sock,
 char            *mongoc_socket_getnameinfo(mongoc_socket_t       *sock);
 void             mongoc_socket_destroy    (mongoc_socket_t       *sock);
 int              mongoc_socket_errno      (mongoc_socket_t       *sock);
+#ifdef _WIN32
+SOCKET           mongoc_socket_get_fd     (mongoc_socket_t       *sock);
+#else
+int              mongoc_socket_get_fd     (mongoc_socket_t       *sock);
+#endif
 int              mongoc_socket_getsockname(mongoc_socket_t       *sock,
                                            struct sockaddr       *addr,
                                            socklen_t             *addrlen);
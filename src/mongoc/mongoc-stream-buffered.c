@@ -200,7 +200,8 @@ mongoc_stream_buffered_writev (mongoc_stream_t *stream,       /* IN */
  *
  *       When reading from the underlying stream, we read at least the
  *       requested number of bytes, but try to also fill the stream to
- *       the size of the underlying buffer.
+ *       the size of the underlying buffer. The buffer is a ring, so
+ *       bytes left over from a previous read are never moved.
  *
  * Note:
  *       This isn't actually a huge savings since we never have more than
@@ -237,11 +238,11 @@ mongoc_stream_buffered_readv (mongoc_stream_t *stream,       /* IN */
       total_bytes += iov[i].iov_len;
    }
 
-   if (-1 == _mongoc_buffer_fill (&buffered->buffer,
-                                  buffered->base_stream,
-                                  total_bytes,
-                                  timeout_msec,
-                                  &error)) {
+   if (-1 == _mongoc_buffer_ring_fill (&buffered->buffer,
+                                       buffered->base_stream,
+                                       total_bytes,
+                                       timeout_msec,
+                                       &error)) {
       MONGOC_WARNING ("Failure to buffer %u bytes: %s",
                       (unsigned)total_bytes,
                       error.message);
@@ -250,13 +251,7 @@ mongoc_stream_buffered_readv (mongoc_stream_t *stream,       /* IN */
 
    BSON_ASSERT (buffered->buffer.len >= total_bytes);
 
-   for (i = 0; i < iovcnt; i++) {
-      memcpy(iov[i].iov_base,
-             buffered->buffer.data + buffered->buffer.off,
-             iov[i].iov_len);
-      buffered->buffer.off += iov[i].iov_len;
-      buffered->buffer.len -= iov[i].iov_len;
-   }
+   _mongoc_buffer_ring_read (&buffered->buffer, iov, iovcnt);
 
    RETURN (total_bytes);
 }
@@ -322,7 +317,7 @@ mongoc_stream_buffered_new (mongoc_stream_t *base_stream, /* IN */
 
    stream->base_stream = base_stream;
 
-   _mongoc_buffer_init (&stream->buffer, NULL, buffer_size, NULL, NULL);
+   _mongoc_buffer_init_ring (&stream->buffer, buffer_size, NULL, NULL);
 
    mongoc_counter_streams_active_inc();
 
@@ -78,7 +78,7 @@ mongoc_thread_create (mongoc_thread_t *thread,
                       void            *arg)
 {
    *thread = CreateThread (NULL, 0, (LPTHREAD_START_ROUTINE) cb, arg, 0, NULL);
-   return 0;
+   return *thread ? 0 : 1;
 }
 # define mongoc_thread_join(_n)         WaitForSingleObject((_n), INFINITE)
 # define mongoc_mutex_t                 CRITICAL_SECTION
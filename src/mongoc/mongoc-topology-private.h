@@ -17,6 +17,7 @@
 #ifndef MONGOC_TOPOLOGY_PRIVATE_H
 #define MONGOC_TOPOLOGY_PRIVATE_H
 
+#include "mongoc-kill-cursors-queue-private.h"
 #include "mongoc-read-prefs-private.h"
 #include "mongoc-topology-scanner-private.h"
 #include "mongoc-server-description-private.h"
@@ -64,6 +65,8 @@ typedef struct _mongoc_topology_t
    bool                               shutdown_requested;
    bool                               single_threaded;
    bool                               stale;
+
+   mongoc_kill_cursors_queue_t        kill_cursors;
 } mongoc_topology_t;
 
 mongoc_topology_t *
@@ -85,6 +88,13 @@ mongoc_topology_select (mongoc_topology_t         *topology,
                         const mongoc_read_prefs_t *read_prefs,
                         bson_error_t              *error);
 
+bool
+mongoc_topology_select_all (mongoc_topology_t         *topology,
+                            mongoc_ss_optype_t         optype,
+                            const mongoc_read_prefs_t *read_prefs,
+                            mongoc_array_t            *sds,
+                            bson_error_t              *error);
+
 mongoc_server_description_t *
 mongoc_topology_server_by_id (mongoc_topology_t *topology,
                               uint32_t           id,
@@ -102,6 +112,14 @@ mongoc_topology_server_timestamp (mongoc_topology_t *topology,
 bool
 _mongoc_topology_start_background_scanner (mongoc_topology_t *topology);
 
+bool
+_mongoc_topology_scan_begin (mongoc_topology_t *topology);
+
+bool
+_mongoc_topology_scan_step (mongoc_topology_t          *topology,
+                            const mongoc_socket_poll_t *sds,
+                            size_t                      n_sds);
+
 bool
 _mongoc_topology_set_appname (mongoc_topology_t *topology,
                               const char        *appname);
@@ -127,6 +127,11 @@ bool
 mongoc_topology_scanner_work (mongoc_topology_scanner_t *ts,
                               int32_t                    timeout_msec);
 
+bool
+mongoc_topology_scanner_step (mongoc_topology_scanner_t  *ts,
+                              const mongoc_socket_poll_t *sds,
+                              size_t                      n_sds);
+
 void
 mongoc_topology_scanner_get_error (mongoc_topology_scanner_t *ts,
                                    bson_error_t              *error);
@@ -623,6 +623,7 @@ mongoc_topology_scanner_start (mongoc_topology_scanner_t *ts,
       return;
    }
 
+   ts->in_progress = true;
    memset (&ts->error, 0, sizeof (bson_error_t));
 
    if (obey_cooldown) {
@@ -713,6 +714,37 @@ mongoc_topology_scanner_work (mongoc_topology_scanner_t *ts,
    return r;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_topology_scanner_step --
+ *
+ *      Like mongoc_topology_scanner_work, but only advance the checks
+ *      whose sockets in @sds are ready, without blocking.
+ *
+ * Returns:
+ *      true if there is more work to do, false if scan is done.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_topology_scanner_step (mongoc_topology_scanner_t  *ts,
+                              const mongoc_socket_poll_t *sds,
+                              size_t                      n_sds)
+{
+   bool r;
+
+   r = mongoc_async_step (ts->async, sds, n_sds);
+
+   if (! r && ts->in_progress) {
+      ts->in_progress = false;
+      mongoc_topology_scanner_finish (ts);
+   }
+
+   return r;
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -233,6 +233,7 @@ mongoc_topology_new (const mongoc_uri_t *uri,
    mongoc_mutex_init (&topology->mutex);
    mongoc_cond_init (&topology->cond_client);
    mongoc_cond_init (&topology->cond_server);
+   _mongoc_kill_cursors_queue_init (&topology->kill_cursors);
 
    for ( hl = mongoc_uri_get_hosts (uri); hl; hl = hl->next) {
       mongoc_topology_description_add_server (&topology->description,
@@ -274,6 +275,7 @@ mongoc_topology_destroy (mongoc_topology_t *topology)
    mongoc_cond_destroy (&topology->cond_client);
    mongoc_cond_destroy (&topology->cond_server);
    mongoc_mutex_destroy (&topology->mutex);
+   _mongoc_kill_cursors_queue_destroy (&topology->kill_cursors);
 
    bson_free(topology);
 }
@@ -355,6 +357,74 @@ _mongoc_topology_do_blocking_scan (mongoc_topology_t *topology,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_scan_begin --
+ *
+ *       Start a single-threaded scan that the caller drives with
+ *       _mongoc_topology_scan_step, polling the scanner's sockets itself,
+ *       instead of blocking in server selection.
+ *
+ * Returns:
+ *       false if the topology is monitored by a background thread.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_topology_scan_begin (mongoc_topology_t *topology)
+{
+   if (!topology->single_threaded) {
+      return false;
+   }
+
+   topology->scanner_state = MONGOC_TOPOLOGY_SCANNER_SINGLE_THREADED;
+
+#ifdef MONGOC_EXPERIMENTAL_FEATURES
+   _mongoc_metadata_freeze ();
+#endif
+
+   mongoc_topology_scanner_start (topology->scanner,
+                                  (int32_t) topology->connect_timeout_msec,
+                                  true);
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_scan_step --
+ *
+ *       Advance a scan begun with _mongoc_topology_scan_begin on the
+ *       ready sockets in @sds, without blocking. Server selection may
+ *       finish the scan first, by blocking until it is done.
+ *
+ * Returns:
+ *       true if the scan is still in progress.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_topology_scan_step (mongoc_topology_t          *topology,
+                            const mongoc_socket_poll_t *sds,
+                            size_t                      n_sds)
+{
+   if (mongoc_topology_scanner_step (topology->scanner, sds, n_sds)) {
+      return true;
+   }
+
+   /* "retired" nodes can be checked again in the next scan */
+   mongoc_topology_scanner_reset (topology->scanner);
+   topology->last_scan = bson_get_monotonic_time ();
+   topology->stale = false;
+
+   return false;
+}
+
 bool
 mongoc_topology_compatible (const mongoc_topology_description_t *td,
                             const mongoc_read_prefs_t           *read_prefs,
@@ -630,6 +700,77 @@ mongoc_topology_select (mongoc_topology_t         *topology,
    }
 }
 
+/*
+ *-------------------------------------------------------------------------
+ *
+ * mongoc_topology_select_all --
+ *
+ *       Like mongoc_topology_select, but append a copy of every server
+ *       suitable for @optype and @read_prefs to @sds, an array of
+ *       mongoc_server_description_t pointers, not only those within the
+ *       latency window. Callers own and clean up the copies.
+ *
+ *       NOTE: this method locks and unlocks @topology's mutex.
+ *
+ * Returns:
+ *       true if any server was suitable, otherwise false and @error is set.
+ *
+ *-------------------------------------------------------------------------
+ */
+bool
+mongoc_topology_select_all (mongoc_topology_t         *topology,
+                            mongoc_ss_optype_t         optype,
+                            const mongoc_read_prefs_t *read_prefs,
+                            mongoc_array_t            *sds,
+                            bson_error_t              *error)
+{
+   mongoc_server_description_t *sd;
+   mongoc_array_t suitable;
+   size_t i;
+
+   BSON_ASSERT (topology);
+   BSON_ASSERT (read_prefs);
+   BSON_ASSERT (sds);
+
+   /* wait, and scan if need be, until some server is suitable */
+   sd = mongoc_topology_select (topology, optype, read_prefs, error);
+   if (!sd) {
+      return false;
+   }
+
+   mongoc_server_description_destroy (sd);
+
+   _mongoc_array_init (&suitable, sizeof (mongoc_server_description_t *));
+
+   mongoc_mutex_lock (&topology->mutex);
+
+   /* no latency window */
+   mongoc_topology_description_suitable_servers (&suitable, optype,
+                                                 &topology->description,
+                                                 read_prefs, INT32_MAX,
+                                                 topology->heartbeat_msec);
+
+   for (i = 0; i < suitable.len; i++) {
+      sd = mongoc_server_description_new_copy (
+         _mongoc_array_index (&suitable, mongoc_server_description_t *, i));
+      _mongoc_array_append_val (sds, sd);
+   }
+
+   mongoc_mutex_unlock (&topology->mutex);
+
+   _mongoc_array_destroy (&suitable);
+
+   if (!sds->len) {
+      /* the topology changed since selection */
+      bson_set_error (error, MONGOC_ERROR_SERVER_SELECTION,
+                      MONGOC_ERROR_SERVER_SELECTION_FAILURE,
+                      "No suitable servers found");
+      return false;
+   }
+
+   return true;
+}
+
 /*
  *-------------------------------------------------------------------------
  *
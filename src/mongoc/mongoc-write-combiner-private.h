@@ -0,0 +1,83 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef MONGOC_WRITE_COMBINER_PRIVATE_H
+#define MONGOC_WRITE_COMBINER_PRIVATE_H
+
+#if !defined (MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-collection.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-write-command-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+/* the most inserts one combined command carries */
+#define MONGOC_WRITE_COMBINER_MAX_DOCUMENTS 1000
+
+
+typedef struct _mongoc_write_combiner_t       mongoc_write_combiner_t;
+typedef struct _mongoc_write_combiner_group_t mongoc_write_combiner_group_t;
+
+
+/* inserts into one namespace with one write concern, sent as one command */
+struct _mongoc_write_combiner_group_t
+{
+   char                          *db;
+   char                          *collection;
+   mongoc_write_concern_t        *write_concern;
+   mongoc_write_command_t         command;
+   mongoc_write_result_t          result;
+   mongoc_cond_t                  cond;
+   bool                           closed;
+   bool                           done;
+   uint32_t                       refs;
+   mongoc_write_combiner_group_t *next;
+};
+
+
+struct _mongoc_write_combiner_t
+{
+   mongoc_mutex_t                 mutex;
+   int64_t                        window_usec;
+   /* groups still accepting inserts */
+   mongoc_write_combiner_group_t *open;
+};
+
+
+mongoc_write_combiner_t *_mongoc_write_combiner_new        (void);
+void                     _mongoc_write_combiner_destroy    (mongoc_write_combiner_t      *combiner);
+void                     _mongoc_write_combiner_set_window (mongoc_write_combiner_t      *combiner,
+                                                            int32_t                       window_usec);
+bool                     _mongoc_write_combiner_insert     (mongoc_write_combiner_t      *combiner,
+                                                            mongoc_collection_t          *collection,
+                                                            const bson_t                 *document,
+                                                            const mongoc_write_concern_t *write_concern,
+                                                            mongoc_write_result_t        *result);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_WRITE_COMBINER_PRIVATE_H */
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2016 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "mongoc-client-private.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-trace.h"
+#include "mongoc-util-private.h"
+#include "mongoc-write-combiner-private.h"
+#include "mongoc-write-concern-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "write-combiner"
+
+
+/*
+ * The write combiner is group commit for single-document inserts. The first
+ * thread to insert into a namespace with a given write concern opens a
+ * group and becomes its leader; threads that insert with the same namespace
+ * and write concern within the combining window append their documents to
+ * the group and wait. Then the leader closes the group, sends one unordered
+ * insert command on its own client, and wakes the others, who each take
+ * their own outcome from the combined result.
+ */
+
+
+mongoc_write_combiner_t *
+_mongoc_write_combiner_new (void)
+{
+   mongoc_write_combiner_t *combiner;
+
+   combiner = (mongoc_write_combiner_t *)bson_malloc0 (sizeof *combiner);
+   mongoc_mutex_init (&combiner->mutex);
+
+   return combiner;
+}
+
+
+void
+_mongoc_write_combiner_destroy (mongoc_write_combiner_t *combiner)
+{
+   if (combiner) {
+      /* every group's leader and members have returned by now */
+      BSON_ASSERT (!combiner->open);
+      mongoc_mutex_destroy (&combiner->mutex);
+      bson_free (combiner);
+   }
+}
+
+
+void
+_mongoc_write_combiner_set_window (mongoc_write_combiner_t *combiner,
+                                   int32_t                  window_usec)
+{
+   BSON_ASSERT (combiner);
+
+   mongoc_mutex_lock (&combiner->mutex);
+   combiner->window_usec = BSON_MAX (window_usec, 0);
+   mongoc_mutex_unlock (&combiner->mutex);
+}
+
+
+static bool
+_write_concern_equal (const mongoc_write_concern_t *a,
+                      const mongoc_write_concern_t *b)
+{
+   return a->fsync_ == b->fsync_ &&
+          a->journal == b->journal &&
+          a->w == b->w &&
+          a->wtimeout == b->wtimeout &&
+          ((!a->wtag && !b->wtag) ||
+           (a->wtag && b->wtag && !strcmp (a->wtag, b->wtag)));
+}
+
+
+/* call with the mutex held */
+static mongoc_write_combiner_group_t *
+_mongoc_write_combiner_find (mongoc_write_combiner_t      *combiner,
+                             const mongoc_collection_t    *collection,
+                             const mongoc_write_concern_t *write_concern)
+{
+   mongoc_write_combiner_group_t *group;
+
+   for (group = combiner->open; group; group = group->next) {
+      if (!strcmp (group->db, collection->db) &&
+          !strcmp (group->collection, collection->collection) &&
+          _write_concern_equal (group->write_concern, write_concern)) {
+         return group;
+      }
+   }
+
+   return NULL;
+}
+
+
+/* call with the mutex held */
+static void
+_mongoc_write_combiner_close (mongoc_write_combiner_t       *combiner,
+                              mongoc_write_combiner_group_t *group)
+{
+   mongoc_write_combiner_group_t **link;
+
+   if (group->closed) {
+      return;
+   }
+
+   for (link = &combiner->open; *link; link = &(*link)->next) {
+      if (*link == group) {
+         *link = group->next;
+         break;
+      }
+   }
+
+   group->next = NULL;
+   group->closed = true;
+}
+
+
+/* call with the mutex held */
+static void
+_mongoc_write_combiner_release (mongoc_write_combiner_group_t *group)
+{
+   if (--group->refs) {
+      return;
+   }
+
+   bson_free (group->db);
+   bson_free (group->collection);
+   mongoc_write_concern_destroy (group->write_concern);
+   _mongoc_write_command_destroy (&group->command);
+   _mongoc_write_result_destroy (&group->result);
+   mongoc_cond_destroy (&group->cond);
+   bson_free (group);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_combiner_insert --
+ *
+ *       Insert @document into @collection, combined with concurrent
+ *       inserts into the same namespace with the same write concern.
+ *
+ * Returns:
+ *       false if combining is disabled, or @write_concern is
+ *       unacknowledged, and the caller must insert the document itself.
+ *       Otherwise true, and @result holds this insert's own outcome:
+ *       its write error if it had one, and any write concern errors.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_write_combiner_insert (mongoc_write_combiner_t      *combiner,
+                               mongoc_collection_t          *collection,
+                               const bson_t                 *document,
+                               const mongoc_write_concern_t *write_concern,
+                               mongoc_write_result_t        *result)
+{
+   mongoc_bulk_write_flags_t write_flags = MONGOC_BULK_WRITE_FLAGS_INIT;
+   mongoc_write_combiner_group_t *group;
+   int64_t deadline;
+   int64_t remaining_usec;
+   uint32_t index;
+
+   ENTRY;
+
+   BSON_ASSERT (combiner);
+   BSON_ASSERT (collection);
+   BSON_ASSERT (document);
+   BSON_ASSERT (write_concern);
+   BSON_ASSERT (result);
+
+   if (!mongoc_write_concern_is_acknowledged (write_concern)) {
+      RETURN (false);
+   }
+
+   mongoc_mutex_lock (&combiner->mutex);
+
+   if (!combiner->window_usec) {
+      mongoc_mutex_unlock (&combiner->mutex);
+      RETURN (false);
+   }
+
+   group = _mongoc_write_combiner_find (combiner, collection, write_concern);
+
+   if (group) {
+      /* join the group and wait for its leader to send it */
+      index = group->command.n_documents;
+      _mongoc_write_command_insert_append (&group->command, document);
+      group->refs++;
+
+      if (group->command.n_documents >= MONGOC_WRITE_COMBINER_MAX_DOCUMENTS) {
+         _mongoc_write_combiner_close (combiner, group);
+         mongoc_cond_broadcast (&group->cond);
+      }
+
+      while (!group->done) {
+         mongoc_cond_wait (&group->cond, &combiner->mutex);
+      }
+
+      _mongoc_write_result_split_insert (&group->result, index, result);
+      _mongoc_write_combiner_release (group);
+      mongoc_mutex_unlock (&combiner->mutex);
+
+      RETURN (true);
+   }
+
+   /* open a group and lead it */
+   write_flags.ordered = false;
+   group = (mongoc_write_combiner_group_t *)bson_malloc0 (sizeof *group);
+   group->db = bson_strdup (collection->db);
+   group->collection = bson_strdup (collection->collection);
+   group->write_concern = mongoc_write_concern_copy (write_concern);
+   _mongoc_write_command_init_insert (
+      &group->command, document, write_flags,
+      ++collection->client->cluster.operation_id, false);
+   _mongoc_write_result_init (&group->result);
+   mongoc_cond_init (&group->cond);
+   group->refs = 1;
+   group->next = combiner->open;
+   combiner->open = group;
+
+   deadline = bson_get_monotonic_time () + combiner->window_usec;
+
+   while (!group->closed) {
+      remaining_usec = deadline - bson_get_monotonic_time ();
+      if (remaining_usec <= 0) {
+         break;
+      }
+
+      if (remaining_usec >= 1000) {
+         mongoc_cond_timedwait (&group->cond, &combiner->mutex,
+                                remaining_usec / 1000);
+      } else {
+         /* the timed wait counts whole milliseconds: sleep out the rest
+          * of the window unlocked, our reference keeps the group alive */
+         mongoc_mutex_unlock (&combiner->mutex);
+         _mongoc_usleep (remaining_usec);
+         mongoc_mutex_lock (&combiner->mutex);
+      }
+   }
+
+   _mongoc_write_combiner_close (combiner, group);
+   mongoc_mutex_unlock (&combiner->mutex);
+
+   /* the group is closed, no one else touches the command */
+   _mongoc_collection_write_command_execute (&group->command, collection,
+                                             group->write_concern,
+                                             &group->result);
+
+   mongoc_mutex_lock (&combiner->mutex);
+   group->done = true;
+   mongoc_cond_broadcast (&group->cond);
+   _mongoc_write_result_split_insert (&group->result, 0, result);
+   _mongoc_write_combiner_release (group);
+   mongoc_mutex_unlock (&combiner->mutex);
+
+   RETURN (true);
+}
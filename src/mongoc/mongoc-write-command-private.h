@@ -23,6 +23,7 @@
 
 #include <bson.h>
 
+#include "mongoc-array-private.h"
 #include "mongoc-client.h"
 #include "mongoc-error.h"
 #include "mongoc-write-concern.h"
@@ -70,6 +71,16 @@ typedef struct
 } mongoc_write_command_t;
 
 
+typedef struct
+{
+   /* added to the "index" of each writeErrors and upserted element */
+   uint32_t     offset;
+   /* the parts of one reply to merge, each optional, like:
+    * {writeErrors: [...], upserted: [...], writeConcernError: {...}} */
+   bson_t      *reply;
+} mongoc_write_result_reply_t;
+
+
 typedef struct
 {
    /* true after a legacy update prevents us from calculating nModified */
@@ -79,16 +90,15 @@ typedef struct
    uint32_t     nModified;
    uint32_t     nRemoved;
    uint32_t     nUpserted;
-   /* like [{"index": int, "_id": value}, ...] */
-   bson_t       writeErrors;
-   /* like [{"index": int, "code": int, "errmsg": str}, ...] */
-   bson_t       upserted;
-   /* like [{"code": 64, "errmsg": "duplicate"}, ...] */
+   /* mongoc_write_result_reply_t for each reply with write errors, upserts
+    * or a write concern error. the writeErrors, upserted and
+    * writeConcernErrors arrays are only built from them once, by
+    * _mongoc_write_result_complete */
+   mongoc_array_t replies;
+   uint32_t     n_writeErrors;
    uint32_t     n_writeConcernErrors;
-   bson_t       writeConcernErrors;
    bool         failed;
    bson_error_t error;
-   uint32_t     upsert_append_count;
 } mongoc_write_result_t;
 
 
@@ -112,6 +122,10 @@ void _mongoc_write_command_init_update (mongoc_write_command_t        *command,
                                         int64_t                        operation_id);
 void _mongoc_write_command_insert_append (mongoc_write_command_t      *command,
                                           const bson_t                *document);
+void _mongoc_write_command_insert_append_begin (mongoc_write_command_t *command,
+                                                bson_t                 *document);
+void _mongoc_write_command_insert_append_end   (mongoc_write_command_t *command,
+                                                bson_t                 *document);
 void _mongoc_write_command_update_append (mongoc_write_command_t      *command,
                                           const bson_t                *selector,
                                           const bson_t                *update,
@@ -134,6 +148,11 @@ void _mongoc_write_result_merge        (mongoc_write_result_t         *result,
                                         mongoc_write_command_t        *command,
                                         const bson_t                  *reply,
                                         uint32_t                       offset);
+void _mongoc_write_result_merge_result (mongoc_write_result_t         *result,
+                                        const mongoc_write_result_t   *batch);
+void _mongoc_write_result_split_insert (const mongoc_write_result_t   *combined,
+                                        uint32_t                       index,
+                                        mongoc_write_result_t         *result);
 void _mongoc_write_result_merge_legacy (mongoc_write_result_t         *result,
                                         mongoc_write_command_t        *command,
                                         const bson_t                  *reply,
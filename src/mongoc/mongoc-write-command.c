@@ -53,12 +53,6 @@ static const char *gCommandNames[] = { "delete", "insert", "update"};
 static const char *gCommandFields[] = { "deletes", "documents", "updates"};
 static const uint32_t gCommandFieldLens[] = { 7, 9, 7 };
 
-static int32_t
-_mongoc_write_result_merge_arrays (uint32_t               offset,
-                                   mongoc_write_result_t *result,
-                                   bson_t                *dest,
-                                   bson_iter_t           *iter);
-
 void
 _mongoc_write_command_insert_append (mongoc_write_command_t *command,
                                      const bson_t           *document)
@@ -102,6 +96,60 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
    EXIT;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_command_insert_append_begin --
+ *
+ *       Begin a document to insert, built in place in the command's
+ *       documents instead of copied from another bson_t. The caller must
+ *       append an "_id" first, then finish with
+ *       _mongoc_write_command_insert_append_end.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_write_command_insert_append_begin (mongoc_write_command_t *command,
+                                           bson_t                 *document)
+{
+   const char *key;
+   char keydata [16];
+
+   ENTRY;
+
+   BSON_ASSERT (command);
+   BSON_ASSERT (command->type == MONGOC_WRITE_COMMAND_INSERT);
+   BSON_ASSERT (document);
+
+   key = NULL;
+   bson_uint32_to_string (command->n_documents,
+                          &key, keydata, sizeof keydata);
+
+   BSON_ASSERT (key);
+
+   bson_append_document_begin (command->documents, key, -1, document);
+
+   EXIT;
+}
+
+
+void
+_mongoc_write_command_insert_append_end (mongoc_write_command_t *command,
+                                         bson_t                 *document)
+{
+   ENTRY;
+
+   BSON_ASSERT (command);
+   BSON_ASSERT (document);
+
+   bson_append_document_end (command->documents, document);
+   command->n_documents++;
+
+   EXIT;
+}
+
+
 void
 _mongoc_write_command_update_append (mongoc_write_command_t *command,
                                      const bson_t           *selector,
@@ -1399,9 +1447,7 @@ _mongoc_write_result_init (mongoc_write_result_t *result) /* IN */
 
    memset (result, 0, sizeof *result);
 
-   bson_init (&result->upserted);
-   bson_init (&result->writeConcernErrors);
-   bson_init (&result->writeErrors);
+   _mongoc_array_init (&result->replies, sizeof (mongoc_write_result_reply_t));
 
    EXIT;
 }
@@ -1410,40 +1456,108 @@ _mongoc_write_result_init (mongoc_write_result_t *result) /* IN */
 void
 _mongoc_write_result_destroy (mongoc_write_result_t *result)
 {
+   mongoc_write_result_reply_t *r;
+   size_t i;
+
    ENTRY;
 
    BSON_ASSERT (result);
 
-   bson_destroy (&result->upserted);
-   bson_destroy (&result->writeConcernErrors);
-   bson_destroy (&result->writeErrors);
+   for (i = 0; i < result->replies.len; i++) {
+      r = &_mongoc_array_index (&result->replies,
+                                mongoc_write_result_reply_t, i);
+      bson_destroy (r->reply);
+   }
+
+   _mongoc_array_destroy (&result->replies);
 
    EXIT;
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_result_append_reply --
+ *
+ *       Keep the writeErrors, upserted and writeConcernError fields of
+ *       @reply, if it has any, to be built into the final result by
+ *       _mongoc_write_result_complete. Replies without them, the common
+ *       case, cost nothing.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_result_append_reply (mongoc_write_result_t *result,
+                                   uint32_t               offset,
+                                   const bson_t          *reply)
+{
+   mongoc_write_result_reply_t r;
+   bson_iter_t iter;
+   bson_iter_t citer;
+   bson_t *compact = NULL;
+   bool ok;
+
+   ok = bson_iter_init (&iter, reply);
+   BSON_ASSERT (ok);
+
+   while (bson_iter_next (&iter)) {
+      if (BSON_ITER_IS_KEY (&iter, "writeConcernError") &&
+          BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+         result->n_writeConcernErrors++;
+      } else if ((BSON_ITER_IS_KEY (&iter, "writeErrors") ||
+                  BSON_ITER_IS_KEY (&iter, "upserted")) &&
+                 BSON_ITER_HOLDS_ARRAY (&iter) &&
+                 bson_iter_recurse (&iter, &citer) &&
+                 bson_iter_next (&citer)) {
+         if (BSON_ITER_IS_KEY (&iter, "writeErrors")) {
+            do {
+               result->n_writeErrors++;
+            } while (bson_iter_next (&citer));
+         }
+      } else {
+         continue;
+      }
+
+      if (!compact) {
+         compact = bson_new ();
+      }
+
+      bson_append_iter (compact, NULL, 0, &iter);
+   }
+
+   if (compact) {
+      r.offset = offset;
+      r.reply = compact;
+      _mongoc_array_append_val (&result->replies, r);
+   }
+}
+
+
 static void
 _mongoc_write_result_append_upsert (mongoc_write_result_t *result,
                                     int32_t                idx,
                                     const bson_value_t    *value)
 {
+   bson_t holder;
+   bson_t ar;
    bson_t child;
-   const char *keyptr = NULL;
-   char key[12];
-   int len;
 
    BSON_ASSERT (result);
    BSON_ASSERT (value);
 
-   len = (int)bson_uint32_to_string (result->upsert_append_count, &keyptr, key,
-                                     sizeof key);
-
-   bson_append_document_begin (&result->upserted, keyptr, len, &child);
-   BSON_APPEND_INT32 (&child, "index", idx);
+   bson_init (&holder);
+   bson_append_array_begin (&holder, "upserted", 8, &ar);
+   bson_append_document_begin (&ar, "0", 1, &child);
+   BSON_APPEND_INT32 (&child, "index", 0);
    BSON_APPEND_VALUE (&child, "_id", value);
-   bson_append_document_end (&result->upserted, &child);
+   bson_append_document_end (&ar, &child);
+   bson_append_array_end (&holder, &ar);
+
+   _mongoc_write_result_append_reply (result, (uint32_t) idx, &holder);
 
-   result->upsert_append_count++;
+   bson_destroy (&holder);
 }
 
 
@@ -1452,24 +1566,21 @@ _append_write_concern_err_legacy (mongoc_write_result_t *result,
                                   const char            *err,
                                   int32_t                code)
 {
-   char str[16];
-   const char *key;
-   size_t keylen;
+   bson_t holder;
    bson_t write_concern_error;
 
    /* don't set result->failed; record the write concern err and continue */
-   keylen = bson_uint32_to_string (result->n_writeConcernErrors, &key,
-                                   str, sizeof str);
-
-   BSON_ASSERT (keylen < INT_MAX);
-
-   bson_append_document_begin (&result->writeConcernErrors, key, (int) keylen,
+   bson_init (&holder);
+   bson_append_document_begin (&holder, "writeConcernError", 17,
                                &write_concern_error);
 
    bson_append_int32 (&write_concern_error, "code", 4, code);
    bson_append_utf8 (&write_concern_error, "errmsg", 6, err, -1);
-   bson_append_document_end (&result->writeConcernErrors, &write_concern_error);
-   result->n_writeConcernErrors++;
+   bson_append_document_end (&holder, &write_concern_error);
+
+   _mongoc_write_result_append_reply (result, 0, &holder);
+
+   bson_destroy (&holder);
 }
 
 
@@ -1481,7 +1592,6 @@ _append_write_err_legacy (mongoc_write_result_t *result,
                           uint32_t               offset)
 {
    bson_t holder, write_errors, child;
-   bson_iter_t iter;
 
    BSON_ASSERT (code > 0);
 
@@ -1491,20 +1601,18 @@ _append_write_err_legacy (mongoc_write_result_t *result,
    result->failed = true;
 
    bson_init (&holder);
-   bson_append_array_begin (&holder, "0", 1, &write_errors);
+   bson_append_array_begin (&holder, "writeErrors", 11, &write_errors);
    bson_append_document_begin (&write_errors, "0", 1, &child);
 
-   /* set error's "index" to 0; fixed up in _mongoc_write_result_merge_arrays */
+   /* set error's "index" to 0; offset is added in
+    * _mongoc_write_result_complete */
    bson_append_int32 (&child, "index", 5, 0);
    bson_append_int32 (&child, "code", 4, code);
    bson_append_utf8 (&child, "errmsg", 6, err, -1);
    bson_append_document_end (&write_errors, &child);
    bson_append_array_end (&holder, &write_errors);
-   bson_iter_init (&iter, &holder);
-   bson_iter_next (&iter);
 
-   _mongoc_write_result_merge_arrays (offset, result,
-                                      &result->writeErrors, &iter);
+   _mongoc_write_result_append_reply (result, offset, &holder);
 
    bson_destroy (&holder);
 }
@@ -1624,37 +1732,39 @@ _mongoc_write_result_merge_legacy (mongoc_write_result_t  *result,  /* IN */
 }
 
 
-static int32_t
-_mongoc_write_result_merge_arrays (uint32_t               offset,
-                                   mongoc_write_result_t *result, /* IN */
-                                   bson_t                *dest,   /* IN */
-                                   bson_iter_t           *iter)   /* IN */
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_result_append_array --
+ *
+ *       Append the documents in the array at @iter to @dest, numbering
+ *       them from *@n and adding @offset to their "index" fields.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_result_append_array (bson_t            *dest,   /* IN */
+                                   uint32_t          *n,      /* INOUT */
+                                   uint32_t           offset, /* IN */
+                                   const bson_iter_t *iter)   /* IN */
 {
    const bson_value_t *value;
    bson_iter_t ar;
    bson_iter_t citer;
    int32_t idx;
-   int32_t count = 0;
-   int32_t aridx;
    bson_t child;
    const char *keyptr = NULL;
    char key[12];
    int len;
 
-   ENTRY;
-
-   BSON_ASSERT (result);
-   BSON_ASSERT (dest);
-   BSON_ASSERT (iter);
    BSON_ASSERT (BSON_ITER_HOLDS_ARRAY (iter));
 
-   aridx = bson_count_keys (dest);
-
    if (bson_iter_recurse (iter, &ar)) {
       while (bson_iter_next (&ar)) {
          if (BSON_ITER_HOLDS_DOCUMENT (&ar) &&
              bson_iter_recurse (&ar, &citer)) {
-            len = (int)bson_uint32_to_string (aridx++, &keyptr, key,
+            len = (int)bson_uint32_to_string ((*n)++, &keyptr, key,
                                               sizeof key);
             bson_append_document_begin (dest, keyptr, len, &child);
             while (bson_iter_next (&citer)) {
@@ -1667,12 +1777,62 @@ _mongoc_write_result_merge_arrays (uint32_t               offset,
                }
             }
             bson_append_document_end (dest, &child);
-            count++;
          }
       }
    }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_result_build_arrays --
+ *
+ *       Build the writeErrors, upserted and writeConcernErrors arrays of
+ *       the final result from the replies kept by
+ *       _mongoc_write_result_append_reply, in one pass.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_result_build_arrays (const mongoc_write_result_t *result,
+                                   bson_t *write_errors,         /* OUT */
+                                   bson_t *upserted,             /* OUT */
+                                   bson_t *write_concern_errors) /* OUT */
+{
+   mongoc_write_result_reply_t *r;
+   bson_iter_t iter;
+   uint32_t n_write_errors = 0;
+   uint32_t n_upserted = 0;
+   uint32_t n_write_concern_errors = 0;
+   const char *keyptr = NULL;
+   char key[12];
+   int len;
+   size_t i;
+   bool ok;
+
+   for (i = 0; i < result->replies.len; i++) {
+      r = &_mongoc_array_index (&result->replies,
+                                mongoc_write_result_reply_t, i);
+
+      ok = bson_iter_init (&iter, r->reply);
+      BSON_ASSERT (ok);
 
-   RETURN (count);
+      while (bson_iter_next (&iter)) {
+         if (BSON_ITER_IS_KEY (&iter, "writeErrors")) {
+            _mongoc_write_result_append_array (write_errors, &n_write_errors,
+                                               r->offset, &iter);
+         } else if (BSON_ITER_IS_KEY (&iter, "upserted")) {
+            _mongoc_write_result_append_array (upserted, &n_upserted,
+                                               r->offset, &iter);
+         } else if (BSON_ITER_IS_KEY (&iter, "writeConcernError")) {
+            len = (int)bson_uint32_to_string (n_write_concern_errors++,
+                                              &keyptr, key, sizeof key);
+            bson_append_iter (write_concern_errors, keyptr, len, &iter);
+         }
+      }
+   }
 }
 
 
@@ -1682,8 +1842,6 @@ _mongoc_write_result_merge (mongoc_write_result_t  *result,  /* IN */
                             const bson_t           *reply,   /* IN */
                             uint32_t                offset)
 {
-   int32_t server_index = 0;
-   const bson_value_t *value;
    bson_iter_t iter;
    bson_iter_t citer;
    bson_iter_t ar;
@@ -1726,17 +1884,10 @@ _mongoc_write_result_merge (mongoc_write_result_t  *result,  /* IN */
                if (BSON_ITER_HOLDS_DOCUMENT (&ar) &&
                    bson_iter_recurse (&ar, &citer) &&
                    bson_iter_find (&citer, "index") &&
-                   BSON_ITER_HOLDS_INT32 (&citer)) {
-                  server_index = bson_iter_int32 (&citer);
-
-                  if (bson_iter_recurse (&ar, &citer) &&
-                      bson_iter_find (&citer, "_id")) {
-                     value = bson_iter_value (&citer);
-                     _mongoc_write_result_append_upsert (result,
-                                                         offset + server_index,
-                                                         value);
-                     n_upserted++;
-                  }
+                   BSON_ITER_HOLDS_INT32 (&citer) &&
+                   bson_iter_recurse (&ar, &citer) &&
+                   bson_iter_find (&citer, "_id")) {
+                  n_upserted++;
                }
             }
          }
@@ -1770,33 +1921,156 @@ _mongoc_write_result_merge (mongoc_write_result_t  *result,  /* IN */
       break;
    }
 
-   if (bson_iter_init_find (&iter, reply, "writeErrors") &&
-       BSON_ITER_HOLDS_ARRAY (&iter)) {
-      _mongoc_write_result_merge_arrays (offset, result, &result->writeErrors,
-                                         &iter);
+   /* writeErrors, upserted and writeConcernError are built into the final
+    * result's arrays by _mongoc_write_result_complete */
+   _mongoc_write_result_append_reply (result, offset, reply);
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_result_merge_result --
+ *
+ *       Fold the result of one independently executed batch into @result.
+ *       The batch must have been executed with its offset into the bulk
+ *       operation, so the offsets of its kept replies are already correct
+ *       and are copied unchanged.
+ *
+ *       Batches must be merged in order of their offsets so that the
+ *       error recorded in @result is the one with the lowest index.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_write_result_merge_result (mongoc_write_result_t       *result, /* IN */
+                                   const mongoc_write_result_t *batch)  /* IN */
+{
+   mongoc_write_result_reply_t r;
+   size_t i;
+
+   ENTRY;
+
+   BSON_ASSERT (result);
+   BSON_ASSERT (batch);
+
+   result->omit_nModified |= batch->omit_nModified;
+   result->nInserted += batch->nInserted;
+   result->nMatched += batch->nMatched;
+   result->nModified += batch->nModified;
+   result->nRemoved += batch->nRemoved;
+   result->nUpserted += batch->nUpserted;
+   result->n_writeErrors += batch->n_writeErrors;
+   result->n_writeConcernErrors += batch->n_writeConcernErrors;
+
+   result->failed |= batch->failed;
+
+   if (batch->error.code && !result->error.code) {
+      memcpy (&result->error, &batch->error, sizeof (bson_error_t));
    }
 
-   if (bson_iter_init_find (&iter, reply, "writeConcernError") &&
-       BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+   for (i = 0; i < batch->replies.len; i++) {
+      r = _mongoc_array_index (&batch->replies,
+                               mongoc_write_result_reply_t, i);
+      r.reply = bson_copy (r.reply);
+      _mongoc_array_append_val (&result->replies, r);
+   }
 
-      uint32_t len;
-      const uint8_t *data;
-      bson_t write_concern_error;
-      char str[16];
-      const char *key;
+   EXIT;
+}
 
-      /* writeConcernError is a subdocument in the server response
-       * append it to the result->writeConcernErrors array */
-      bson_iter_document (&iter, &len, &data);
-      bson_init_static (&write_concern_error, data, len);
 
-      bson_uint32_to_string (result->n_writeConcernErrors, &key,
-                             str, sizeof str);
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_result_split_insert --
+ *
+ *       Fill out @result with the outcome of the document at @index in a
+ *       combined unordered insert: its write error, if any, with "index"
+ *       0, else the command's error if the command failed, else
+ *       nInserted 1. Write concern errors apply to every document.
+ *
+ *--------------------------------------------------------------------------
+ */
 
-      bson_append_document (&result->writeConcernErrors,
-                            key, -1, &write_concern_error);
+void
+_mongoc_write_result_split_insert (const mongoc_write_result_t *combined, /* IN */
+                                   uint32_t                     index,    /* IN */
+                                   mongoc_write_result_t       *result)   /* OUT */
+{
+   mongoc_write_result_reply_t *r;
+   bson_iter_t iter;
+   bson_iter_t ar;
+   bson_iter_t citer;
+   bson_t holder;
+   bson_t write_errors;
+   bson_t err;
+   bool found = false;
+   size_t i;
+
+   ENTRY;
 
-      result->n_writeConcernErrors++;
+   BSON_ASSERT (combined);
+   BSON_ASSERT (result);
+
+   for (i = 0; i < combined->replies.len; i++) {
+      r = &_mongoc_array_index (&combined->replies,
+                                mongoc_write_result_reply_t, i);
+
+      if (!found && combined->n_writeErrors &&
+          bson_iter_init_find (&iter, r->reply, "writeErrors") &&
+          bson_iter_recurse (&iter, &ar)) {
+         while (!found && bson_iter_next (&ar)) {
+            if (BSON_ITER_HOLDS_DOCUMENT (&ar) &&
+                bson_iter_recurse (&ar, &citer) &&
+                bson_iter_find (&citer, "index") &&
+                BSON_ITER_HOLDS_INT32 (&citer) &&
+                (uint32_t) bson_iter_int32 (&citer) + r->offset == index) {
+               found = true;
+            }
+         }
+
+         if (found) {
+            /* copy the error as the first in result, with "index" 0 */
+            bson_init (&holder);
+            bson_append_array_begin (&holder, "writeErrors", 11,
+                                     &write_errors);
+            bson_append_document_begin (&write_errors, "0", 1, &err);
+            bson_iter_recurse (&ar, &citer);
+            while (bson_iter_next (&citer)) {
+               if (BSON_ITER_IS_KEY (&citer, "index")) {
+                  BSON_APPEND_INT32 (&err, "index", 0);
+               } else {
+                  BSON_APPEND_VALUE (&err, bson_iter_key (&citer),
+                                     bson_iter_value (&citer));
+               }
+            }
+            bson_append_document_end (&write_errors, &err);
+            bson_append_array_end (&holder, &write_errors);
+            _mongoc_write_result_append_reply (result, 0, &holder);
+            bson_destroy (&holder);
+         }
+      }
+
+      if (bson_iter_init_find (&iter, r->reply, "writeConcernError")) {
+         bson_init (&holder);
+         bson_append_iter (&holder, NULL, 0, &iter);
+         _mongoc_write_result_append_reply (result, 0, &holder);
+         bson_destroy (&holder);
+      }
+   }
+
+   if (found) {
+      result->failed = true;
+   } else if (combined->error.code) {
+      /* the command failed, this document's outcome is unknown */
+      memcpy (&result->error, &combined->error, sizeof (bson_error_t));
+      result->failed = true;
+   } else {
+      result->nInserted = 1;
    }
 
    EXIT;
@@ -1882,6 +2156,10 @@ _mongoc_write_result_complete (mongoc_write_result_t        *result,
                                bson_error_t                 *error)             /* OUT */
 {
    mongoc_error_domain_t domain;
+   bson_t write_errors = BSON_INITIALIZER;
+   bson_t upserted = BSON_INITIALIZER;
+   bson_t write_concern_errors = BSON_INITIALIZER;
+   bool ret;
 
    ENTRY;
 
@@ -1891,6 +2169,9 @@ _mongoc_write_result_complete (mongoc_write_result_t        *result,
             ? MONGOC_ERROR_SERVER
             : MONGOC_ERROR_COMMAND;
 
+   _mongoc_write_result_build_arrays (result, &write_errors, &upserted,
+                                      &write_concern_errors);
+
    if (bson && mongoc_write_concern_is_acknowledged (wc)) {
       BSON_APPEND_INT32 (bson, "nInserted", result->nInserted);
       BSON_APPEND_INT32 (bson, "nMatched", result->nMatched);
@@ -1899,24 +2180,24 @@ _mongoc_write_result_complete (mongoc_write_result_t        *result,
       }
       BSON_APPEND_INT32 (bson, "nRemoved", result->nRemoved);
       BSON_APPEND_INT32 (bson, "nUpserted", result->nUpserted);
-      if (!bson_empty0 (&result->upserted)) {
-         BSON_APPEND_ARRAY (bson, "upserted", &result->upserted);
+      if (!bson_empty (&upserted)) {
+         BSON_APPEND_ARRAY (bson, "upserted", &upserted);
       }
-      BSON_APPEND_ARRAY (bson, "writeErrors", &result->writeErrors);
+      BSON_APPEND_ARRAY (bson, "writeErrors", &write_errors);
       if (result->n_writeConcernErrors) {
          BSON_APPEND_ARRAY (bson, "writeConcernErrors",
-                            &result->writeConcernErrors);
+                            &write_concern_errors);
       }
    }
 
    /* set bson_error_t from first write error or write concern error */
-   _set_error_from_response (&result->writeErrors,
+   _set_error_from_response (&write_errors,
                              domain,
                              "write",
                              &result->error);
 
    if (!result->error.code) {
-      _set_error_from_response (&result->writeConcernErrors,
+      _set_error_from_response (&write_concern_errors,
                                 MONGOC_ERROR_WRITE_CONCERN,
                                 "write concern",
                                 &result->error);
@@ -1926,5 +2207,11 @@ _mongoc_write_result_complete (mongoc_write_result_t        *result,
       memcpy (error, &result->error, sizeof *error);
    }
 
-   RETURN (!result->failed && result->error.code == 0);
+   ret = (!result->failed && result->error.code == 0);
+
+   bson_destroy (&write_errors);
+   bson_destroy (&upserted);
+   bson_destroy (&write_concern_errors);
+
+   RETURN (ret);
 }
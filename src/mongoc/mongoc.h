@@ -24,7 +24,10 @@
 #define MONGOC_INSIDE
 #include "mongoc-apm.h"
 #include "mongoc-bulk-operation.h"
+#include "mongoc-bulk-writer.h"
+#include "mongoc-change-stream.h"
 #include "mongoc-client.h"
+#include "mongoc-client-async.h"
 #include "mongoc-client-pool.h"
 #include "mongoc-collection.h"
 #include "mongoc-config.h"
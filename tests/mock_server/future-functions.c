@@ -46,6 +46,72 @@ background_mongoc_bulk_operation_execute (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_bulk_writer_flush (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_bulk_writer_flush (
+         future_value_get_mongoc_bulk_writer_ptr (future_get_param (future, 0)),
+         future_value_get_bson_error_ptr (future_get_param (future, 1))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
+static void *
+background_mongoc_client_async_run (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_client_async_run (
+         future_value_get_mongoc_client_async_ptr (future_get_param (future, 0)),
+         future_value_get_int32_t (future_get_param (future, 1))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
+static void *
+background_mongoc_client_command_scatter (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_client_command_scatter (
+         future_value_get_mongoc_client_ptr (future_get_param (future, 0)),
+         future_value_get_const_char_ptr (future_get_param (future, 1)),
+         future_value_get_const_bson_ptr (future_get_param (future, 2)),
+         future_value_get_const_mongoc_read_prefs_ptr (future_get_param (future, 3)),
+         future_value_get_const_uint32_t_ptr (future_get_param (future, 4)),
+         future_value_get_size_t (future_get_param (future, 5)),
+         future_value_get_bson_ptr (future_get_param (future, 6)),
+         future_value_get_bson_error_ptr (future_get_param (future, 7))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_client_command_simple (void *data)
 {
@@ -70,6 +136,30 @@ background_mongoc_client_command_simple (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_client_pool_command_simple (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_client_pool_command_simple (
+         future_value_get_mongoc_client_pool_ptr (future_get_param (future, 0)),
+         future_value_get_const_char_ptr (future_get_param (future, 1)),
+         future_value_get_const_bson_ptr (future_get_param (future, 2)),
+         future_value_get_const_mongoc_read_prefs_ptr (future_get_param (future, 3)),
+         future_value_get_bson_ptr (future_get_param (future, 4)),
+         future_value_get_bson_error_ptr (future_get_param (future, 5))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_client_kill_cursor (void *data)
 {
@@ -317,6 +407,42 @@ background_mongoc_cursor_next (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_change_stream_destroy (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_void_type;
+
+   mongoc_change_stream_destroy (
+      future_value_get_mongoc_change_stream_ptr (future_get_param (future, 0)));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
+static void *
+background_mongoc_change_stream_next (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_change_stream_next (
+         future_value_get_mongoc_change_stream_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr_ptr (future_get_param (future, 1))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_client_get_database_names (void *data)
 {
@@ -555,6 +681,84 @@ future_bulk_operation_execute (
    return future;
 }
 
+future_t *
+future_bulk_writer_flush (
+   mongoc_bulk_writer_ptr writer,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  2);
+   
+   future_value_set_mongoc_bulk_writer_ptr (
+      future_get_param (future, 0), writer);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 1), error);
+   
+   future_start (future, background_mongoc_bulk_writer_flush);
+   return future;
+}
+
+future_t *
+future_client_async_run (
+   mongoc_client_async_ptr async,
+   int32_t timeout_msec)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  2);
+   
+   future_value_set_mongoc_client_async_ptr (
+      future_get_param (future, 0), async);
+   
+   future_value_set_int32_t (
+      future_get_param (future, 1), timeout_msec);
+   
+   future_start (future, background_mongoc_client_async_run);
+   return future;
+}
+
+future_t *
+future_client_command_scatter (
+   mongoc_client_ptr client,
+   const_char_ptr db_name,
+   const_bson_ptr command,
+   const_mongoc_read_prefs_ptr read_prefs,
+   const_uint32_t_ptr server_ids,
+   size_t n_server_ids,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  8);
+   
+   future_value_set_mongoc_client_ptr (
+      future_get_param (future, 0), client);
+   
+   future_value_set_const_char_ptr (
+      future_get_param (future, 1), db_name);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 2), command);
+   
+   future_value_set_const_mongoc_read_prefs_ptr (
+      future_get_param (future, 3), read_prefs);
+   
+   future_value_set_const_uint32_t_ptr (
+      future_get_param (future, 4), server_ids);
+   
+   future_value_set_size_t (
+      future_get_param (future, 5), n_server_ids);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 6), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 7), error);
+   
+   future_start (future, background_mongoc_client_command_scatter);
+   return future;
+}
+
 future_t *
 future_client_command_simple (
    mongoc_client_ptr client,
@@ -589,6 +793,40 @@ future_client_command_simple (
    return future;
 }
 
+future_t *
+future_client_pool_command_simple (
+   mongoc_client_pool_ptr pool,
+   const_char_ptr db_name,
+   const_bson_ptr command,
+   const_mongoc_read_prefs_ptr read_prefs,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  6);
+   
+   future_value_set_mongoc_client_pool_ptr (
+      future_get_param (future, 0), pool);
+   
+   future_value_set_const_char_ptr (
+      future_get_param (future, 1), db_name);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 2), command);
+   
+   future_value_set_const_mongoc_read_prefs_ptr (
+      future_get_param (future, 3), read_prefs);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 4), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 5), error);
+   
+   future_start (future, background_mongoc_client_pool_command_simple);
+   return future;
+}
+
 future_t *
 future_client_kill_cursor (
    mongoc_client_ptr client,
@@ -919,6 +1157,38 @@ future_cursor_next (
    return future;
 }
 
+future_t *
+future_change_stream_destroy (
+   mongoc_change_stream_ptr stream)
+{
+   future_t *future = future_new (future_value_void_type,
+                                  1);
+   
+   future_value_set_mongoc_change_stream_ptr (
+      future_get_param (future, 0), stream);
+   
+   future_start (future, background_mongoc_change_stream_destroy);
+   return future;
+}
+
+future_t *
+future_change_stream_next (
+   mongoc_change_stream_ptr stream,
+   const_bson_ptr_ptr doc)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  2);
+   
+   future_value_set_mongoc_change_stream_ptr (
+      future_get_param (future, 0), stream);
+   
+   future_value_set_const_bson_ptr_ptr (
+      future_get_param (future, 1), doc);
+   
+   future_start (future, background_mongoc_change_stream_next);
+   return future;
+}
+
 future_t *
 future_client_get_database_names (
    mongoc_client_ptr client,
@@ -23,6 +23,36 @@ future_bulk_operation_execute (
 );
 
 
+future_t *
+future_bulk_writer_flush (
+
+   mongoc_bulk_writer_ptr writer,
+   bson_error_ptr error
+);
+
+
+future_t *
+future_client_async_run (
+
+   mongoc_client_async_ptr async,
+   int32_t timeout_msec
+);
+
+
+future_t *
+future_client_command_scatter (
+
+   mongoc_client_ptr client,
+   const_char_ptr db_name,
+   const_bson_ptr command,
+   const_mongoc_read_prefs_ptr read_prefs,
+   const_uint32_t_ptr server_ids,
+   size_t n_server_ids,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_client_command_simple (
 
@@ -35,6 +65,18 @@ future_client_command_simple (
 );
 
 
+future_t *
+future_client_pool_command_simple (
+
+   mongoc_client_pool_ptr pool,
+   const_char_ptr db_name,
+   const_bson_ptr command,
+   const_mongoc_read_prefs_ptr read_prefs,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_client_kill_cursor (
 
@@ -156,6 +198,21 @@ future_cursor_next (
 );
 
 
+future_t *
+future_change_stream_destroy (
+
+   mongoc_change_stream_ptr stream
+);
+
+
+future_t *
+future_change_stream_next (
+
+   mongoc_change_stream_ptr stream,
+   const_bson_ptr_ptr doc
+);
+
+
 future_t *
 future_client_get_database_names (
 
@@ -83,6 +83,20 @@ future_value_get_int (future_value_t *future_value)
   return future_value->int_value;
 }
 
+void
+future_value_set_int32_t(future_value_t *future_value, int32_t value)
+{
+  future_value->type = future_value_int32_t_type;
+  future_value->int32_t_value = value;
+}
+
+int32_t
+future_value_get_int32_t (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_int32_t_type);
+  return future_value->int32_t_value;
+}
+
 void
 future_value_set_int64_t(future_value_t *future_value, int64_t value)
 {
@@ -223,6 +237,62 @@ future_value_get_mongoc_bulk_operation_ptr (future_value_t *future_value)
   return future_value->mongoc_bulk_operation_ptr_value;
 }
 
+void
+future_value_set_mongoc_bulk_writer_ptr(future_value_t *future_value, mongoc_bulk_writer_ptr value)
+{
+  future_value->type = future_value_mongoc_bulk_writer_ptr_type;
+  future_value->mongoc_bulk_writer_ptr_value = value;
+}
+
+mongoc_bulk_writer_ptr
+future_value_get_mongoc_bulk_writer_ptr (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_mongoc_bulk_writer_ptr_type);
+  return future_value->mongoc_bulk_writer_ptr_value;
+}
+
+void
+future_value_set_mongoc_change_stream_ptr(future_value_t *future_value, mongoc_change_stream_ptr value)
+{
+  future_value->type = future_value_mongoc_change_stream_ptr_type;
+  future_value->mongoc_change_stream_ptr_value = value;
+}
+
+mongoc_change_stream_ptr
+future_value_get_mongoc_change_stream_ptr (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_mongoc_change_stream_ptr_type);
+  return future_value->mongoc_change_stream_ptr_value;
+}
+
+void
+future_value_set_mongoc_client_async_ptr(future_value_t *future_value, mongoc_client_async_ptr value)
+{
+  future_value->type = future_value_mongoc_client_async_ptr_type;
+  future_value->mongoc_client_async_ptr_value = value;
+}
+
+mongoc_client_async_ptr
+future_value_get_mongoc_client_async_ptr (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_mongoc_client_async_ptr_type);
+  return future_value->mongoc_client_async_ptr_value;
+}
+
+void
+future_value_set_mongoc_client_pool_ptr(future_value_t *future_value, mongoc_client_pool_ptr value)
+{
+  future_value->type = future_value_mongoc_client_pool_ptr_type;
+  future_value->mongoc_client_pool_ptr_value = value;
+}
+
+mongoc_client_pool_ptr
+future_value_get_mongoc_client_pool_ptr (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_mongoc_client_pool_ptr_type);
+  return future_value->mongoc_client_pool_ptr_value;
+}
+
 void
 future_value_set_mongoc_client_ptr(future_value_t *future_value, mongoc_client_ptr value)
 {
@@ -432,3 +502,17 @@ future_value_get_const_mongoc_write_concern_ptr (future_value_t *future_value)
   assert (future_value->type == future_value_const_mongoc_write_concern_ptr_type);
   return future_value->const_mongoc_write_concern_ptr_value;
 }
+
+void
+future_value_set_const_uint32_t_ptr(future_value_t *future_value, const_uint32_t_ptr value)
+{
+  future_value->type = future_value_const_uint32_t_ptr_type;
+  future_value->const_uint32_t_ptr_value = value;
+}
+
+const_uint32_t_ptr
+future_value_get_const_uint32_t_ptr (future_value_t *future_value)
+{
+  assert (future_value->type == future_value_const_uint32_t_ptr_type);
+  return future_value->const_uint32_t_ptr_value;
+}
@@ -26,6 +26,10 @@ typedef bson_t * bson_ptr;
 typedef const bson_t * const_bson_ptr;
 typedef const bson_t ** const_bson_ptr_ptr;
 typedef mongoc_bulk_operation_t * mongoc_bulk_operation_ptr;
+typedef mongoc_bulk_writer_t * mongoc_bulk_writer_ptr;
+typedef mongoc_change_stream_t * mongoc_change_stream_ptr;
+typedef mongoc_client_async_t * mongoc_client_async_ptr;
+typedef mongoc_client_pool_t * mongoc_client_pool_ptr;
 typedef mongoc_client_t * mongoc_client_ptr;
 typedef mongoc_collection_t * mongoc_collection_ptr;
 typedef mongoc_cursor_t * mongoc_cursor_ptr;
@@ -38,6 +42,7 @@ typedef mongoc_topology_t * mongoc_topology_ptr;
 typedef const mongoc_find_and_modify_opts_t * const_mongoc_find_and_modify_opts_ptr;
 typedef const mongoc_read_prefs_t * const_mongoc_read_prefs_ptr;
 typedef const mongoc_write_concern_t * const_mongoc_write_concern_ptr;
+typedef const uint32_t * const_uint32_t_ptr;
 
 typedef enum {
    future_value_no_type = 0,
@@ -45,6 +50,7 @@ typedef enum {
    future_value_char_ptr_type,
    future_value_char_ptr_ptr_type,
    future_value_int_type,
+   future_value_int32_t_type,
    future_value_int64_t_type,
    future_value_size_t_type,
    future_value_ssize_t_type,
@@ -55,6 +61,10 @@ typedef enum {
    future_value_const_bson_ptr_type,
    future_value_const_bson_ptr_ptr_type,
    future_value_mongoc_bulk_operation_ptr_type,
+   future_value_mongoc_bulk_writer_ptr_type,
+   future_value_mongoc_change_stream_ptr_type,
+   future_value_mongoc_client_async_ptr_type,
+   future_value_mongoc_client_pool_ptr_type,
    future_value_mongoc_client_ptr_type,
    future_value_mongoc_collection_ptr_type,
    future_value_mongoc_cursor_ptr_type,
@@ -70,6 +80,7 @@ typedef enum {
    future_value_const_mongoc_find_and_modify_opts_ptr_type,
    future_value_const_mongoc_read_prefs_ptr_type,
    future_value_const_mongoc_write_concern_ptr_type,
+   future_value_const_uint32_t_ptr_type,
    future_value_void_type,
 
 } future_value_type_t;
@@ -82,6 +93,7 @@ typedef struct _future_value_t
       char_ptr char_ptr_value;
       char_ptr_ptr char_ptr_ptr_value;
       int int_value;
+      int32_t int32_t_value;
       int64_t int64_t_value;
       size_t size_t_value;
       ssize_t ssize_t_value;
@@ -92,6 +104,10 @@ typedef struct _future_value_t
       const_bson_ptr const_bson_ptr_value;
       const_bson_ptr_ptr const_bson_ptr_ptr_value;
       mongoc_bulk_operation_ptr mongoc_bulk_operation_ptr_value;
+      mongoc_bulk_writer_ptr mongoc_bulk_writer_ptr_value;
+      mongoc_change_stream_ptr mongoc_change_stream_ptr_value;
+      mongoc_client_async_ptr mongoc_client_async_ptr_value;
+      mongoc_client_pool_ptr mongoc_client_pool_ptr_value;
       mongoc_client_ptr mongoc_client_ptr_value;
       mongoc_collection_ptr mongoc_collection_ptr_value;
       mongoc_cursor_ptr mongoc_cursor_ptr_value;
@@ -107,6 +123,7 @@ typedef struct _future_value_t
       const_mongoc_find_and_modify_opts_ptr const_mongoc_find_and_modify_opts_ptr_value;
       const_mongoc_read_prefs_ptr const_mongoc_read_prefs_ptr_value;
       const_mongoc_write_concern_ptr const_mongoc_write_concern_ptr_value;
+      const_uint32_t_ptr const_uint32_t_ptr_value;
 
    };
 } future_value_t;
@@ -159,6 +176,15 @@ int
 future_value_get_int (
    future_value_t *future_value);
 
+void
+future_value_set_int32_t(
+   future_value_t *future_value,
+   int32_t value);
+
+int32_t
+future_value_get_int32_t (
+   future_value_t *future_value);
+
 void
 future_value_set_int64_t(
    future_value_t *future_value,
@@ -249,6 +275,42 @@ mongoc_bulk_operation_ptr
 future_value_get_mongoc_bulk_operation_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_mongoc_bulk_writer_ptr(
+   future_value_t *future_value,
+   mongoc_bulk_writer_ptr value);
+
+mongoc_bulk_writer_ptr
+future_value_get_mongoc_bulk_writer_ptr (
+   future_value_t *future_value);
+
+void
+future_value_set_mongoc_change_stream_ptr(
+   future_value_t *future_value,
+   mongoc_change_stream_ptr value);
+
+mongoc_change_stream_ptr
+future_value_get_mongoc_change_stream_ptr (
+   future_value_t *future_value);
+
+void
+future_value_set_mongoc_client_async_ptr(
+   future_value_t *future_value,
+   mongoc_client_async_ptr value);
+
+mongoc_client_async_ptr
+future_value_get_mongoc_client_async_ptr (
+   future_value_t *future_value);
+
+void
+future_value_set_mongoc_client_pool_ptr(
+   future_value_t *future_value,
+   mongoc_client_pool_ptr value);
+
+mongoc_client_pool_ptr
+future_value_get_mongoc_client_pool_ptr (
+   future_value_t *future_value);
+
 void
 future_value_set_mongoc_client_ptr(
    future_value_t *future_value,
@@ -384,6 +446,15 @@ const_mongoc_write_concern_ptr
 future_value_get_const_mongoc_write_concern_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_const_uint32_t_ptr(
+   future_value_t *future_value,
+   const_uint32_t_ptr value);
+
+const_uint32_t_ptr
+future_value_get_const_uint32_t_ptr (
+   future_value_t *future_value);
+
 
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -67,6 +67,17 @@ future_get_int (future_t *future)
    abort ();
 }
 
+int32_t
+future_get_int32_t (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_int32_t (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
 int64_t
 future_get_int64_t (future_t *future)
 {
@@ -177,6 +188,50 @@ future_get_mongoc_bulk_operation_ptr (future_t *future)
    abort ();
 }
 
+mongoc_bulk_writer_ptr
+future_get_mongoc_bulk_writer_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_bulk_writer_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
+mongoc_change_stream_ptr
+future_get_mongoc_change_stream_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_change_stream_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
+mongoc_client_async_ptr
+future_get_mongoc_client_async_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_client_async_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
+mongoc_client_pool_ptr
+future_get_mongoc_client_pool_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_client_pool_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
 mongoc_client_ptr
 future_get_mongoc_client_ptr (future_t *future)
 {
@@ -342,6 +397,17 @@ future_get_const_mongoc_write_concern_ptr (future_t *future)
    abort ();
 }
 
+const_uint32_t_ptr
+future_get_const_uint32_t_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_const_uint32_t_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   abort ();
+}
+
 
 future_t *
 future_new (future_value_type_t return_type, int argc)
@@ -52,6 +52,9 @@ future_get_char_ptr_ptr (future_t *future);
 int
 future_get_int (future_t *future);
 
+int32_t
+future_get_int32_t (future_t *future);
+
 int64_t
 future_get_int64_t (future_t *future);
 
@@ -82,6 +85,18 @@ future_get_const_bson_ptr_ptr (future_t *future);
 mongoc_bulk_operation_ptr
 future_get_mongoc_bulk_operation_ptr (future_t *future);
 
+mongoc_bulk_writer_ptr
+future_get_mongoc_bulk_writer_ptr (future_t *future);
+
+mongoc_change_stream_ptr
+future_get_mongoc_change_stream_ptr (future_t *future);
+
+mongoc_client_async_ptr
+future_get_mongoc_client_async_ptr (future_t *future);
+
+mongoc_client_pool_ptr
+future_get_mongoc_client_pool_ptr (future_t *future);
+
 mongoc_client_ptr
 future_get_mongoc_client_ptr (future_t *future);
 
@@ -127,6 +142,9 @@ future_get_const_mongoc_read_prefs_ptr (future_t *future);
 const_mongoc_write_concern_ptr
 future_get_const_mongoc_write_concern_ptr (future_t *future);
 
+const_uint32_t_ptr
+future_get_const_uint32_t_ptr (future_t *future);
+
 
 void future_destroy (future_t *future);
 
@@ -3065,6 +3065,160 @@ test_bulk_reply_w0 (void)
 }
 
 
+static void
+test_bulk_parallel_unordered (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   bson_t doc;
+   bson_t reply;
+   int i;
+
+   /* two documents per batch, so four inserts become two batches */
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server, "{'ismaster': true,"
+                                      " 'maxWireVersion': 3,"
+                                      " 'maxWriteBatchSize': 2}");
+   mock_server_run (server);
+
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation (collection, false, NULL);
+   mongoc_bulk_operation_set_client_pool (bulk, pool, 2);
+
+   for (i = 0; i < 4; i++) {
+      bson_init (&doc);
+      BSON_APPEND_INT32 (&doc, "_id", i);
+      mongoc_bulk_operation_insert (bulk, &doc);
+      bson_destroy (&doc);
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   /* the batches may arrive in either order, on either connection. the
+    * second document of the second batch fails, which is index 3 overall */
+   for (i = 0; i < 2; i++) {
+      request = mock_server_receives_command (
+         server, "db", MONGOC_QUERY_NONE,
+         "{'insert': 'collection', 'ordered': false}");
+
+      ASSERT (request);
+
+      if (bson_lookup_int32 (request_get_doc (request, 0),
+                             "documents.0._id") == 2) {
+         ASSERT_MATCH (request_get_doc (request, 0),
+                       "{'documents': [{'_id': 2}, {'_id': 3}]}");
+         mock_server_replies_simple (
+            request,
+            "{'ok': 1, 'n': 1,"
+            " 'writeErrors': [{'index': 1, 'code': 11000, 'errmsg': 'dupe'}]}");
+      } else {
+         ASSERT_MATCH (request_get_doc (request, 0),
+                       "{'documents': [{'_id': 0}, {'_id': 1}]}");
+         mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+      }
+
+      request_destroy (request);
+   }
+
+   ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+   ASSERT_MATCH (&reply, "{'nInserted': 3,"
+                         " 'writeErrors': [{'index': 3, 'code': 11000}]}");
+
+   bson_destroy (&reply);
+   future_destroy (future);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+/* errors and upserts from several batches are all reported, with indexes
+ * into the whole bulk operation */
+static void
+test_bulk_merge_batch_results (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   bson_t selector;
+   bson_t reply;
+   int i;
+   const char *replies[] = {
+      "{'ok': 1, 'n': 2, 'nModified': 1,"
+      " 'upserted': [{'index': 1, '_id': 1}]}",
+      "{'ok': 1, 'n': 1, 'nModified': 1,"
+      " 'writeErrors': [{'index': 0, 'code': 11000, 'errmsg': 'dupe'}]}",
+      "{'ok': 1, 'n': 2, 'nModified': 1,"
+      " 'upserted': [{'index': 1, '_id': 5}],"
+      " 'writeConcernError': {'code': 64, 'errmsg': 'timeout'}}"
+   };
+
+   /* two updates per batch, so six updates become three batches */
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server, "{'ismaster': true,"
+                                      " 'maxWireVersion': 3,"
+                                      " 'maxWriteBatchSize': 2}");
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation (collection, false, NULL);
+
+   for (i = 0; i < 6; i++) {
+      bson_init (&selector);
+      BSON_APPEND_INT32 (&selector, "_id", i);
+      mongoc_bulk_operation_update_one (bulk, &selector,
+                                        tmp_bson ("{'$set': {'x': 1}}"),
+                                        true);
+      bson_destroy (&selector);
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   for (i = 0; i < 3; i++) {
+      request = mock_server_receives_command (
+         server, "db", MONGOC_QUERY_NONE,
+         "{'update': 'collection', 'ordered': false}");
+
+      ASSERT (request);
+      mock_server_replies_simple (request, replies[i]);
+      request_destroy (request);
+   }
+
+   ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+   ASSERT_MATCH (&reply, "{'nMatched': 3,"
+                         " 'nModified': 3,"
+                         " 'nUpserted': 2,"
+                         " 'upserted': [{'index': 1, '_id': 1},"
+                         "              {'index': 5, '_id': 5}],"
+                         " 'writeErrors': [{'index': 2, 'code': 11000}],"
+                         " 'writeConcernErrors': [{'code': 64}]}");
+
+   bson_destroy (&reply);
+   future_destroy (future);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 void
 test_bulk_install (TestSuite *suite)
 {
@@ -3221,4 +3375,8 @@ test_bulk_install (TestSuite *suite)
                   test_hint_pooled_command_primary);
    TestSuite_AddLive (suite, "/BulkOperation/reply_w0",
                       test_bulk_reply_w0);
+   TestSuite_Add (suite, "/BulkOperation/parallel/unordered",
+                  test_bulk_parallel_unordered);
+   TestSuite_Add (suite, "/BulkOperation/merge_batch_results",
+                  test_bulk_merge_batch_results);
 }
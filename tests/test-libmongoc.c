@@ -38,6 +38,8 @@ extern void test_array_install                   (TestSuite *suite);
 extern void test_async_install                   (TestSuite *suite);
 extern void test_buffer_install                  (TestSuite *suite);
 extern void test_bulk_install                    (TestSuite *suite);
+extern void test_bulk_writer_install             (TestSuite *suite);
+extern void test_change_stream_install           (TestSuite *suite);
 extern void test_client_install                  (TestSuite *suite);
 #ifdef MONGOC_EXPERIMENTAL_FEATURES
 extern void test_client_max_staleness_install    (TestSuite *suite);
@@ -1727,6 +1729,8 @@ main (int   argc,
    test_client_pool_install (&suite);
    test_write_command_install (&suite);
    test_bulk_install (&suite);
+   test_bulk_writer_install (&suite);
+   test_change_stream_install (&suite);
    test_cluster_install (&suite);
    test_collection_install (&suite);
    test_collection_find_install (&suite);
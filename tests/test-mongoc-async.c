@@ -1,5 +1,8 @@
 #include <mongoc.h>
 
+#include "mongoc-client-private.h"
+#include "mongoc-topology-private.h"
+
 #include "mock_server/mock-server.h"
 #include "mock_server/future-functions.h"
 #include "test-conveniences.h"
@@ -196,12 +199,186 @@ test_ismaster_ssl_pooled (void)
 #endif
 
 
+typedef struct
+{
+   int          n_calls;
+   bson_t       replies[3];
+   bson_error_t errors[3];
+} async_client_ctx_t;
+
+
+static void
+async_client_cb (const bson_t       *reply,
+                 const bson_error_t *error,
+                 void               *context)
+{
+   async_client_ctx_t *ctx = (async_client_ctx_t *)context;
+
+   assert (ctx->n_calls < 3);
+   assert (reply);
+
+   bson_copy_to (reply, &ctx->replies[ctx->n_calls]);
+   if (error) {
+      memcpy (&ctx->errors[ctx->n_calls], error, sizeof (bson_error_t));
+   }
+
+   ctx->n_calls++;
+}
+
+
+static void
+test_client_async_pipeline (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_client_async_t *async;
+   async_client_ctx_t ctx = { 0 };
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[3];
+   char cmd[32];
+   int i;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   async = mongoc_client_async_new (client);
+   mongoc_client_async_set_max_connections (async, 1);
+
+   for (i = 0; i < 3; i++) {
+      bson_snprintf (cmd, sizeof cmd, "{'ping': %d}", i);
+      ASSERT_OR_PRINT (mongoc_client_async_command (async, "admin",
+                                                    tmp_bson (cmd), NULL, 0,
+                                                    async_client_cb, &ctx,
+                                                    &error), error);
+   }
+
+   future = future_client_async_run (async, -1);
+
+   /* all three commands arrive on one connection before any reply */
+   for (i = 0; i < 3; i++) {
+      bson_snprintf (cmd, sizeof cmd, "{'ping': %d}", i);
+      requests[i] = mock_server_receives_command (server, "admin",
+                                                  MONGOC_QUERY_SLAVE_OK, cmd);
+      assert (requests[i]);
+   }
+
+   mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 0}");
+   mock_server_replies_simple (requests[1], "{'ok': 1, 'n': 1}");
+   mock_server_replies_simple (requests[2],
+                               "{'ok': 0, 'code': 2, 'errmsg': 'bad'}");
+
+   assert (!future_get_bool (future));
+   ASSERT_CMPINT (ctx.n_calls, ==, 3);
+   ASSERT_MATCH (&ctx.replies[0], "{'ok': 1, 'n': 0}");
+   ASSERT_MATCH (&ctx.replies[1], "{'ok': 1, 'n': 1}");
+   ASSERT_CMPINT (ctx.errors[0].code, ==, 0);
+   ASSERT_CMPINT (ctx.errors[1].code, ==, 0);
+   ASSERT_ERROR_CONTAINS (ctx.errors[2], MONGOC_ERROR_QUERY, 2, "bad");
+
+   for (i = 0; i < 3; i++) {
+      bson_destroy (&ctx.replies[i]);
+      request_destroy (requests[i]);
+   }
+
+   future_destroy (future);
+   mongoc_client_async_destroy (async);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_client_async_step (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_client_async_t *async;
+   async_client_ctx_t ctx = { 0 };
+   mongoc_socket_poll_t sds[4];
+   mongoc_server_description_t *sd;
+   bson_error_t error;
+   request_t *request;
+   size_t n;
+   bool pending;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   async = mongoc_client_async_new (client);
+   ASSERT_CMPINT (mongoc_client_async_get_timeout (async), ==, -1);
+
+   /* check the server without blocking in server selection */
+   mongoc_client_async_scan (async);
+
+   do {
+      n = mongoc_client_async_get_sockets (async, sds, 4);
+      ASSERT_CMPINT ((int) n, <=, 4);
+      ASSERT_CMPINT ((int) mongoc_socket_poll (
+                        sds, n, mongoc_client_async_get_timeout (async)),
+                     >=, 0);
+   } while (mongoc_client_async_step (async, sds, n));
+
+   ASSERT_CMPINT64 (client->topology->last_scan, >, (int64_t) 0);
+   sd = mongoc_topology_server_by_id (client->topology, 1, &error);
+   ASSERT_OR_PRINT (sd, error);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_STANDALONE);
+   mongoc_server_description_destroy (sd);
+
+   ASSERT_OR_PRINT (mongoc_client_async_command (async, "admin",
+                                                 tmp_bson ("{'ping': 1}"),
+                                                 NULL, 0, async_client_cb,
+                                                 &ctx, &error), error);
+
+   ASSERT_CMPINT (mongoc_client_async_get_timeout (async), >, 0);
+
+   /* the new connection is ready to send the command */
+   n = mongoc_client_async_get_sockets (async, sds, 4);
+   ASSERT_CMPINT ((int) n, ==, 1);
+   ASSERT_CMPINT (sds[0].events, ==, POLLOUT);
+#ifndef _WIN32
+   ASSERT_CMPINT (mongoc_socket_get_fd (sds[0].socket), >=, 0);
+#endif
+
+   sds[0].revents = POLLOUT;
+   assert (mongoc_client_async_step (async, sds, 1));
+
+   request = mock_server_receives_command (server, "admin",
+                                           MONGOC_QUERY_SLAVE_OK,
+                                           "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+
+   n = mongoc_client_async_get_sockets (async, sds, 4);
+   ASSERT_CMPINT ((int) n, ==, 1);
+   ASSERT_CMPINT (sds[0].events, ==, POLLIN);
+
+   do {
+      ASSERT_CMPINT ((int) mongoc_socket_poll (sds, 1, 1000), ==, 1);
+      pending = mongoc_client_async_step (async, sds, 1);
+   } while (pending && !ctx.n_calls);
+
+   assert (!pending);
+   ASSERT_CMPINT (ctx.n_calls, ==, 1);
+   ASSERT_MATCH (&ctx.replies[0], "{'ok': 1}");
+   ASSERT_CMPINT (mongoc_client_async_get_timeout (async), ==, -1);
+
+   bson_destroy (&ctx.replies[0]);
+   request_destroy (request);
+   mongoc_client_async_destroy (async);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 void
 test_async_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/Async/ismaster", test_ismaster);
    TestSuite_Add (suite, "/Async/ismaster/pooled",
                   test_ismaster_pooled);
+   TestSuite_Add (suite, "/Async/client/pipeline",
+                  test_client_async_pipeline);
+   TestSuite_Add (suite, "/Async/client/step", test_client_async_step);
 
 #ifdef MONGOC_ENABLE_SSL_OPENSSL
    TestSuite_Add (suite, "/Async/ismaster_ssl", test_ismaster_ssl);
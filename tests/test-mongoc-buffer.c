@@ -1,8 +1,10 @@
 #include <fcntl.h>
 #include <mongoc.h>
 #include <mongoc-buffer-private.h>
+#include <mongoc-buffer-pool-private.h>
 
 #include "TestSuite.h"
+#include "test-libmongoc.h"
 
 
 static void
@@ -34,8 +36,296 @@ test_mongoc_buffer_basic (void)
 }
 
 
+static void
+test_mongoc_buffer_pool_reuse (void)
+{
+   mongoc_buffer_pool_t *pool;
+   mongoc_buffer_t buf;
+   uint8_t *data;
+
+   pool = _mongoc_buffer_pool_new (1024 * 1024);
+
+   _mongoc_buffer_init_from_pool (&buf, pool);
+   ASSERT_CMPUINT64 (pool->misses, ==, (uint64_t) 1);
+   ASSERT_CMPUINT64 (pool->hits, ==, (uint64_t) 0);
+   data = buf.data;
+   _mongoc_buffer_destroy (&buf);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 1024);
+
+   /* the same block is handed out again */
+   _mongoc_buffer_init_from_pool (&buf, pool);
+   ASSERT_CMPUINT64 (pool->hits, ==, (uint64_t) 1);
+   ASSERT (buf.data == data);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 0);
+
+   /* growing moves to a larger size class and returns the 1KB block */
+   buf.data = (uint8_t *) _mongoc_buffer_pool_realloc (buf.data, 4096, pool);
+   buf.datalen = 4096;
+   ASSERT (buf.data != data);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 1024);
+
+   _mongoc_buffer_destroy (&buf);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 1024 + 4096);
+
+   _mongoc_buffer_pool_destroy (pool);
+}
+
+
+static void
+test_mongoc_buffer_pool_cap (void)
+{
+   mongoc_buffer_pool_t *pool;
+   void *a;
+   void *b;
+   void *c;
+
+   pool = _mongoc_buffer_pool_new (4096);
+
+   a = _mongoc_buffer_pool_realloc (NULL, 2048, pool);
+   b = _mongoc_buffer_pool_realloc (NULL, 2048, pool);
+   c = _mongoc_buffer_pool_realloc (NULL, 2048, pool);
+
+   /* growing within the size class keeps the block */
+   ASSERT (_mongoc_buffer_pool_realloc (a, 2000, pool) == a);
+
+   ASSERT (!_mongoc_buffer_pool_realloc (a, 0, pool));
+   ASSERT (!_mongoc_buffer_pool_realloc (b, 0, pool));
+   /* over the cap, freed instead of retained */
+   ASSERT (!_mongoc_buffer_pool_realloc (c, 0, pool));
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 4096);
+
+   /* blocks larger than the largest class are never retained */
+   a = _mongoc_buffer_pool_realloc (
+      NULL, ((size_t) 1 << MONGOC_BUFFER_POOL_MAX_SHIFT) + 1, pool);
+   ASSERT (!_mongoc_buffer_pool_realloc (a, 0, pool));
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 4096);
+
+   _mongoc_buffer_pool_set_max_bytes (pool, 2048);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 2048);
+
+   _mongoc_buffer_pool_set_max_bytes (pool, 0);
+   ASSERT_CMPSIZE_T (pool->retained_bytes, ==, (size_t) 0);
+
+   _mongoc_buffer_pool_destroy (pool);
+}
+
+
+/* an endless stream of bytes 0, 1, ... 250, 0, 1, ... that returns no more
+ * than "chunk" bytes per read, unless asked for more, like a socket */
+typedef struct
+{
+   mongoc_stream_t vtable;
+   uint64_t        pos;
+   size_t          chunk;
+} pattern_stream_t;
+
+
+static ssize_t
+pattern_stream_readv (mongoc_stream_t *stream,
+                      mongoc_iovec_t  *iov,
+                      size_t           iovcnt,
+                      size_t           min_bytes,
+                      int32_t          timeout_msec)
+{
+   pattern_stream_t *pstream = (pattern_stream_t *) stream;
+   size_t total = 0;
+   size_t want;
+   size_t i;
+   size_t j;
+
+   for (i = 0; i < iovcnt; i++) {
+      total += iov[i].iov_len;
+   }
+
+   want = BSON_MIN (total, BSON_MAX (min_bytes, pstream->chunk));
+   total = 0;
+
+   for (i = 0; i < iovcnt && total < want; i++) {
+      for (j = 0; j < iov[i].iov_len && total < want; j++, total++) {
+         ((uint8_t *) iov[i].iov_base)[j] = (uint8_t) (pstream->pos++ % 251);
+      }
+   }
+
+   return (ssize_t) total;
+}
+
+
+static void
+pattern_stream_destroy (mongoc_stream_t *stream)
+{
+   bson_free (stream);
+}
+
+
+static mongoc_stream_t *
+pattern_stream_new (size_t chunk)
+{
+   pattern_stream_t *stream;
+
+   stream = (pattern_stream_t *) bson_malloc0 (sizeof *stream);
+   stream->vtable.type = 999;
+   stream->vtable.readv = pattern_stream_readv;
+   stream->vtable.destroy = pattern_stream_destroy;
+   stream->chunk = chunk;
+
+   return (mongoc_stream_t *) stream;
+}
+
+
+static void
+assert_pattern (const uint8_t *data,
+                size_t         len,
+                uint64_t      *pos)
+{
+   size_t i;
+
+   for (i = 0; i < len; i++) {
+      ASSERT_CMPUINT ((unsigned) data[i], ==, (unsigned) (*pos % 251));
+      (*pos)++;
+   }
+}
+
+
+static void
+test_mongoc_buffer_ring (void)
+{
+   mongoc_stream_t *stream;
+   mongoc_buffer_t buf;
+   bson_error_t error;
+   mongoc_iovec_t iov[2];
+   uint8_t a[64];
+   uint8_t b[64];
+   uint8_t msg[50];
+   uint64_t pos = 0;
+   size_t size;
+   uint8_t *data;
+   ssize_t r;
+
+   stream = pattern_stream_new (48);
+   _mongoc_buffer_init_ring (&buf, 64, NULL, NULL);
+   data = buf.data;
+
+   /* reads of every size wrap around the ring without reallocating */
+   for (size = 1; size <= 64; size++) {
+      r = _mongoc_buffer_ring_fill (&buf, stream, size, 0, &error);
+      ASSERT_OR_PRINT (r >= (ssize_t) size, error);
+
+      iov[0].iov_base = (void *) a;
+      iov[0].iov_len = size / 2;
+      iov[1].iov_base = (void *) b;
+      iov[1].iov_len = size - size / 2;
+
+      ASSERT_CMPSIZE_T (_mongoc_buffer_ring_read (&buf, iov, 2), ==, size);
+      assert_pattern (a, size / 2, &pos);
+      assert_pattern (b, size - size / 2, &pos);
+      ASSERT (buf.data == data);
+   }
+
+   /* filling past the capacity of a wrapped ring grows it in place */
+   for (size = 40; size >= 20; size -= 20) {
+      r = _mongoc_buffer_ring_fill (&buf, stream, size + 10, 0, &error);
+      ASSERT_OR_PRINT (r >= (ssize_t) size + 10, error);
+      iov[0].iov_base = (void *) a;
+      iov[0].iov_len = size;
+      ASSERT_CMPSIZE_T (_mongoc_buffer_ring_read (&buf, iov, 1), ==, size);
+      assert_pattern (a, size, &pos);
+   }
+
+   ASSERT ((size_t) buf.off + buf.len > buf.datalen);
+
+   r = _mongoc_buffer_ring_fill (&buf, stream, 100, 0, &error);
+   ASSERT_OR_PRINT (r >= 100, error);
+   ASSERT_CMPSIZE_T (buf.datalen, ==, (size_t) 128);
+
+   for (size = 0; size < 100; size += 50) {
+      iov[0].iov_base = (void *) msg;
+      iov[0].iov_len = 50;
+      ASSERT_CMPSIZE_T (_mongoc_buffer_ring_read (&buf, iov, 1), ==,
+                        (size_t) 50);
+      assert_pattern (msg, 50, &pos);
+   }
+
+   _mongoc_buffer_destroy (&buf);
+   mongoc_stream_destroy (stream);
+}
+
+
+/* reads "messages" whose sizes cycle through 16 bytes to 16KB, as a
+ * buffered stream would, and returns the elapsed microseconds */
+static int64_t
+_bench_buffer (bool ring)
+{
+   mongoc_stream_t *stream;
+   mongoc_buffer_t buf;
+   bson_error_t error;
+   mongoc_iovec_t iov;
+   uint8_t msg[16 * 1024];
+   uint64_t pos = 0;
+   int64_t start;
+   size_t size;
+   ssize_t r;
+   int i;
+
+   stream = pattern_stream_new (32 * 1024);
+
+   if (ring) {
+      _mongoc_buffer_init_ring (&buf, 64 * 1024, NULL, NULL);
+   } else {
+      _mongoc_buffer_init (&buf, NULL, 64 * 1024, NULL, NULL);
+   }
+
+   start = bson_get_monotonic_time ();
+
+   for (i = 0; i < 20000; i++) {
+      size = (size_t) 16 << (i % 11);
+
+      if (ring) {
+         r = _mongoc_buffer_ring_fill (&buf, stream, size, 0, &error);
+         ASSERT_OR_PRINT (r >= (ssize_t) size, error);
+         iov.iov_base = (void *) msg;
+         iov.iov_len = size;
+         _mongoc_buffer_ring_read (&buf, &iov, 1);
+      } else {
+         r = _mongoc_buffer_fill (&buf, stream, size, 0, &error);
+         ASSERT_OR_PRINT (r >= (ssize_t) size, error);
+         memcpy (msg, &buf.data[buf.off], size);
+         buf.off += size;
+         buf.len -= size;
+      }
+
+      /* check the first bytes only, so verification doesn't dominate */
+      assert_pattern (msg, 16, &pos);
+      pos += size - 16;
+   }
+
+   start = bson_get_monotonic_time () - start;
+
+   _mongoc_buffer_destroy (&buf);
+   mongoc_stream_destroy (stream);
+
+   return start;
+}
+
+
+static void
+test_mongoc_buffer_bench (void)
+{
+   int64_t linear_usec = _bench_buffer (false);
+   int64_t ring_usec = _bench_buffer (true);
+
+   if (test_framework_getenv_bool ("MONGOC_TEST_BENCHMARK")) {
+      fprintf (stderr, "      linear fill: %" PRId64 "us, ring fill: %"
+               PRId64 "us\n", linear_usec, ring_usec);
+   }
+}
+
+
 void
 test_buffer_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/Buffer/Basic", test_mongoc_buffer_basic);
+   TestSuite_Add (suite, "/Buffer/Pool/reuse", test_mongoc_buffer_pool_reuse);
+   TestSuite_Add (suite, "/Buffer/Pool/cap", test_mongoc_buffer_pool_cap);
+   TestSuite_Add (suite, "/Buffer/Ring", test_mongoc_buffer_ring);
+   TestSuite_Add (suite, "/Buffer/Ring/bench", test_mongoc_buffer_bench);
 }
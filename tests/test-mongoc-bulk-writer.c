@@ -0,0 +1,169 @@
+#include <mongoc.h>
+
+#include "mongoc-bulk-writer-private.h"
+
+#include "TestSuite.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+#include "mock_server/future.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "bulk-writer-test"
+
+
+typedef struct
+{
+   int     n_calls;
+   int64_t first_document[8];
+   int32_t n_documents[8];
+   bool    failed[8];
+} batch_log_t;
+
+
+static void
+log_batch (int64_t             first_document,
+           uint32_t            n_documents,
+           const bson_t       *reply,
+           const bson_error_t *error,
+           void               *context)
+{
+   batch_log_t *log = (batch_log_t *)context;
+
+   ASSERT_CMPINT (log->n_calls, <, 8);
+   ASSERT (reply);
+
+   log->first_document[log->n_calls] = first_document;
+   log->n_documents[log->n_calls] = (int32_t) n_documents;
+   log->failed[log->n_calls] = error != NULL;
+   log->n_calls++;
+}
+
+
+static void
+receive_insert (mock_server_t *server,
+                const char    *documents,
+                const char    *reply)
+{
+   request_t *request;
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_NONE,
+      "{'insert': 'collection', 'documents': %s}", documents);
+
+   ASSERT (request);
+   mock_server_replies_simple (request, reply);
+   request_destroy (request);
+}
+
+
+/* a partial batch is written once the flush interval passes */
+static void
+test_bulk_writer_interval (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_bulk_writer_t *writer;
+   batch_log_t log = { 0 };
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+
+   writer = mongoc_bulk_writer_new (pool, "db", "collection", false, NULL);
+   mongoc_bulk_writer_set_callback (writer, log_batch, &log);
+   mongoc_bulk_writer_set_flush_interval (writer, 10);
+   mongoc_bulk_writer_insert (writer, tmp_bson ("{'_id': 0}"));
+   mongoc_bulk_writer_insert (writer, tmp_bson ("{'_id': 1}"));
+
+   receive_insert (server, "[{'_id': 0}, {'_id': 1}]", "{'ok': 1, 'n': 2}");
+
+   ASSERT_OR_PRINT (mongoc_bulk_writer_flush (writer, &error), error);
+   ASSERT_CMPINT (log.n_calls, ==, 1);
+   ASSERT_CMPINT64 (log.first_document[0], ==, (int64_t) 0);
+   ASSERT_CMPINT (log.n_documents[0], ==, 2);
+   ASSERT (!log.failed[0]);
+
+   mongoc_bulk_writer_destroy (writer);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+/* batches are sealed at the server's maxWriteBatchSize, and a failed batch
+ * is reported to the callback and by the next flush */
+static void
+test_bulk_writer_batch_size (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_bulk_writer_t *writer;
+   batch_log_t log = { 0 };
+   future_t *future;
+   bson_error_t error;
+   char json[32];
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server, "{'ismaster': true,"
+                                      " 'maxWireVersion': 3,"
+                                      " 'maxWriteBatchSize': 2}");
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+
+   writer = mongoc_bulk_writer_new (pool, "db", "collection", false, NULL);
+   mongoc_bulk_writer_set_callback (writer, log_batch, &log);
+
+   /* once the first batch is written the worker knows the server's limits */
+   mongoc_bulk_writer_insert (writer, tmp_bson ("{'_id': 0}"));
+   future = future_bulk_writer_flush (writer, &error);
+   receive_insert (server, "[{'_id': 0}]", "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   for (i = 1; i < 6; i++) {
+      bson_snprintf (json, sizeof json, "{'_id': %d}", i);
+      mongoc_bulk_writer_insert (writer, tmp_bson (json));
+   }
+
+   receive_insert (server, "[{'_id': 1}, {'_id': 2}]", "{'ok': 1, 'n': 2}");
+   receive_insert (server, "[{'_id': 3}, {'_id': 4}]",
+                   "{'ok': 1, 'n': 1,"
+                   " 'writeErrors': [{'index': 0, 'code': 11000,"
+                   "                  'errmsg': 'dupe'}]}");
+
+   /* the last document waits for a flush */
+   future = future_bulk_writer_flush (writer, &error);
+   receive_insert (server, "[{'_id': 5}]", "{'ok': 1, 'n': 1}");
+   ASSERT (!future_get_bool (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+   future_destroy (future);
+
+   ASSERT_CMPINT (log.n_calls, ==, 4);
+   ASSERT_CMPINT64 (log.first_document[1], ==, (int64_t) 1);
+   ASSERT_CMPINT (log.n_documents[1], ==, 2);
+   ASSERT (!log.failed[1]);
+   ASSERT_CMPINT64 (log.first_document[2], ==, (int64_t) 3);
+   ASSERT (log.failed[2]);
+   ASSERT_CMPINT64 (log.first_document[3], ==, (int64_t) 5);
+   ASSERT_CMPINT (log.n_documents[3], ==, 1);
+
+   /* the error was reset by the flush */
+   ASSERT_OR_PRINT (mongoc_bulk_writer_flush (writer, &error), error);
+
+   mongoc_bulk_writer_destroy (writer);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+void
+test_bulk_writer_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/BulkWriter/interval", test_bulk_writer_interval);
+   TestSuite_Add (suite, "/BulkWriter/batch_size",
+                  test_bulk_writer_batch_size);
+}
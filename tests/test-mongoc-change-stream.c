@@ -0,0 +1,232 @@
+#include <mongoc.h>
+
+#include "mongoc-change-stream-private.h"
+
+#include "TestSuite.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+#include "mock_server/future.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "change-stream-test"
+
+
+/* resume tokens are tracked across batches, and after a network error the
+ * stream resumes from the last change it returned */
+static void
+test_change_stream_resume (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_change_stream_t *stream;
+   future_t *future;
+   request_t *request;
+   const bson_t *doc;
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   stream = mongoc_collection_watch (
+      collection,
+      tmp_bson ("{'pipeline': [{'$match': {'x': 1}}]}"),
+      tmp_bson ("{'batchSize': 10, 'maxAwaitTimeMS': 500}"));
+
+   ASSERT (!mongoc_change_stream_get_resume_token (stream));
+
+   /* an empty first batch is followed by an awaitData getMore */
+   future = future_change_stream_next (stream, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'aggregate': 'coll',"
+      " 'pipeline': [{'$changeStream': {'resumeAfter': {'$exists': false}}},"
+      "              {'$match': {'x': 1}}],"
+      " 'cursor': {'batchSize': 10}}");
+
+   mock_server_replies_simple (request, "{'ok': 1,"
+                                        " 'cursor': {"
+                                        "    'id': {'$numberLong': '123'},"
+                                        "    'ns': 'db.coll',"
+                                        "    'firstBatch': []}}");
+   request_destroy (request);
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'getMore': {'$numberLong': '123'},"
+      " 'collection': 'coll',"
+      " 'maxTimeMS': 500}");
+
+   mock_server_replies_simple (request, "{'ok': 1,"
+                                        " 'cursor': {"
+                                        "    'id': {'$numberLong': '123'},"
+                                        "    'ns': 'db.coll',"
+                                        "    'nextBatch': ["
+                                        "       {'_id': {'token': 1}, 'x': 1}"
+                                        "]}}");
+
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': {'token': 1}, 'x': 1}");
+   ASSERT_MATCH (mongoc_change_stream_get_resume_token (stream),
+                 "{'token': 1}");
+
+   future_destroy (future);
+   request_destroy (request);
+
+   /* no new changes within maxAwaitTimeMS: no document, no error */
+   future = future_change_stream_next (stream, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'getMore': {'$numberLong': '123'}, 'collection': 'coll'}");
+
+   mock_server_replies_simple (request, "{'ok': 1,"
+                                        " 'cursor': {"
+                                        "    'id': {'$numberLong': '123'},"
+                                        "    'ns': 'db.coll',"
+                                        "    'nextBatch': []}}");
+
+   ASSERT (!future_get_bool (future));
+   ASSERT (!mongoc_change_stream_error (stream, &error));
+
+   future_destroy (future);
+   request_destroy (request);
+
+   /* network error, then resume after token 1 */
+   future = future_change_stream_next (stream, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'getMore': {'$numberLong': '123'}, 'collection': 'coll'}");
+
+   mock_server_hangs_up (request);
+   request_destroy (request);
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'aggregate': 'coll',"
+      " 'pipeline': [{'$changeStream': {'resumeAfter': {'token': 1}}},"
+      "              {'$match': {'x': 1}}]}");
+
+   mock_server_replies_simple (request, "{'ok': 1,"
+                                        " 'cursor': {"
+                                        "    'id': {'$numberLong': '456'},"
+                                        "    'ns': 'db.coll',"
+                                        "    'firstBatch': ["
+                                        "       {'_id': {'token': 2}, 'x': 1}"
+                                        "]}}");
+
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'_id': {'token': 2}}");
+   ASSERT_MATCH (mongoc_change_stream_get_resume_token (stream),
+                 "{'token': 2}");
+
+   future_destroy (future);
+   request_destroy (request);
+
+   /* destroying the stream kills cursor 456 */
+   future = future_change_stream_destroy (stream);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'killCursors': 'coll'}");
+
+   mock_server_replies_simple (request, "{'ok': 1}");
+   future_wait (future);
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_change_stream_missing_token (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_change_stream_t *stream;
+   future_t *future;
+   request_t *request;
+   const bson_t *doc;
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   /* a projection removed _id, so the stream can't be resumed */
+   stream = mongoc_collection_watch (
+      collection, tmp_bson ("[{'$project': {'_id': 0}}]"), NULL);
+
+   future = future_change_stream_next (stream, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'aggregate': 'coll',"
+      " 'pipeline': [{'$changeStream': {}}, {'$project': {'_id': 0}}]}");
+
+   mock_server_replies_simple (request, "{'ok': 1,"
+                                        " 'cursor': {"
+                                        "    'id': {'$numberLong': '0'},"
+                                        "    'ns': 'db.coll',"
+                                        "    'firstBatch': [{'x': 1}]}}");
+
+   ASSERT (!future_get_bool (future));
+   ASSERT (!doc);
+   ASSERT (mongoc_change_stream_error (stream, &error));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CHANGE_STREAM_NO_RESUME_TOKEN,
+                          "resume token is missing");
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_change_stream_destroy (stream);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_change_stream_invalid_opt (void)
+{
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_change_stream_t *stream;
+   const bson_t *doc;
+   bson_error_t error;
+
+   client = mongoc_client_new ("mongodb://localhost");
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   /* no I/O */
+   stream = mongoc_collection_watch (collection, NULL,
+                                     tmp_bson ("{'foo': 1}"));
+
+   ASSERT (!mongoc_change_stream_next (stream, &doc));
+   ASSERT (mongoc_change_stream_error (stream, &error));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid change stream option \"foo\"");
+
+   mongoc_change_stream_destroy (stream);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+}
+
+
+void
+test_change_stream_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/ChangeStream/resume", test_change_stream_resume);
+   TestSuite_Add (suite, "/ChangeStream/missing_token",
+                  test_change_stream_missing_token);
+   TestSuite_Add (suite, "/ChangeStream/invalid_opt",
+                  test_change_stream_invalid_opt);
+}
@@ -4,7 +4,10 @@
 
 
 #include "TestSuite.h"
+#include "test-conveniences.h"
 #include "test-libmongoc.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
 
 
 static void
@@ -246,6 +249,115 @@ test_mongoc_client_pool_metadata (void)
 }
 #endif
 
+static void
+test_mongoc_client_pool_shared_connections (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   future_t *futures[2];
+   request_t *requests[2];
+   bson_t replies[2];
+   bson_error_t error;
+   char cmd[32];
+   int i;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   mongoc_client_pool_set_max_shared_connections (pool, 1);
+
+   for (i = 0; i < 2; i++) {
+      bson_snprintf (cmd, sizeof cmd, "{'ping': %d}", i);
+      futures[i] = future_client_pool_command_simple (pool, "admin",
+                                                      tmp_bson (cmd), NULL,
+                                                      &replies[i], &error);
+
+      requests[i] = mock_server_receives_command (
+         server, "admin", MONGOC_QUERY_SLAVE_OK, cmd);
+      assert (requests[i]);
+   }
+
+   /* both commands were written on the one shared connection */
+   ASSERT_CMPINT (request_get_client_port (requests[0]), ==,
+                  request_get_client_port (requests[1]));
+
+   /* replies out of order reach the right threads */
+   mock_server_replies_simple (requests[1], "{'ok': 1, 'n': 1}");
+   mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 0}");
+
+   for (i = 0; i < 2; i++) {
+      assert (future_get_bool (futures[i]));
+      bson_snprintf (cmd, sizeof cmd, "{'n': %d}", i);
+      ASSERT_MATCH (&replies[i], cmd);
+      bson_destroy (&replies[i]);
+      future_destroy (futures[i]);
+      request_destroy (requests[i]);
+   }
+
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+/* threads that start together don't open more connections than the limit */
+static void
+test_mongoc_client_pool_shared_connections_concurrent (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   future_t *futures[8];
+   request_t *requests[8];
+   bson_error_t errors[8];
+   uint16_t ports[8];
+   int n_ports = 0;
+   int i;
+   int j;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   mongoc_client_pool_set_max_shared_connections (pool, 2);
+
+   /* all threads race to connect before any request is answered */
+   for (i = 0; i < 8; i++) {
+      futures[i] = future_client_pool_command_simple (pool, "admin",
+                                                      tmp_bson ("{'ping': 1}"),
+                                                      NULL, NULL, &errors[i]);
+   }
+
+   for (i = 0; i < 8; i++) {
+      requests[i] = mock_server_receives_command (
+         server, "admin", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+      assert (requests[i]);
+
+      for (j = 0; j < n_ports; j++) {
+         if (ports[j] == request_get_client_port (requests[i])) {
+            break;
+         }
+      }
+
+      if (j == n_ports) {
+         ports[n_ports++] = request_get_client_port (requests[i]);
+      }
+   }
+
+   ASSERT_CMPINT (n_ports, <=, 2);
+
+   for (i = 0; i < 8; i++) {
+      mock_server_replies_simple (requests[i], "{'ok': 1}");
+   }
+
+   for (i = 0; i < 8; i++) {
+      ASSERT_OR_PRINT (future_get_bool (futures[i]), errors[i]);
+      future_destroy (futures[i]);
+      request_destroy (requests[i]);
+   }
+
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
 void
 test_client_pool_install (TestSuite *suite)
 {
@@ -255,6 +367,8 @@ test_client_pool_install (TestSuite *suite)
    TestSuite_Add (suite, "/ClientPool/min_size_dispose", test_mongoc_client_pool_min_size_dispose);
    TestSuite_Add (suite, "/ClientPool/set_max_size", test_mongoc_client_pool_set_max_size);
    TestSuite_Add (suite, "/ClientPool/set_min_size", test_mongoc_client_pool_set_min_size);
+   TestSuite_Add (suite, "/ClientPool/shared_connections", test_mongoc_client_pool_shared_connections);
+   TestSuite_Add (suite, "/ClientPool/shared_connections/concurrent", test_mongoc_client_pool_shared_connections_concurrent);
 
 #ifdef MONGOC_EXPERIMENTAL_FEATURES
    TestSuite_Add (suite, "/ClientPool/metadata", test_mongoc_client_pool_metadata);
@@ -575,6 +575,98 @@ test_command_read_prefs_single (void)
 }
 
 
+static void
+test_command_scatter (void)
+{
+   const char *mongos_ismaster = "{'ok': 1, 'ismaster': true,"
+                                 " 'msg': 'isdbgrid', 'maxWireVersion': 3}";
+   mock_server_t *servers[2];
+   char *uri_str;
+   mongoc_client_t *client;
+   uint32_t server_ids[] = { 2, 1 };
+   bson_t reply;
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[2];
+   int i;
+
+   for (i = 0; i < 2; i++) {
+      servers[i] = mock_server_new ();
+      mock_server_auto_ismaster (servers[i], mongos_ismaster);
+      mock_server_run (servers[i]);
+   }
+
+   uri_str = bson_strdup_printf ("mongodb://%s,%s",
+                                 mock_server_get_host_and_port (servers[0]),
+                                 mock_server_get_host_and_port (servers[1]));
+
+   client = mongoc_client_new (uri_str);
+
+   /* both mongoses match the default read preference */
+   future = future_client_command_scatter (client, "admin",
+                                           tmp_bson ("{'serverStatus': 1}"),
+                                           NULL, NULL, 0, &reply, &error);
+
+   /* both servers have the command before either replies */
+   for (i = 0; i < 2; i++) {
+      requests[i] = mock_server_receives_command (
+         servers[i], "admin", MONGOC_QUERY_SLAVE_OK, "{'serverStatus': 1}");
+   }
+
+   mock_server_replies_simple (requests[1], "{'ok': 1, 'n': 1}");
+   mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 0}");
+
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   ASSERT_MATCH (&reply, "{'replies': [{'serverId': 1, 'reply': {'n': 0}},"
+                         "             {'serverId': 2, 'reply': {'n': 1}}]}");
+
+   future_destroy (future);
+   bson_destroy (&reply);
+
+   for (i = 0; i < 2; i++) {
+      request_destroy (requests[i]);
+   }
+
+   /* explicit server ids, in the caller's order; one server fails */
+   future = future_client_command_scatter (client, "admin",
+                                           tmp_bson ("{'serverStatus': 1}"),
+                                           NULL, server_ids, 2, &reply,
+                                           &error);
+
+   for (i = 0; i < 2; i++) {
+      requests[i] = mock_server_receives_command (
+         servers[i], "admin", MONGOC_QUERY_SLAVE_OK, "{'serverStatus': 1}");
+   }
+
+   mock_server_replies_simple (requests[0], "{'ok': 1}");
+   mock_server_replies_simple (requests[1],
+                               "{'ok': 0, 'code': 2, 'errmsg': 'bad'}");
+
+   assert (!future_get_bool (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_QUERY, 2, "bad");
+   ASSERT_MATCH (&reply, "{'replies': [{'serverId': 2,"
+                         "              'reply': {'ok': 0},"
+                         "              'error': {'code': 2}},"
+                         "             {'serverId': 1,"
+                         "              'reply': {'ok': 1},"
+                         "              'error': {'$exists': false}}]}");
+
+   future_destroy (future);
+   bson_destroy (&reply);
+
+   for (i = 0; i < 2; i++) {
+      request_destroy (requests[i]);
+   }
+
+   mongoc_client_destroy (client);
+   bson_free (uri_str);
+
+   for (i = 0; i < 2; i++) {
+      mock_server_destroy (servers[i]);
+   }
+}
+
+
 static void
 test_command_read_prefs_pooled (void)
 {
@@ -2011,6 +2103,7 @@ test_client_install (TestSuite *suite)
                   test_client_cmd_write_concern);
    TestSuite_Add (suite, "/Client/command/read_prefs/simple/single", test_command_simple_read_prefs_single);
    TestSuite_Add (suite, "/Client/command/read_prefs/simple/pooled", test_command_simple_read_prefs_pooled);
+   TestSuite_Add (suite, "/Client/command/scatter", test_command_scatter);
    TestSuite_Add (suite, "/Client/command/read_prefs/single", test_command_read_prefs_single);
    TestSuite_Add (suite, "/Client/command/read_prefs/pooled", test_command_read_prefs_pooled);
    TestSuite_AddLive (suite, "/Client/command_not_found/cursor", test_command_not_found);
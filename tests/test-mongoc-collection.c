@@ -4,6 +4,7 @@
 #include <mongoc-cursor-private.h>
 #include <mongoc-collection-private.h>
 #include <mongoc-write-concern-private.h>
+#include <mongoc-util-private.h>
 
 #include "TestSuite.h"
 
@@ -340,6 +341,199 @@ test_legacy_insert_oversize_mongos (void)
 }
 
 
+/* with a write buffer, legacy w:0 writes are held until the buffer fills, a
+ * command goes to the same server, or the application flushes. w:0 writes
+ * to a server with write commands are sent as legacy writes too, as long as
+ * its minWireVersion is 0, so they are buffered the same way */
+static void
+_test_insert_unacknowledged_buffer (int32_t max_wire_version)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_write_concern_t *wc;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   char json[32];
+   int i;
+
+   server = mock_server_with_autoismaster (max_wire_version);
+   mock_server_set_request_timeout_msec (server, 100);
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   mongoc_client_set_unacknowledged_write_buffer (client, 1024 * 1024);
+   collection = mongoc_client_get_collection (client, "test", "test");
+   wc = mongoc_write_concern_new ();
+   mongoc_write_concern_set_w (wc, 0);
+
+   for (i = 0; i < 3; i++) {
+      bson_snprintf (json, sizeof json, "{'_id': %d}", i);
+      ASSERT_OR_PRINT (mongoc_collection_insert (collection,
+                                                 MONGOC_INSERT_NONE,
+                                                 tmp_bson (json),
+                                                 wc, &error), error);
+   }
+
+   /* nothing sent yet */
+   ASSERT (!mock_server_receives_request (server));
+
+   ASSERT_OR_PRINT (mongoc_client_flush_unacknowledged_writes (client, &error),
+                    error);
+
+   for (i = 0; i < 3; i++) {
+      bson_snprintf (json, sizeof json, "{'_id': %d}", i);
+      request = mock_server_receives_insert (server, "test.test",
+                                             MONGOC_INSERT_NONE, json);
+      ASSERT (request);
+      request_destroy (request);
+   }
+
+   /* a command to the server sends buffered writes first */
+   ASSERT_OR_PRINT (mongoc_collection_insert (collection, MONGOC_INSERT_NONE,
+                                              tmp_bson ("{'_id': 3}"),
+                                              wc, &error), error);
+
+   future = future_client_command_simple (client, "admin",
+                                          tmp_bson ("{'ping': 1}"),
+                                          NULL, NULL, &error);
+
+   request = mock_server_receives_insert (server, "test.test",
+                                          MONGOC_INSERT_NONE, "{'_id': 3}");
+   ASSERT (request);
+   request_destroy (request);
+   request = mock_server_receives_command (server, "admin",
+                                           MONGOC_QUERY_SLAVE_OK,
+                                           "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   request_destroy (request);
+   future_destroy (future);
+
+   /* so does a command scattered to the server */
+   ASSERT_OR_PRINT (mongoc_collection_insert (collection, MONGOC_INSERT_NONE,
+                                              tmp_bson ("{'_id': 5}"),
+                                              wc, &error), error);
+
+   future = future_client_command_scatter (client, "admin",
+                                           tmp_bson ("{'ping': 1}"),
+                                           NULL, NULL, 0, NULL, &error);
+
+   request = mock_server_receives_insert (server, "test.test",
+                                          MONGOC_INSERT_NONE, "{'_id': 5}");
+   ASSERT (request);
+   request_destroy (request);
+   request = mock_server_receives_command (server, "admin",
+                                           MONGOC_QUERY_SLAVE_OK,
+                                           "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   request_destroy (request);
+   future_destroy (future);
+
+   /* a write that fills the buffer is sent at once */
+   mongoc_client_set_unacknowledged_write_buffer (client, 1);
+   ASSERT_OR_PRINT (mongoc_collection_insert (collection, MONGOC_INSERT_NONE,
+                                              tmp_bson ("{'_id': 4}"),
+                                              wc, &error), error);
+
+   request = mock_server_receives_insert (server, "test.test",
+                                          MONGOC_INSERT_NONE, "{'_id': 4}");
+   ASSERT (request);
+   request_destroy (request);
+
+   mongoc_write_concern_destroy (wc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_legacy_insert_unacknowledged_buffer (void)
+{
+   _test_insert_unacknowledged_buffer (0);
+}
+
+
+static void
+test_insert_unacknowledged_buffer_write_cmd (void)
+{
+   _test_insert_unacknowledged_buffer (WIRE_VERSION_WRITE_CMD);
+}
+
+
+/* concurrent inserts from pooled clients are combined into one command, and
+ * each caller gets its own document's outcome */
+static void
+test_insert_write_combining (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *clients[2];
+   mongoc_collection_t *collections[2];
+   future_t *futures[2];
+   bson_error_t errors[2];
+   request_t *request;
+   int32_t failed_id;
+   char json[32];
+   int i;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   mongoc_client_pool_set_write_combining (pool, 500 * 1000);
+
+   for (i = 0; i < 2; i++) {
+      clients[i] = mongoc_client_pool_pop (pool);
+      collections[i] = mongoc_client_get_collection (clients[i], "db",
+                                                     "collection");
+      bson_snprintf (json, sizeof json, "{'_id': %d}", i);
+      futures[i] = future_collection_insert (collections[i],
+                                             MONGOC_INSERT_NONE,
+                                             tmp_bson (json),
+                                             NULL, &errors[i]);
+   }
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_NONE,
+      "{'insert': 'collection', 'ordered': false}");
+
+   ASSERT (request);
+
+   /* the second document in the command fails, whoever sent it */
+   failed_id = bson_lookup_int32 (request_get_doc (request, 0),
+                                  "documents.1._id");
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'n': 1,"
+      " 'writeErrors': [{'index': 1, 'code': 11000, 'errmsg': 'dupe'}]}");
+
+   for (i = 0; i < 2; i++) {
+      if (i == failed_id) {
+         ASSERT (!future_get_bool (futures[i]));
+         ASSERT_ERROR_CONTAINS (errors[i], MONGOC_ERROR_COMMAND, 11000,
+                                "dupe");
+         ASSERT_MATCH (mongoc_collection_get_last_error (collections[i]),
+                       "{'nInserted': 0, 'writeErrors': [{'index': 0}]}");
+      } else {
+         ASSERT_OR_PRINT (future_get_bool (futures[i]), errors[i]);
+         ASSERT_MATCH (mongoc_collection_get_last_error (collections[i]),
+                       "{'nInserted': 1}");
+      }
+
+      future_destroy (futures[i]);
+      mongoc_collection_destroy (collections[i]);
+      mongoc_client_pool_push (pool, clients[i]);
+   }
+
+   request_destroy (request);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_insert_bulk (void)
 {
@@ -2007,6 +2201,82 @@ test_count_with_opts (void)
 }
 
 
+/* identical counts from pooled clients share one round trip */
+static void
+test_count_read_coalescing (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *clients[2];
+   mongoc_collection_t *collections[2];
+   future_t *futures[2];
+   bson_error_t errors[2];
+   request_t *request;
+   int i;
+
+   server = mock_server_with_autoismaster (3);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   mongoc_client_pool_set_read_coalescing (pool, true);
+
+   for (i = 0; i < 2; i++) {
+      clients[i] = mongoc_client_pool_pop (pool);
+      collections[i] = mongoc_client_get_collection (clients[i], "db",
+                                                     "collection");
+   }
+
+   futures[0] = future_collection_count (collections[0], MONGOC_QUERY_NONE,
+                                         tmp_bson ("{'x': 1}"), 0, 0, NULL,
+                                         &errors[0]);
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'count': 'collection', 'query': {'x': 1}}");
+
+   ASSERT (request);
+
+   futures[1] = future_collection_count (collections[1], MONGOC_QUERY_NONE,
+                                         tmp_bson ("{'x': 1}"), 0, 0, NULL,
+                                         &errors[1]);
+
+   /* hold the reply until the second count waits for it */
+   while (!_mongoc_single_flight_waiters (clients[1]->single_flight)) {
+      _mongoc_usleep (1000);
+   }
+
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 42}");
+
+   for (i = 0; i < 2; i++) {
+      ASSERT_OR_PRINT (42 == future_get_int64_t (futures[i]), errors[i]);
+      future_destroy (futures[i]);
+   }
+
+   /* a count after the reply is sent anew */
+   futures[0] = future_collection_count (collections[0], MONGOC_QUERY_NONE,
+                                         tmp_bson ("{'x': 1}"), 0, 0, NULL,
+                                         &errors[0]);
+
+   request_destroy (request);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'count': 'collection', 'query': {'x': 1}}");
+
+   ASSERT (request);
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 43}");
+   ASSERT_OR_PRINT (43 == future_get_int64_t (futures[0]), errors[0]);
+   future_destroy (futures[0]);
+
+   for (i = 0; i < 2; i++) {
+      mongoc_collection_destroy (collections[i]);
+      mongoc_client_pool_push (pool, clients[i]);
+   }
+
+   request_destroy (request);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_drop (void)
 {
@@ -3505,6 +3775,12 @@ test_collection_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/Collection/read_prefs_is_valid",
                       test_read_prefs_is_valid);
    TestSuite_AddLive (suite, "/Collection/insert_bulk", test_insert_bulk);
+   TestSuite_Add (suite, "/Collection/insert/unacknowledged_buffer/legacy",
+                  test_legacy_insert_unacknowledged_buffer);
+   TestSuite_Add (suite, "/Collection/insert/unacknowledged_buffer/write_cmd",
+                  test_insert_unacknowledged_buffer_write_cmd);
+   TestSuite_Add (suite, "/Collection/insert/write_combining",
+                  test_insert_write_combining);
    TestSuite_AddLive (suite,
                   "/Collection/insert_bulk_empty",
                   test_insert_bulk_empty);
@@ -3553,6 +3829,7 @@ test_collection_install (TestSuite *suite)
    TestSuite_Add (suite, "/Collection/count_with_opts", test_count_with_opts);
    TestSuite_Add (suite, "/Collection/count/read_pref", test_count_read_pref);
    TestSuite_Add (suite, "/Collection/count/read_concern", test_count_read_concern);
+   TestSuite_Add (suite, "/Collection/count/read_coalescing", test_count_read_coalescing);
    TestSuite_AddFull (suite, "/Collection/count/read_concern_live", test_count_read_concern_live, NULL, NULL, mongod_supports_majority_read_concern);
    TestSuite_AddLive (suite, "/Collection/drop", test_drop);
    TestSuite_AddLive (suite, "/Collection/aggregate", test_aggregate);
@@ -8,6 +8,7 @@
 #include "mock_server/future-functions.h"
 #include "mongoc-cursor-private.h"
 #include "mongoc-collection-private.h"
+#include "mongoc-thread-private.h"
 #include "test-conveniences.h"
 
 
@@ -397,6 +398,157 @@ test_kill_cursors_pooled_cmd (void)
 }
 
 
+static void
+_open_and_abandon_cursor (mock_server_t       *server,
+                          mongoc_collection_t *collection,
+                          int64_t              cursor_id)
+{
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+   char *reply;
+
+   cursor = mongoc_collection_find (collection, MONGOC_QUERY_NONE, 0, 0, 0,
+                                    tmp_bson ("{}"), NULL, NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK,
+      "{'find': 'collection', 'filter': {}}");
+
+   reply = bson_strdup_printf ("{'ok': 1,"
+                               " 'cursor': {"
+                               "    'id': {'$numberLong': '%" PRId64 "'},"
+                               "    'ns': 'db.collection',"
+                               "    'firstBatch': [{}]}}",
+                               cursor_id);
+
+   mock_server_replies_simple (request, reply);
+
+   ASSERT (future_get_bool (future));
+
+   /* queued, not killed: no network I/O */
+   mongoc_cursor_destroy (cursor);
+
+   bson_free (reply);
+   future_destroy (future);
+   request_destroy (request);
+}
+
+
+/* destroyed cursors are killed together, by the next operation after the
+ * threshold is reached */
+static void
+test_kill_cursors_deferred (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   const char *ns_out;
+   int64_t id0;
+   int64_t id1;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_deferred_kill_cursors (client, 0, 2));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   /* the second find isn't preceded by killCursors, one cursor is queued */
+   _open_and_abandon_cursor (server, collection, 123);
+   _open_and_abandon_cursor (server, collection, 456);
+
+   future = future_client_command_simple (client, "admin",
+                                          tmp_bson ("{'ping': 1}"),
+                                          NULL, NULL, &error);
+
+   request = mock_server_receives_command (server, "db", MONGOC_QUERY_SLAVE_OK,
+                                           "{'killCursors': 'collection'}");
+
+   ASSERT (BCON_EXTRACT ((bson_t *) request_get_doc (request, 0),
+                         "killCursors", BCONE_UTF8 (ns_out),
+                         "cursors", "[",
+                         BCONE_INT64 (id0), BCONE_INT64 (id1),
+                         "]"));
+
+   ASSERT_CMPSTR ("collection", ns_out);
+   ASSERT_CMPINT64 ((int64_t) 123, ==, id0);
+   ASSERT_CMPINT64 ((int64_t) 456, ==, id1);
+
+   mock_server_replies_simple (request, "{'ok': 1}");
+   request_destroy (request);
+
+   request = mock_server_receives_command (server, "admin",
+                                           MONGOC_QUERY_SLAVE_OK,
+                                           "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void *
+_destroy_pool (void *data)
+{
+   mongoc_client_pool_destroy ((mongoc_client_pool_t *) data);
+
+   return NULL;
+}
+
+
+/* a pool's final flush connects, if it must, to kill cursors that another of
+ * its clients queued */
+static void
+test_kill_cursors_deferred_pool_destroy (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_client_t *idle;
+   mongoc_collection_t *collection;
+   mongoc_thread_t thread;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   mongoc_client_pool_set_deferred_kill_cursors (pool, 0, 10);
+   client = mongoc_client_pool_pop (pool);
+   idle = mongoc_client_pool_pop (pool);
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   /* below the threshold, so neither push kills it */
+   _open_and_abandon_cursor (server, collection, 123);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+
+   /* the client that never connected is the one the pool flushes with */
+   mongoc_client_pool_push (pool, idle);
+
+   ASSERT (!mongoc_thread_create (&thread, _destroy_pool, pool));
+
+   request = mock_server_receives_command (server, "db", MONGOC_QUERY_SLAVE_OK,
+                                           "{'killCursors': 'collection',"
+                                           " 'cursors': [123]}");
+
+   ASSERT (request);
+   mock_server_replies_simple (request, "{'ok': 1}");
+   request_destroy (request);
+
+   ASSERT (!mongoc_thread_join (thread));
+   mock_server_destroy (server);
+}
+
+
 static void
 _test_getmore_fail (bool has_primary,
                     bool pooled)
@@ -913,6 +1065,108 @@ test_tailable_alive (void)
 }
 
 
+typedef struct
+{
+   mongoc_stream_t vtable;
+   uint8_t        *data;
+   size_t          len;
+   int             n_writev;
+} capture_stream_t;
+
+
+static ssize_t
+capture_stream_writev (mongoc_stream_t *stream,
+                       mongoc_iovec_t  *iov,
+                       size_t           iovcnt,
+                       int32_t          timeout_msec)
+{
+   capture_stream_t *cstream = (capture_stream_t *) stream;
+   ssize_t n = 0;
+   size_t i;
+
+   cstream->n_writev++;
+
+   for (i = 0; i < iovcnt; i++) {
+      cstream->data = bson_realloc (cstream->data,
+                                    cstream->len + iov[i].iov_len);
+      memcpy (cstream->data + cstream->len, iov[i].iov_base, iov[i].iov_len);
+      cstream->len += iov[i].iov_len;
+      n += iov[i].iov_len;
+   }
+
+   return n;
+}
+
+
+static void
+capture_stream_destroy (mongoc_stream_t *stream)
+{
+   bson_free (((capture_stream_t *) stream)->data);
+   bson_free (stream);
+}
+
+
+static void
+test_dump_to_stream (void)
+{
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   capture_stream_t *stream;
+   bson_reader_t *reader;
+   const bson_t *doc;
+   bson_t b;
+   bson_error_t error;
+   bool eof = false;
+   int i;
+   bool r;
+
+   client = test_framework_client_new ();
+   collection = get_test_collection (client, "test_dump_to_stream");
+
+   for (i = 0; i < 10; i++) {
+      bson_init (&b);
+      BSON_APPEND_INT32 (&b, "_id", i);
+      r = mongoc_collection_insert (collection, MONGOC_INSERT_NONE, &b,
+                                    NULL, &error);
+      bson_destroy (&b);
+      ASSERT_OR_PRINT (r, error);
+   }
+
+   stream = (capture_stream_t *) bson_malloc0 (sizeof *stream);
+   stream->vtable.type = 999;
+   stream->vtable.writev = capture_stream_writev;
+   stream->vtable.destroy = capture_stream_destroy;
+
+   /* batches of 3, 3, 3 and 1 documents */
+   cursor = mongoc_collection_find (collection, MONGOC_QUERY_NONE, 0, 0, 3,
+                                    tmp_bson ("{}"), NULL, NULL);
+
+   r = mongoc_cursor_dump_to_stream (cursor, (mongoc_stream_t *) stream,
+                                     &error);
+   ASSERT_OR_PRINT (r, error);
+   ASSERT_CMPINT (stream->n_writev, ==, 4);
+   ASSERT (!mongoc_cursor_is_alive (cursor));
+
+   reader = bson_reader_new_from_data (stream->data, stream->len);
+   i = 0;
+   while ((doc = bson_reader_read (reader, &eof))) {
+      ASSERT_MATCH (doc, "{'_id': %d}", i);
+      i++;
+   }
+
+   ASSERT (eof);
+   ASSERT_CMPINT (i, ==, 10);
+
+   bson_reader_destroy (reader);
+   mongoc_cursor_destroy (cursor);
+   mongoc_stream_destroy ((mongoc_stream_t *) stream);
+   ASSERT_OR_PRINT (mongoc_collection_drop (collection, &error), error);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+}
+
+
 void
 test_cursor_install (TestSuite *suite)
 {
@@ -925,6 +1179,9 @@ test_cursor_install (TestSuite *suite)
    TestSuite_Add (suite, "/Cursor/kill/pooled", test_kill_cursors_pooled);
    TestSuite_Add (suite, "/Cursor/kill/single/cmd", test_kill_cursors_single_cmd);
    TestSuite_Add (suite, "/Cursor/kill/pooled/cmd", test_kill_cursors_pooled_cmd);
+   TestSuite_Add (suite, "/Cursor/kill/deferred", test_kill_cursors_deferred);
+   TestSuite_Add (suite, "/Cursor/kill/deferred/pool_destroy",
+                  test_kill_cursors_deferred_pool_destroy);
    TestSuite_Add (suite, "/Cursor/getmore_fail/with_primary/pooled",
                   test_getmore_fail_with_primary_pooled);
    TestSuite_Add (suite, "/Cursor/getmore_fail/with_primary/single",
@@ -962,4 +1219,5 @@ test_cursor_install (TestSuite *suite)
    TestSuite_Add (suite, "/Cursor/hint/pooled/secondary", test_hint_pooled_secondary);
    TestSuite_Add (suite, "/Cursor/hint/pooled/primary", test_hint_pooled_primary);
    TestSuite_AddLive (suite, "/Cursor/tailable/alive", test_tailable_alive);
+   TestSuite_AddLive (suite, "/Cursor/dump_to_stream", test_dump_to_stream);
 }
@@ -196,6 +196,17 @@ test_exhaust_cursor (bool pooled)
       assert (error.code == MONGOC_ERROR_CLIENT_IN_EXHAUST);
    }
 
+   /* and commands scattered to servers */
+   {
+      r = mongoc_client_command_scatter (client, "admin",
+                                         tmp_bson ("{'ping': 1}"), NULL,
+                                         NULL, 0, NULL, &error);
+
+      assert (!r);
+      assert (error.domain == MONGOC_ERROR_CLIENT);
+      assert (error.code == MONGOC_ERROR_CLIENT_IN_EXHAUST);
+   }
+
    /* we're still in exhaust.
     *
     * 1. check that we can create a new cursor, as long as we don't read from it
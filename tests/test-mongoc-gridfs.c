@@ -316,6 +316,73 @@ test_create_from_stream (void)
 }
 
 
+/* a local file is ingested from where its stream's offset is, whole */
+static void
+test_create_from_file_stream (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_stream_t *stream;
+   mongoc_client_t *client;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   FILE *fp;
+   char *expected;
+   char *buf;
+   char skipped[100];
+   long len;
+   ssize_t r;
+
+   fp = fopen (BINARY_DIR"/gridfs-large.dat", "rb");
+   ASSERT (fp);
+   ASSERT_CMPINT (fseek (fp, 0, SEEK_END), ==, 0);
+   len = ftell (fp);
+   ASSERT_CMPINT (fseek (fp, 0, SEEK_SET), ==, 0);
+   expected = (char *) bson_malloc ((size_t) len);
+   ASSERT_CMPSIZE_T (fread (expected, 1, (size_t) len, fp), ==, (size_t) len);
+   fclose (fp);
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "from_file_stream",
+                                              &error), error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   stream = mongoc_stream_file_new_for_path (BINARY_DIR"/gridfs-large.dat",
+                                             O_RDONLY, 0);
+   ASSERT_OR_PRINT_ERRNO (stream, errno);
+
+   /* start past the beginning */
+   ASSERT_CMPSSIZE_T (mongoc_stream_read (stream, skipped, sizeof skipped,
+                                          sizeof skipped, 0), ==,
+                      (ssize_t) sizeof skipped);
+
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file_from_stream (gridfs, stream, &opt);
+   ASSERT (file);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==,
+                    (int64_t) (len - sizeof skipped));
+
+   buf = (char *) bson_malloc ((size_t) len);
+   iov.iov_base = buf;
+   iov.iov_len = (size_t) len;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, (size_t) len, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) (len - sizeof skipped));
+   ASSERT (memcmp (expected + sizeof skipped, buf, (size_t) r) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   bson_free (buf);
+   bson_free (expected);
+   mongoc_client_destroy (client);
+}
+
+
 static void
 test_seek (void)
 {
@@ -513,6 +580,674 @@ test_write (void)
    mongoc_client_destroy (client);
 }
 
+/* chunks written and read on several connections, with a window of chunks in
+ * flight, arrive intact and in order */
+static void
+test_parallel (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_client_t *client;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[10000];
+   char buf2[10000];
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "parallel", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "parallel";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   mongoc_gridfs_file_set_parallel (file, 2, 4);
+
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf);
+   ASSERT (mongoc_gridfs_file_save (file));
+   mongoc_gridfs_file_destroy (file);
+
+   ASSERT_CMPINT64 (mongoc_collection_count (mongoc_gridfs_get_chunks (gridfs),
+                                             MONGOC_QUERY_NONE, NULL, 0, 0,
+                                             NULL, &error), ==, (int64_t) 10);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "parallel", &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==,
+                    (int64_t) sizeof buf);
+   mongoc_gridfs_file_set_parallel (file, 2, 4);
+
+   iov.iov_base = buf2;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf, buf2, sizeof buf) == 0);
+
+   /* seeking back drops the window and fetches again */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 2500, SEEK_SET), ==, 0);
+   iov.iov_len = 3000;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 3000, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 3000);
+   ASSERT (memcmp (buf + 2500, buf2, 3000) == 0);
+
+   /* turning parallel transfer off mid-chunk keeps reading the same bytes */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 1200, SEEK_SET), ==, 0);
+   iov.iov_len = 300;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 300, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 300);
+   ASSERT (memcmp (buf + 1200, buf2, 300) == 0);
+
+   mongoc_gridfs_file_set_parallel (file, 0, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 300, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 300);
+   ASSERT (memcmp (buf + 1500, buf2, 300) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+
+/* sequential reads fetch spans of chunks ahead; a seek starts over */
+static void
+test_read_ahead (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_stream_t *stream;
+   mongoc_client_t *client;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[10000];
+   char buf2[10000];
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "read_ahead", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "read_ahead";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf);
+   ASSERT (mongoc_gridfs_file_save (file));
+   mongoc_gridfs_file_destroy (file);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "read_ahead", &error);
+   ASSERT_OR_PRINT (file, error);
+   mongoc_gridfs_file_set_read_ahead (file, 3);
+
+   /* read through a stream, in pieces smaller than a chunk */
+   stream = mongoc_stream_gridfs_new (file);
+   for (i = 0; i < sizeof buf2; i += 300) {
+      r = mongoc_stream_read (stream, buf2 + i,
+                              BSON_MIN (300, sizeof buf2 - i), 1, 0);
+      ASSERT_CMPSSIZE_T (r, ==, (ssize_t) BSON_MIN (300, sizeof buf2 - i));
+   }
+
+   ASSERT (memcmp (buf, buf2, sizeof buf) == 0);
+
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 4500, SEEK_SET), ==, 0);
+   iov.iov_base = buf2;
+   iov.iov_len = 5500;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 5500, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 5500);
+   ASSERT (memcmp (buf + 4500, buf2, 5500) == 0);
+
+   /* turning read-ahead off mid-chunk keeps reading the same bytes */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 1200, SEEK_SET), ==, 0);
+   iov.iov_len = 300;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 300, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 300);
+   ASSERT (memcmp (buf + 1200, buf2, 300) == 0);
+
+   mongoc_gridfs_file_set_read_ahead (file, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 300, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 300);
+   ASSERT (memcmp (buf + 1500, buf2, 300) == 0);
+
+   mongoc_stream_destroy (stream);
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+
+typedef struct
+{
+   int inserts;
+   int updates;
+   int finds;
+} chunk_commands_t;
+
+
+static void
+count_chunk_commands_cb (const mongoc_apm_command_started_t *event)
+{
+   chunk_commands_t *writes;
+   const char *name;
+   bson_iter_t iter;
+
+   writes = (chunk_commands_t *) mongoc_apm_command_started_get_context (event);
+   name = mongoc_apm_command_started_get_command_name (event);
+
+   /* the command's first value is the collection name */
+   if (!bson_iter_init (&iter, mongoc_apm_command_started_get_command (event)) ||
+       !bson_iter_next (&iter) ||
+       !BSON_ITER_HOLDS_UTF8 (&iter) ||
+       !strstr (bson_iter_utf8 (&iter, NULL), ".chunks")) {
+      return;
+   }
+
+   if (!strcmp (name, "insert")) {
+      writes->inserts++;
+   } else if (!strcmp (name, "update")) {
+      writes->updates++;
+   } else if (!strcmp (name, "find")) {
+      writes->finds++;
+   }
+}
+
+
+/* new chunks are inserted together, rewritten chunks upserted one by one */
+static void
+test_batch_chunks (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   chunk_commands_t writes = { 0 };
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[10000];
+   char buf2[10000];
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "batch_chunks", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, count_chunk_commands_cb);
+   mongoc_client_set_apm_callbacks (client, callbacks, &writes);
+
+   opt.filename = "batch_chunks";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   /* whole chunks and partial chunks through the page */
+   iov.iov_base = buf;
+   iov.iov_len = 2500;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 2500);
+   iov.iov_base = buf + 2500;
+   iov.iov_len = 7500;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 7500);
+
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT_CMPINT (writes.inserts, ==, 1);
+   ASSERT_CMPINT (writes.updates, ==, 0);
+
+   /* a rewrite replaces the stored chunk */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 4500, SEEK_SET), ==, 0);
+   iov.iov_base = buf2;
+   iov.iov_len = 10;
+   memset (buf2, 'x', iov.iov_len);
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, &iov, 1, 0), ==,
+                      (ssize_t) 10);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT_CMPINT (writes.inserts, ==, 1);
+   ASSERT_CMPINT (writes.updates, ==, 1);
+
+   mongoc_gridfs_file_destroy (file);
+   mongoc_client_set_apm_callbacks (client, NULL, NULL);
+
+   ASSERT_CMPINT64 (mongoc_collection_count (mongoc_gridfs_get_chunks (gridfs),
+                                             MONGOC_QUERY_NONE, NULL, 0, 0,
+                                             NULL, &error), ==, (int64_t) 10);
+
+   memset (buf + 4500, 'x', 10);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "batch_chunks", &error);
+   ASSERT_OR_PRINT (file, error);
+
+   iov.iov_base = buf2;
+   iov.iov_len = sizeof buf2;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf, buf2, sizeof buf) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+
+   /* removing a file drops the chunks it hasn't inserted yet */
+   mongoc_client_set_apm_callbacks (client, callbacks, &writes);
+   opt.filename = "batch_chunks_removed";
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   iov.iov_base = buf;
+   iov.iov_len = 2500;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 2500);
+   ASSERT_OR_PRINT (mongoc_gridfs_file_remove (file, &error), error);
+   ASSERT_CMPINT (writes.inserts, ==, 1);
+   mongoc_gridfs_file_destroy (file);
+   mongoc_client_set_apm_callbacks (client, NULL, NULL);
+
+   /* destroying an unsaved file saves it with its batched chunks */
+   ASSERT_OR_PRINT (mongoc_gridfs_drop (gridfs, &error), error);
+   opt.filename = "batch_chunks_destroyed";
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   iov.iov_base = buf;
+   iov.iov_len = 2000;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 2000);
+   mongoc_gridfs_file_destroy (file);
+
+   ASSERT_CMPINT64 (mongoc_collection_count (mongoc_gridfs_get_chunks (gridfs),
+                                             MONGOC_QUERY_NONE, NULL, 0, 0,
+                                             NULL, &error), ==, (int64_t) 2);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "batch_chunks_destroyed",
+                                              &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==, (int64_t) 2000);
+   mongoc_gridfs_file_destroy (file);
+
+   /* a partial last chunk is stored too, so the length can be read back */
+   ASSERT_OR_PRINT (mongoc_gridfs_drop (gridfs, &error), error);
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   iov.iov_base = buf;
+   iov.iov_len = 2500;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 2500);
+   mongoc_gridfs_file_destroy (file);
+
+   ASSERT_CMPINT64 (mongoc_collection_count (mongoc_gridfs_get_chunks (gridfs),
+                                             MONGOC_QUERY_NONE, NULL, 0, 0,
+                                             NULL, &error), ==, (int64_t) 3);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "batch_chunks_destroyed",
+                                              &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==, (int64_t) 2500);
+
+   iov.iov_base = buf2;
+   iov.iov_len = 2500;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 2500, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 2500);
+   ASSERT (memcmp (buf, buf2, 2500) == 0);
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_apm_callbacks_destroy (callbacks);
+   mongoc_client_destroy (client);
+}
+
+/* an upload written in order gets the md5 of its bytes, a rewrite drops it */
+static void
+test_computed_md5 (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_t *saved;
+   mongoc_client_t *client;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov[2];
+   char buf[2500];
+   bson_md5_t md5;
+   uint8_t digest[16];
+   char expected[33];
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   bson_md5_init (&md5);
+   bson_md5_append (&md5, (const uint8_t *) buf, sizeof buf);
+   bson_md5_finish (&md5, digest);
+
+   for (i = 0; i < sizeof digest; i++) {
+      bson_snprintf (&expected[i * 2], 3, "%02x", digest[i]);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "computed_md5", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "computed_md5";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   iov[0].iov_base = buf;
+   iov[0].iov_len = 700;
+   iov[1].iov_base = buf + 700;
+   iov[1].iov_len = 1000;
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, iov, 2, 0), ==,
+                      (ssize_t) 1700);
+   iov[0].iov_base = buf + 1700;
+   iov[0].iov_len = 800;
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, iov, 1, 0), ==,
+                      (ssize_t) 800);
+   ASSERT (mongoc_gridfs_file_save (file));
+
+   saved = mongoc_gridfs_find_one_by_filename (gridfs, "computed_md5", &error);
+   ASSERT_OR_PRINT (saved, error);
+   ASSERT_CMPSTR (expected, mongoc_gridfs_file_get_md5 (saved));
+   mongoc_gridfs_file_destroy (saved);
+
+   /* the bytes no longer match the digest */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 0, SEEK_SET), ==, 0);
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, iov, 1, 0), ==,
+                      (ssize_t) 800);
+   ASSERT (mongoc_gridfs_file_save (file));
+   mongoc_gridfs_file_destroy (file);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "computed_md5", &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT (!mongoc_gridfs_file_get_md5 (file));
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+
+/* a read after a seek fetches its span in one query, and cached chunks are
+ * read again without one */
+static void
+test_chunk_cache (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   chunk_commands_t commands = { 0 };
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[5000];
+   char buf2[1000];
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "chunk_cache", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "chunk_cache";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf);
+   ASSERT (mongoc_gridfs_file_save (file));
+   mongoc_gridfs_file_destroy (file);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "chunk_cache", &error);
+   ASSERT_OR_PRINT (file, error);
+   mongoc_gridfs_file_set_chunk_cache (file, 4);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, count_chunk_commands_cb);
+   mongoc_client_set_apm_callbacks (client, callbacks, &commands);
+
+   /* bytes 2500 to 3500 span chunks 2 and 3 */
+   iov.iov_base = buf2;
+   iov.iov_len = sizeof buf2;
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 2500, SEEK_SET), ==, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf + 2500, buf2, sizeof buf2) == 0);
+   ASSERT_CMPINT (commands.finds, ==, 1);
+
+   /* the same range again comes from the cache */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 0, SEEK_SET), ==, 0);
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 2500, SEEK_SET), ==, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf + 2500, buf2, sizeof buf2) == 0);
+   ASSERT_CMPINT (commands.finds, ==, 1);
+
+   /* chunk 0 wasn't read yet */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 100, SEEK_SET), ==, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf + 100, buf2, sizeof buf2) == 0);
+   ASSERT_CMPINT (commands.finds, ==, 2);
+
+   mongoc_client_set_apm_callbacks (client, NULL, NULL);
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_apm_callbacks_destroy (callbacks);
+   mongoc_client_destroy (client);
+}
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+/* chunks are stored compressed, and read back as the bytes written */
+static void
+test_compression (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_client_t *client;
+   mongoc_cursor_t *cursor;
+   const bson_t *chunk;
+   bson_iter_t iter;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[5000];
+   char buf2[5000];
+   const uint8_t *data;
+   uint32_t len;
+   int n_chunks = 0;
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = "log line\n"[i % 9];
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "compression", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "compression";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   ASSERT (!mongoc_gridfs_file_set_compression (file, "lzma", -1, &error));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Unsupported compressor");
+   ASSERT_OR_PRINT (mongoc_gridfs_file_set_compression (file, "zlib", -1,
+                                                         &error), error);
+
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+   r = mongoc_gridfs_file_writev (file, &iov, 1, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf);
+   ASSERT (mongoc_gridfs_file_save (file));
+
+   ASSERT (!mongoc_gridfs_file_set_compression (file, NULL, -1, &error));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_GRIDFS,
+                          MONGOC_ERROR_GRIDFS_PROTOCOL_ERROR,
+                          "Cannot change the compression");
+   mongoc_gridfs_file_destroy (file);
+
+   cursor = mongoc_collection_find (mongoc_gridfs_get_chunks (gridfs),
+                                    MONGOC_QUERY_NONE, 0, 0, 0,
+                                    tmp_bson ("{}"), NULL, NULL);
+
+   while (mongoc_cursor_next (cursor, &chunk)) {
+      ASSERT (bson_iter_init_find (&iter, chunk, "data"));
+      bson_iter_binary (&iter, NULL, &len, &data);
+      ASSERT_CMPUINT32 (len, <, (uint32_t) 1000);
+      n_chunks++;
+   }
+
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+   ASSERT_CMPINT (n_chunks, ==, 5);
+   mongoc_cursor_destroy (cursor);
+
+   /* length and seeks count uncompressed bytes */
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "compression", &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==,
+                    (int64_t) sizeof buf);
+
+   iov.iov_base = buf2;
+   iov.iov_len = sizeof buf2;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf2, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) sizeof buf2);
+   ASSERT (memcmp (buf, buf2, sizeof buf) == 0);
+
+   iov.iov_len = 1000;
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 2500, SEEK_SET), ==, 0);
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 1000, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 1000);
+   ASSERT (memcmp (buf + 2500, buf2, 1000) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+#endif
+
+/* whole chunks written straight from the caller's buffer land in the same
+ * chunks, next to chunks written through a page */
+static void
+test_write_whole_chunks (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_client_t *client;
+   bson_error_t error;
+   mongoc_gridfs_file_opt_t opt = { 0 };
+   mongoc_iovec_t iov;
+   char buf[5000];
+   char buf2[5000];
+   char expected[5000];
+   ssize_t r;
+   size_t i;
+
+   for (i = 0; i < sizeof buf; i++) {
+      buf[i] = (char) (i % 251);
+   }
+
+   client = test_framework_client_new ();
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "whole_chunks", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   opt.filename = "whole_chunks";
+   opt.chunk_size = 1000;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   /* a partial chunk, then 3 whole chunks from an unaligned start */
+   iov.iov_base = buf;
+   iov.iov_len = 10;
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, &iov, 1, 0), ==,
+                      (ssize_t) 10);
+   iov.iov_base = buf + 10;
+   iov.iov_len = 3990;
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, &iov, 1, 0), ==,
+                      (ssize_t) 3990);
+
+   /* overwrite chunk 1 and half of chunk 2 */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 1000, SEEK_SET), ==, 0);
+   iov.iov_base = buf2;
+   iov.iov_len = 1500;
+   memset (buf2, 'x', iov.iov_len);
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_writev (file, &iov, 1, 0), ==,
+                      (ssize_t) 1500);
+
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (file), ==, (int64_t) 4000);
+   mongoc_gridfs_file_destroy (file);
+
+   ASSERT_CMPINT64 (mongoc_collection_count (mongoc_gridfs_get_chunks (gridfs),
+                                             MONGOC_QUERY_NONE, NULL, 0, 0,
+                                             NULL, &error), ==, (int64_t) 4);
+
+   memcpy (expected, buf, 4000);
+   memset (expected + 1000, 'x', 1500);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "whole_chunks", &error);
+   ASSERT_OR_PRINT (file, error);
+
+   iov.iov_base = buf2;
+   iov.iov_len = sizeof buf2;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, 4000, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 4000);
+   ASSERT (memcmp (expected, buf2, 4000) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+
 static void
 test_empty (void)
 {
@@ -976,6 +1711,8 @@ test_gridfs_install (TestSuite *suite)
 {
    TestSuite_AddLive (suite, "/GridFS/create", test_create);
    TestSuite_AddLive (suite, "/GridFS/create_from_stream", test_create_from_stream);
+   TestSuite_AddLive (suite, "/GridFS/create_from_file_stream",
+                      test_create_from_file_stream);
    TestSuite_AddLive (suite, "/GridFS/list", test_list);
    TestSuite_AddLive (suite, "/GridFS/properties", test_properties);
    TestSuite_AddLive (suite, "/GridFS/empty", test_empty);
@@ -984,6 +1721,16 @@ test_gridfs_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/GridFS/stream", test_stream);
    TestSuite_AddLive (suite, "/GridFS/remove", test_remove);
    TestSuite_AddLive (suite, "/GridFS/write", test_write);
+   TestSuite_AddLive (suite, "/GridFS/parallel", test_parallel);
+   TestSuite_AddLive (suite, "/GridFS/read_ahead", test_read_ahead);
+   TestSuite_AddLive (suite, "/GridFS/write_whole_chunks",
+                      test_write_whole_chunks);
+   TestSuite_AddLive (suite, "/GridFS/batch_chunks", test_batch_chunks);
+   TestSuite_AddLive (suite, "/GridFS/computed_md5", test_computed_md5);
+   TestSuite_AddLive (suite, "/GridFS/chunk_cache", test_chunk_cache);
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   TestSuite_AddLive (suite, "/GridFS/compression", test_compression);
+#endif
    TestSuite_AddFull (suite, "/GridFS/test_long_seek", test_long_seek, NULL, NULL, test_framework_skip_if_slow);
    TestSuite_AddLive (suite, "/GridFS/remove_by_filename", test_remove_by_filename);
    TestSuite_AddFull (suite, "/GridFS/missing_chunk", test_missing_chunk, NULL, NULL, test_framework_skip_if_slow);
@@ -285,6 +285,171 @@ test_mongoc_matcher_logic_ops (void)
 }
 
 
+/* the compiled program agrees with the optree it was compiled from */
+static void
+test_mongoc_matcher_compiled (void)
+{
+   logic_op_test_t tests[] = {
+         {"{\"a.b\": 1}", "{\"a\": {\"b\": 1}}", true},
+         {"{\"a.b\": 1}", "{\"a\": {\"b\": 2}}", false},
+         {"{\"a.b\": 1}", "{\"a\": 1}", false},
+         {"{\"a.1\": 5}", "{\"a\": [4, 5]}", true},
+         {"{\"a.b.c\": 1, \"a.d\": 2}", "{\"a\": {\"b\": {\"c\": 1}, \"d\": 2}}", true},
+         {"{\"a.b\": {\"$exists\": false}}", "{\"a\": {\"c\": 1}}", true},
+         {"{\"a.b\": {\"$exists\": true}}", "{\"b\": 1}", false},
+         {"{\"a.b\": {\"$type\": \"s\"}}", "{\"a\": {\"b\": \"x\"}}", true},
+         {"{\"a.b\": {\"$type\": \"s\"}}", "{\"a\": {\"b\": 1}}", false},
+         {"{\"$nor\": [{\"a\": 1}, {\"b\": 2}]}", "{\"a\": 3}", true},
+         {"{\"$nor\": [{\"a\": 1}, {\"b\": 2}]}", "{\"a\": 1}", false},
+         {"{\"$nor\": [{\"a\": 1}, {\"b\": 2}]}", "{\"b\": 2}", false},
+         {"{\"a\": {\"$not\": {\"$gt\": 5}}}", "{\"a\": 3}", true},
+         {"{\"a\": {\"$not\": {\"$gt\": 5}}}", "{\"a\": 7}", false},
+         {
+               "{\"x\": 1, \"$or\": [{\"a\": 1}, {\"$and\": [{\"b\": 2}, {\"c\": 3}]}]}",
+               "{\"c\": 3, \"b\": 2, \"x\": 1}",
+               true
+         },
+         {
+               "{\"x\": 1, \"$or\": [{\"a\": 1}, {\"$and\": [{\"b\": 2}, {\"c\": 3}]}]}",
+               "{\"c\": 4, \"b\": 2, \"x\": 1}",
+               false
+         },
+         {"{\"a\": 2}", "{\"a\": 2.0}", true},
+         {"{\"a\": {\"$gte\": 1.5}}", "{\"a\": 2}", true},
+         {"{\"a\": {\"$lt\": {\"$numberLong\": \"3\"}}}", "{\"a\": 2.5}", true},
+         {"{\"a\": {\"$lte\": {\"$numberLong\": \"3\"}}}", "{\"a\": 4}", false},
+         {"{\"a\": {\"$ne\": 1}}", "{\"a\": true}", false},
+         {"{\"a\": {\"$ne\": 1}}", "{\"a\": 2.5}", true},
+         {"{\"a\": {\"$in\": [1, 2]}}", "{\"a\": 2}", true},
+   };
+
+   int n_tests = sizeof tests / sizeof (logic_op_test_t);
+   int i;
+   logic_op_test_t test;
+   bson_t *spec;
+   bson_error_t error;
+   mongoc_matcher_t *matcher;
+   bson_t *doc;
+   char key[16];
+   bool r;
+
+   for (i = 0; i < n_tests; i++) {
+      test = tests[i];
+      spec = bson_new_from_json ((uint8_t * )test.spec, -1, &error);
+      BSON_ASSERT (spec);
+      matcher = mongoc_matcher_new (spec, &error);
+      BSON_ASSERT (matcher);
+      doc = bson_new_from_json ((uint8_t * )test.doc, -1, &error);
+      BSON_ASSERT (doc);
+
+      r = mongoc_matcher_match (matcher, doc);
+      if (test.match != r ||
+          r != _mongoc_matcher_op_match (matcher->optree, doc)) {
+         fprintf (stderr,
+                  "query:\n\n%s\n\nshould %shave matched:\n\n%s\n",
+                  test.match ? "" : "not ",
+                  test.spec, test.doc);
+         abort ();
+      }
+
+      mongoc_matcher_destroy (matcher);
+      bson_destroy (doc);
+      bson_destroy (spec);
+   }
+
+   /* more top-level fields than the program finds without allocating */
+   spec = bson_new ();
+   doc = bson_new ();
+
+   for (i = 0; i < 40; i++) {
+      bson_snprintf (key, sizeof key, "f%d", i);
+      BSON_APPEND_INT32 (spec, key, i);
+      BSON_APPEND_INT32 (doc, key, i);
+   }
+
+   matcher = mongoc_matcher_new (spec, &error);
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (matcher->program->n_fields == 40);
+   BSON_ASSERT (mongoc_matcher_match (matcher, doc));
+
+   BSON_APPEND_INT32 (spec, "f40", 40);
+   mongoc_matcher_destroy (matcher);
+   matcher = mongoc_matcher_new (spec, &error);
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (!mongoc_matcher_match (matcher, doc));
+
+   mongoc_matcher_destroy (matcher);
+   bson_destroy (doc);
+   bson_destroy (spec);
+}
+
+
+static void
+test_mongoc_matcher_match_many (void)
+{
+   const char *specs[] = {
+      "{\"a\": 2}",
+      "{\"a\": {\"$gt\": 1.5}}",
+      "{\"a\": {\"$ne\": {\"$numberLong\": \"2\"}}}",
+      "{\"a\": \"x\"}",
+      "{\"$or\": [{\"a\": 1}, {\"b.c\": 2}]}",
+   };
+   const char *jsons[] = {
+      "{\"a\": 2}",
+      "{\"a\": {\"$numberLong\": \"2\"}}",
+      "{\"a\": 2.0}",
+      "{\"a\": 1}",
+      "{\"a\": 1.25}",
+      "{\"a\": true}",
+      "{\"a\": \"x\"}",
+      "{\"b\": {\"c\": 2}}",
+      "{}",
+   };
+   const bson_t *docs[sizeof jsons / sizeof jsons[0]];
+   bool matched[sizeof jsons / sizeof jsons[0]];
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   bson_t *spec;
+   size_t i;
+   size_t j;
+
+   for (i = 0; i < sizeof jsons / sizeof jsons[0]; i++) {
+      docs[i] = bson_new_from_json ((uint8_t *)jsons[i], -1, &error);
+      BSON_ASSERT (docs[i]);
+   }
+
+   for (i = 0; i < sizeof specs / sizeof specs[0]; i++) {
+      spec = bson_new_from_json ((uint8_t *)specs[i], -1, &error);
+      BSON_ASSERT (spec);
+      matcher = mongoc_matcher_new (spec, &error);
+      BSON_ASSERT (matcher);
+
+      memset (matched, 0, sizeof matched);
+      mongoc_matcher_match_many (matcher, docs, sizeof jsons / sizeof jsons[0],
+                                 matched);
+
+      for (j = 0; j < sizeof jsons / sizeof jsons[0]; j++) {
+         if (matched[j] != _mongoc_matcher_op_match (matcher->optree,
+                                                     docs[j])) {
+            fprintf (stderr, "query:\n\n%s\n\nshould %shave matched:\n\n%s\n",
+                     specs[i], matched[j] ? "not " : "", jsons[j]);
+            abort ();
+         }
+      }
+
+      /* nothing to do */
+      mongoc_matcher_match_many (matcher, NULL, 0, NULL);
+
+      mongoc_matcher_destroy (matcher);
+      bson_destroy (spec);
+   }
+
+   for (i = 0; i < sizeof jsons / sizeof jsons[0]; i++) {
+      bson_destroy ((bson_t *)docs[i]);
+   }
+}
+
+
 static void
 test_mongoc_matcher_bad_spec (void)
 {
@@ -542,6 +707,8 @@ test_matcher_install (TestSuite *suite)
    TestSuite_Add (suite, "/Matcher/array", test_mongoc_matcher_array);
    TestSuite_Add (suite, "/Matcher/compare", test_mongoc_matcher_compare);
    TestSuite_Add (suite, "/Matcher/logic", test_mongoc_matcher_logic_ops);
+   TestSuite_Add (suite, "/Matcher/compiled", test_mongoc_matcher_compiled);
+   TestSuite_Add (suite, "/Matcher/match_many", test_mongoc_matcher_match_many);
    TestSuite_Add (suite, "/Matcher/bad_spec", test_mongoc_matcher_bad_spec);
    TestSuite_Add (suite, "/Matcher/eq/utf8", test_mongoc_matcher_eq_utf8);
    TestSuite_Add (suite, "/Matcher/eq/int32", test_mongoc_matcher_eq_int32);